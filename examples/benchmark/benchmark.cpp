@@ -0,0 +1,1262 @@
+
+/* 
+   This example measures the performance
+   of the library components.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <ftw.h>
+#include <sys/resource.h>
+
+#include "../../src/codeMap.h"
+
+//Minimum time (seconds) of each measure
+const double minTime = 1.0;
+
+//Allocation counters, updated only while 'countAllocs' is true
+bool countAllocs = false;
+unsigned long long nAllocs = 0;
+unsigned long long allocBytes = 0;
+std::size_t maxAlloc = 0;
+
+void* countedAlloc(std::size_t size)
+{
+  if(countAllocs)
+    {
+      nAllocs++;
+      allocBytes += size;
+      if(size > maxAlloc){maxAlloc = size;}
+    }
+  void* p = malloc(size > 0 ? size : 1);
+  if(p == 0){throw std::bad_alloc();}
+  return p;
+}
+
+void* operator new(std::size_t size)
+{
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+  free(p);
+}
+
+int benchScan(int nfiles, char** files)
+{
+  //Map all specified files
+  mapped_file* maps = new mapped_file[nfiles];
+  unsigned long long bytes = 0;
+  for(int i = 0; i < nfiles; i++)
+    {
+      if(maps[i].open(files[i]) != 0)
+	{
+	  printf("Error opening %s\n",files[i]);
+	  delete [] maps;
+	  return -1;
+	}
+      bytes += maps[i].size();
+    }
+  printf("Files: %d, size: %.2f MB\n", nfiles, bytes/1.0e6);
+
+  std::string out;
+  double scalarGBps = 0.0;
+  int best = setScanKernel(-1);
+  
+  for(int k = SCAN_SCALAR; k <= best; k++)
+    {
+      setScanKernel(k);
+
+      //Repeat until minimum time
+      int reps = 0;
+      double tstart = wallTime();
+      double elapsed = 0.0;
+      while(elapsed < minTime)
+	{
+	  for(int i = 0; i < nfiles; i++)
+	    {
+	      clearCode(maps[i].data(), maps[i].size(), out);
+	    }
+	  reps++;
+	  elapsed = wallTime()-tstart;
+	}
+
+      double GBps = ((double) bytes)*reps/(1.0e9*elapsed);
+      if(k == SCAN_SCALAR){scalarGBps = GBps;}
+      printf("%8s: %8.3f GB/s (x%.2f)\n", scanKernelName(k), GBps, GBps/scalarGBps);
+    }
+
+  //Extract the identifier before each '(' of the cleared codes
+  std::string* codes = new std::string[nfiles];
+  unsigned long long npars = 0;
+  for(int i = 0; i < nfiles; i++)
+    {
+      clearCode(maps[i].data(), maps[i].size(), codes[i]);
+      for(std::size_t pos = codes[i].find('('); pos != std::string::npos; pos = codes[i].find('(',pos+1))
+	{
+	  npars++;
+	}
+    }
+  printf("Identifiers before '(': %llu\n", npars);
+
+  double scalarRate = 0.0;
+  for(int k = SCAN_SCALAR; k <= best && k <= SCAN_SSE2; k++)
+    {
+      setScanKernel(k);
+      
+      int reps = 0;
+      std::size_t idChars = 0;
+      double tstart = wallTime();
+      double elapsed = 0.0;
+      while(elapsed < minTime)
+	{
+	  for(int i = 0; i < nfiles; i++)
+	    {
+	      const std::string& code = codes[i];
+	      for(std::size_t pos = code.find('('); pos != std::string::npos; pos = code.find('(',pos+1))
+		{
+		  std::size_t begin;
+		  idChars += identifierBefore(code, pos, begin);
+		}
+	    }
+	  reps++;
+	  elapsed = wallTime()-tstart;
+	}
+
+      double rate = ((double) npars)*reps/(1.0e6*elapsed);
+      if(k == SCAN_SCALAR){scalarRate = rate;}
+      printf("%8s: %8.2f M identifiers/s (x%.2f, %.1f chars each)\n", scanKernelName(k), rate,
+	     rate/scalarRate, npars > 0 ? (double) idChars/(npars*reps) : 0.0);
+    }
+  
+  setScanKernel(-1);
+  delete [] codes;
+  delete [] maps;
+  return 0;
+}
+
+int benchAlloc(int nfiles, char** files)
+{
+  //Count the allocations performed while the functions
+  //of each file are extracted from his parsed source
+  int errors = 0;
+  for(int i = 0; i < nfiles; i++)
+    {
+      parsed_source src;
+      if(src.load(files[i]) < 0)
+	{
+	  printf("Error opening %s\n",files[i]);
+	  return -1;
+	}
+
+      function_map* functions = new function_map[src.numSpans() > 0 ? src.numSpans() : 1];
+      
+      nAllocs = 0;
+      allocBytes = 0;
+      maxAlloc = 0;
+      countAllocs = true;
+      double tstart = wallTime();
+      for(int j = 0; j < src.numSpans(); j++)
+	{
+	  functions[j].loadFunction(src, j);
+	}
+      double elapsed = wallTime()-tstart;
+      countAllocs = false;
+
+      //No allocation may depend on the file size. Small files
+      //are smaller than fixed size blocks, so only allocations
+      //larger than the first arena chunk (4 KB) are checked
+      const std::size_t fixedSize = 4096;
+      bool fileSized = maxAlloc >= src.text().length() && maxAlloc > fixedSize;
+      if(fileSized){errors++;}
+      
+      printf("%s\n",files[i]);
+      printf("   functions: %d, text: %lu bytes, time: %.6f s\n",
+	     src.numSpans(), (unsigned long) src.text().length(), elapsed);
+      printf(" allocations: %llu (%llu bytes, largest %lu bytes) %s\n",
+	     nAllocs, allocBytes, (unsigned long) maxAlloc,
+	     fileSized ? "FILE SIZED" : "ok");
+      
+      delete [] functions;
+
+      //Start each file with an empty symbol table, so the
+      //table growth with previous names is not counted
+      symbol::reset();
+    }
+
+  return errors == 0 ? 0 : -2;
+}
+
+int benchIngest(int nfiles, char** files)
+{
+  //Serial reference map
+  source_map serial;
+  unsigned long long bytes = 0;
+  double tstart = wallTime();
+  for(int i = 0; i < nfiles; i++)
+    {
+      serial.appendSource(files[i]);
+    }
+  double serialTime = wallTime()-tstart;
+  bytes = serial.getStats().bytes;
+  serial.sort();
+  std::string reference = serial.to_string();
+  printf("Files: %d, size: %.2f MB\n", nfiles, bytes/1.0e6);
+  printf("  serial: %8.3f s %8.2f MB/s\n", serialTime, bytes/(1.0e6*serialTime));
+
+  //Concurrent maps
+  int maxThreads = (int) std::thread::hardware_concurrency();
+  if(maxThreads <= 0){maxThreads = 1;}
+  int errors = 0;
+  for(int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+      source_map map;
+      tstart = wallTime();
+      map.appendSources((const char**) files, nfiles, threads);
+      double elapsed = wallTime()-tstart;
+      map.sort();
+      bool same = map.to_string().compare(reference) == 0;
+      if(!same){errors++;}
+      printf("%8d: %8.3f s %8.2f MB/s (x%.2f) %s\n", threads, elapsed,
+	     bytes/(1.0e6*elapsed), serialTime/elapsed, same ? "ok" : "DIFFERENT");
+      if(threads < maxThreads && 2*threads > maxThreads){threads = maxThreads/2;}
+    }
+
+  return errors == 0 ? 0 : -2;
+}
+
+int benchRescan(int nfiles, char** files)
+{
+  //Full map
+  source_map map;
+  double tstart = wallTime();
+  map.appendSources((const char**) files, nfiles);
+  double fullTime = wallTime()-tstart;
+  printf("Files: %d, functions: %d\n", map.numFiles(), map.numF());
+  printf("    full map: %8.4f s\n", fullTime);
+
+  //Rescan without changes (size and modification time only)
+  tstart = wallTime();
+  int changed = map.rescan();
+  double rescanTime = wallTime()-tstart;
+  printf("      rescan: %8.4f s (%d changed files, x%.1f)\n", rescanTime, changed,
+	 rescanTime > 0.0 ? fullTime/rescanTime : 0.0);
+  
+  return 0;
+}
+
+int benchStream(int nfiles, char** files)
+{
+  const std::size_t window = 1 << 20;
+  char* buffer = new char[window];
+  int nwrong = 0;
+  printf("%10s %10s %10s %12s %10s %10s %6s\n","size (KB)","parse (s)","stream (s)","peak (KB)","functions","streamed","check");
+  for(int i = 0; i < nfiles; i++)
+    {
+      //Parse the whole file
+      parsed_source src;
+      double tstart = wallTime();
+      int nwhole = src.load(files[i]);
+      double wholeTime = wallTime()-tstart;
+
+      //Stream it in chunks
+      FILE* fin = fopen(files[i],"rb");
+      if(fin == 0){continue;}
+      source_stream stream;
+      file_map out;
+      int nstream = 0;
+      int nmissing = 0;
+      std::size_t n;
+      double streamTime = 0.0;
+      bool finished = false;
+      while(!finished)
+	{
+	  tstart = wallTime();
+	  n = fread(buffer, 1, window, fin);
+	  if(n > 0)
+	    {
+	      nstream += stream.feed(buffer, n, out);
+	    }
+	  else
+	    {
+	      nstream += stream.finish(out);
+	      finished = true;
+	    }
+	  streamTime += wallTime()-tstart;
+	  
+	  //Each streamed function must be found by the whole
+	  //parse, with the same namespaces and calls
+	  for(int j = 0; j < out.numF(); j++)
+	    {
+	      const function_map* f = out.getFunction(j);
+	      int k = src.find(f->getName().c_str(), f->overload());
+	      function_map whole;
+	      if(k < 0 || whole.loadFunction(src, k) < 0 || whole.to_string() != f->to_string()){nmissing++;}
+	    }
+	}
+      fclose(fin);
+
+      bool right = nmissing == 0 && nstream == nwhole;
+      if(!right){nwrong++;}
+      printf("%10llu %10.4f %10.4f %12lu %10d %10d %6s  %s\n", stream.bytes()/1024, wholeTime, streamTime,
+	     (unsigned long) stream.peakSize()/1024, nwhole, nstream, right ? "OK" : "WRONG", files[i]);
+    }
+  delete [] buffer;
+
+  if(nwrong > 0)
+    {
+      printf("%d files streamed with different functions\n", nwrong);
+      return -1;
+    }
+  return 0;
+}
+
+/// Memory used by a std::string with the text 'name'
+static std::size_t stringBytes(const std::string& name)
+{
+  return sizeof(std::string) + (name.length() > 15 ? name.length()+1 : 0);
+}
+
+int benchSymbols(int nfiles, char** files)
+{
+  //Map all files
+  source_map map;
+  double tstart = wallTime();
+  map.appendSources((const char**) files, nfiles);
+  double mapTime = wallTime()-tstart;
+
+  //Count name references stored by the functions
+  unsigned long long refs = 0;
+  unsigned long long asStrings = 0;
+  for(int i = 0; i < map.numF(); i++)
+    {
+      const function_map* f = map.getFunction(i);
+      refs += 2 + f->numNS() + f->numFC();
+      asStrings += stringBytes(f->getName()) + stringBytes(f->getSource());
+      for(int j = 0; j < f->numNS(); j++){asStrings += stringBytes(f->getNamespace(j));}
+      for(int j = 0; j < f->numFC(); j++){asStrings += stringBytes(f->getFName(j));}
+    }
+  unsigned long long asSymbols = refs*sizeof(symbol) + symbol::bytes();
+  
+  printf("Files: %d, functions: %d, map time: %.3f s\n", nfiles, map.numF(), mapTime);
+  printf("Name references: %llu, interned symbols: %u\n", refs, symbol::count());
+  printf("Names as strings: %10.2f MB\n", asStrings/1.0e6);
+  printf("Names as symbols: %10.2f MB (table %.2f MB)\n", asSymbols/1.0e6, symbol::bytes()/1.0e6);
+
+  //Name comparisons
+  tstart = wallTime();
+  int nleafs;
+  leaf* tree = 0;
+  map.tree(nleafs, tree);
+  printf("tree: %.3f s\n", wallTime()-tstart);
+  delete [] tree;
+
+  tstart = wallTime();
+  map.sort();
+  printf("sort: %.3f s\n", wallTime()-tstart);
+  return 0;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*)
+{
+  return remove(path);
+}
+
+/// Function that writes the function 'j' of the file 'i' of a generated corpus
+typedef void (*function_writer)(FILE* fout, int i, int j, int perFile, int nfunctions);
+
+/// Generated source files in a temporary directory
+struct corpus
+{
+  /// Temporary directory
+  std::string dir;
+  /// Path of each file
+  std::vector<std::string> paths;
+  /// Pointers to #paths strings, as received by appendSources
+  std::vector<const char*> cpaths;
+};
+
+/** \brief Write generated sources in a temporary directory
+ *  \param files -> Output corpus.
+ *  \param prefix -> Name of the temporary directory, after "/tmp/codeMap".
+ *  \param nfiles -> Number of files.
+ *  \param perFile -> Number of functions of each file.
+ *  \param writer -> Function that writes each function.
+ *  \return Return 0 on success or -1 if the files can't be written.
+ *
+ *  Files are named "f%06d.c". On error, the directory is removed.
+ */
+static int writeCorpus(corpus& files, const char* prefix, int nfiles, int perFile, function_writer writer)
+{
+  char dir[64];
+  snprintf(dir, sizeof(dir), "/tmp/codeMap%sXXXXXX", prefix);
+  if(mkdtemp(dir) == 0)
+    {
+      printf("Unable to create a temporary directory\n");
+      return -1;
+    }
+  files.dir.assign(dir);
+  files.paths.resize(nfiles);
+  files.cpaths.resize(nfiles);
+  for(int i = 0; i < nfiles; i++)
+    {
+      char filename[64];
+      sprintf(filename, "/f%06d.c", i);
+      files.paths[i] = files.dir + filename;
+      FILE* fout = fopen(files.paths[i].c_str(), "w");
+      if(fout == 0)
+	{
+	  printf("Unable to write %s\n", files.paths[i].c_str());
+	  nftw(dir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+	  return -1;
+	}
+      for(int j = 0; j < perFile; j++)
+	{
+	  writer(fout, i, j, perFile, nfiles*perFile);
+	}
+      fclose(fout);
+    }
+  for(int i = 0; i < nfiles; i++){files.cpaths[i] = files.paths[i].c_str();}
+  return 0;
+}
+
+/// Remove the directory of a generated corpus
+static void removeCorpus(corpus& files)
+{
+  if(!files.dir.empty())
+    {
+      nftw(files.dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+  files.dir.clear();
+}
+
+/// Write a function that calls two other functions and uses the 'io' namespace
+static void writeChained(FILE* fout, int i, int j, int perFile, int nfunctions)
+{
+  int id = i*perFile+j;
+  fprintf(fout, "int fun%d(int x)\n{\n  std::size_t n = x;\n  return io::read(n) + fun%d(x-1) + fun%d(x-2);\n}\n",
+	  id, (id+1) % nfunctions, (id+7) % nfunctions);
+}
+
+int benchCache(int nfiles, char** files)
+{
+  //Create an empty cache directory
+  char dir[] = "/tmp/codeMapCacheXXXXXX";
+  if(mkdtemp(dir) == 0)
+    {
+      printf("Unable to create a temporary directory\n");
+      return -1;
+    }
+  parse_cache cache;
+  cache.open(dir);
+
+  //Map without cache, with an empty cache and with a filled cache
+  const char* labels[] = {"no cache", "cold cache", "warm cache"};
+  std::string reference;
+  for(int run = 0; run < 3; run++)
+    {
+      source_map map;
+      if(run > 0){map.setCache(&cache);}
+      double tstart = wallTime();
+      map.appendSources((const char**) files, nfiles, 1);
+      double total = wallTime()-tstart;
+      const ingest_stats& stats = map.getStats();
+      printf("%12s: %8.4f s (parse %8.4f s, %lu/%lu cached files)",
+	     labels[run], total, stats.parseTime, stats.cachedFiles, stats.files);
+
+      map.sort();
+      if(run == 0){reference = map.to_string(); printf("\n");}
+      else{printf(" %s\n", map.to_string() == reference ? "IDENTICAL" : "DIFFERENT");}
+    }
+
+  //Remove the cache directory
+  nftw(dir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return 0;
+}
+
+/// Find a function with a linear scan, as getFunction did before the indexes
+static const function_map* scanFunction(const source_map& map, const std::string& name, const std::string& source, int overload)
+{
+  for(int i = 0; i < map.numF(); i++)
+    {
+      const function_map* f = map.getFunction(i);
+      if(f->name.compare(name) == 0 && f->sourceFile.compare(source) == 0 &&
+	 (overload <= 0 || f->overload() == overload))
+	{
+	  return f;
+	}
+    }
+  return 0;
+}
+
+/// Write a function with the same name in all files
+static void writeRepeated(FILE* fout, int i, int j, int perFile, int)
+{
+  fprintf(fout, "int fun%d(int x)\n{\n  return fun%d(x-1)+%d;\n}\n", j, (j+1) % perFile, i);
+}
+
+int benchLookup(int nsizes, char** sizes)
+{
+  //Each generated file defines the same 1000 functions
+  const int perFile = 1000;
+  const int nqueries = 1000;
+
+  printf("%10s %8s %14s %14s %10s\n","functions","files","scan (q/s)","index (q/s)","speedup");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+
+      //Write the sources in a temporary directory
+      corpus files;
+      if(writeCorpus(files, "Lookup", nfiles, perFile, writeRepeated) != 0)
+	{
+	  return -1;
+	}
+
+      source_map map;
+      map.appendSources(files.cpaths.data(), nfiles);
+      if(map.numF() == 0)
+	{
+	  printf("Unable to map the generated sources\n");
+	  removeCorpus(files);
+	  return -1;
+	}
+
+      //Query random functions
+      std::string* names = new std::string[nqueries];
+      std::string* sources = new std::string[nqueries];
+      int* overloads = new int[nqueries];
+      srand(7);
+      for(int q = 0; q < nqueries; q++)
+	{
+	  const function_map* f = map.getFunction(rand() % map.numF());
+	  names[q] = f->getName();
+	  sources[q] = f->getSource();
+	  overloads[q] = f->overload();
+	}
+
+      //Check that both methods find the same functions
+      bool identical = true;
+      for(int q = 0; q < 100 && q < nqueries; q++)
+	{
+	  if(map.getFunction(names[q].c_str(), sources[q].c_str(), overloads[q]) !=
+	     scanFunction(map, names[q], sources[q], overloads[q]))
+	    {
+	      identical = false;
+	    }
+	}
+      
+      //Measure the queries throughput of both methods
+      double rates[2];
+      for(int method = 0; method < 2; method++)
+	{
+	  long long done = 0;
+	  long long found = 0;
+	  double tstart = wallTime();
+	  double elapsed = 0.0;
+	  while(elapsed < minTime)
+	    {
+	      int q = done % nqueries;
+	      const function_map* f = method == 0 ?
+		scanFunction(map, names[q], sources[q], overloads[q]) :
+		map.getFunction(names[q].c_str(), sources[q].c_str(), overloads[q]);
+	      if(f != 0){found++;}
+	      done++;
+	      if(method == 0 || done % 16 == 0){elapsed = wallTime()-tstart;}
+	    }
+	  rates[method] = found/elapsed;
+	}
+      printf("%10d %8d %14.0f %14.0f %10.0f %s\n", map.numF(), nfiles, rates[0], rates[1],
+	     rates[1]/rates[0], identical ? "IDENTICAL" : "DIFFERENT");
+
+      delete [] names;
+      delete [] sources;
+      delete [] overloads;
+      removeCorpus(files);
+    }
+  return 0;
+}
+
+int benchDispatch(int nsizes, char** sizes)
+{
+  //Each handler is called twice by the dispatcher
+  printf("%10s %12s %12s %12s %10s\n","handlers","bytes","parse (s)","calls","counts");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nhandlers = atoi(sizes[isize]);
+      if(nhandlers <= 0){continue;}
+
+      //Write the handlers and the dispatcher in a temporary file
+      char path[] = "/tmp/codeMapDispatchXXXXXX";
+      int fd = mkstemp(path);
+      if(fd < 0)
+	{
+	  printf("Unable to create a temporary file\n");
+	  return -1;
+	}
+      FILE* fout = fdopen(fd, "w");
+      for(int i = 0; i < nhandlers; i++)
+	{
+	  fprintf(fout, "int handler%d(int x)\n{\n  return x+%d;\n}\n", i, i);
+	}
+      fprintf(fout, "int dispatch(int op, int x)\n{\n  switch(op)\n    {\n");
+      for(int i = 0; i < nhandlers; i++)
+	{
+	  fprintf(fout, "    case %d: return handler%d(x) + handler%d(x+1);\n", i, i, i);
+	}
+      fprintf(fout, "    }\n  return 0;\n}\n");
+      long bytes = ftell(fout);
+      fclose(fout);
+
+      source_map map;
+      double tstart = wallTime();
+      int err = map.appendSource(path);
+      double elapsed = wallTime()-tstart;
+      remove(path);
+      if(err != 0)
+	{
+	  printf("Unable to map the generated source (%d)\n", err);
+	  return -1;
+	}
+
+      //Check the calls of the dispatcher
+      const function_map* f = map.getFunction("dispatch", path, 0);
+      int ncalls = f == 0 ? 0 : f->numFC();
+      bool counts = ncalls == nhandlers;
+      for(int i = 0; i < ncalls; i++)
+	{
+	  if(f->getCall(i).calls != 2){counts = false;}
+	}
+      printf("%10d %12ld %12.4f %12d %10s\n", nhandlers, bytes, elapsed, ncalls,
+	     counts ? "OK" : "WRONG");
+    }
+  return 0;
+}
+
+/// Select the functions with a scan of the namespaces used by each function
+static int scanNamespaces(const source_map& map, const char** namesAnd, int nAnd,
+			  const char** namesNot, int nNot, std::string* outF)
+{
+  int n = 0;
+  for(int i = 0; i < map.numF(); i++)
+    {
+      const function_map* f = map.getFunction(i);
+      int found = 0;
+      bool excluded = false;
+      for(int j = 0; j < f->numNS(); j++)
+	{
+	  std::string ns = f->getNamespace(j);
+	  for(int k = 0; k < nAnd; k++){if(ns.compare(namesAnd[k]) == 0){found++;}}
+	  for(int k = 0; k < nNot; k++){if(ns.compare(namesNot[k]) == 0){excluded = true;}}
+	}
+      if(found == nAnd && !excluded){outF[n++] = f->getName();}
+    }
+  std::sort(outF, outF+n);
+  return n;
+}
+
+/// Write a function that uses 'std' (1/2), 'boost::asio' (1/3) and 'legacy' (1/5)
+static void writeNamespaces(FILE* fout, int i, int j, int perFile, int)
+{
+  int id = i*perFile+j;
+  fprintf(fout, "int fun%d(int x)\n{\n  return x", id);
+  if(id % 2 == 0){fprintf(fout, " + std::abs(x)");}
+  if(id % 3 == 0){fprintf(fout, " + boost::asio::post(x)");}
+  if(id % 5 == 0){fprintf(fout, " + legacy::call(x)");}
+  fprintf(fout, ";\n}\n");
+}
+
+int benchFilter(int nsizes, char** sizes)
+{
+  //Functions use 'std' (1/2), 'boost::asio' (1/3) and 'legacy' (1/5)
+  const int perFile = 1000;
+  const char* namesAnd[] = {"std", "boost", "asio"};
+  const char* namesNot[] = {"legacy"};
+
+  printf("%10s %10s %12s %12s %12s %10s\n","functions","selected","scan (ms)","bitmap (us)","names (ms)","memory");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+
+      //Write the sources in a temporary directory and map them
+      corpus files;
+      if(writeCorpus(files, "Filter", nfiles, perFile, writeNamespaces) != 0)
+	{
+	  return -1;
+	}
+      source_map map;
+      map.appendSources(files.cpaths.data(), nfiles);
+      removeCorpus(files);
+
+      //Scan all functions
+      std::string* scanF = new std::string[map.numF()+1];
+      double tstart = wallTime();
+      int nscan = scanNamespaces(map, namesAnd, 3, namesNot, 1, scanF);
+      double scanTime = wallTime()-tstart;
+      
+      //Combine the namespace bitmaps
+      id_bitmap selected;
+      long long done = 0;
+      tstart = wallTime();
+      double elapsed = 0.0;
+      while(elapsed < minTime)
+	{
+	  map.filterFunctions(namesAnd, 3, selected);
+	  map.excludeFunctions(namesNot, 1, selected);
+	  done++;
+	  elapsed = wallTime()-tstart;
+	}
+      double bitmapTime = elapsed/done;
+
+      //Resolve the selected names
+      std::string* outF = new std::string[map.numF()+1];
+      int nF = map.numF()+1;
+      tstart = wallTime();
+      map.selectedNames(selected, outF, nF);
+      double namesTime = wallTime()-tstart;
+
+      bool identical = nF == nscan;
+      for(int j = 0; identical && j < nF; j++)
+	{
+	  if(outF[j].compare(scanF[j]) != 0){identical = false;}
+	}
+
+      //Memory used by the bitmaps of the namespaces
+      std::size_t memory = 0;
+      for(int i = 0; i < map.numNS(); i++)
+	{
+	  memory += map.getNamespace(i)->functionSet().bytes();
+	}
+      
+      printf("%10d %10d %12.3f %12.2f %12.3f %7.2f MB %s\n", map.numF(), nF,
+	     1.0e3*scanTime, 1.0e6*bitmapTime, 1.0e3*namesTime, memory/1.0e6,
+	     identical ? "IDENTICAL" : "DIFFERENT");
+
+      delete [] scanF;
+      delete [] outF;
+    }
+  return 0;
+}
+
+/// Write a function that calls four functions
+static void writeCalls(FILE* fout, int i, int j, int perFile, int nfunctions)
+{
+  int id = i*perFile+j;
+  fprintf(fout, "int fun%d(int x)\n{\n  return x", id);
+  for(int k = 0; k < 4; k++)
+    {
+      fprintf(fout, " + fun%d(x-1)", (int) ((id+1+977LL*k*k) % nfunctions));
+    }
+  fprintf(fout, ";\n}\n");
+}
+
+int benchGraph(int nsizes, char** sizes)
+{
+  //Each function calls four functions
+  const int perFile = 1000;
+
+  printf("%10s %10s %10s %12s %12s %12s %12s\n","functions","links","graph (s)","graph (MB)","tree (s)","tree (MB)","check");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+      nfunctions = nfiles*perFile;
+
+      //Write the sources in a temporary directory and map them
+      corpus files;
+      if(writeCorpus(files, "Graph", nfiles, perFile, writeCalls) != 0)
+	{
+	  return -1;
+	}
+      source_map map;
+      map.appendSources(files.cpaths.data(), nfiles);
+      removeCorpus(files);
+
+      //Build the graph
+      dep_graph g;
+      double tstart = wallTime();
+      map.graph(g);
+      double graphTime = wallTime()-tstart;
+
+      //Build the leaf tree counting its allocations
+      int nleafs = 0;
+      leaf* tree = 0;
+      allocBytes = 0;
+      countAllocs = true;
+      tstart = wallTime();
+      map.tree(nleafs, tree);
+      double treeTime = wallTime()-tstart;
+      countAllocs = false;
+      
+      //Check that both have the same links
+      bool identical = nleafs == g.numNodes();
+      for(int i = 0; identical && i < nleafs; i++)
+	{
+	  if(tree[i].getNumLinks() != g.getNumLinks(i)){identical = false;}
+	  for(int j = 0; identical && j < g.getNumLinks(i); j++)
+	    {
+	      if(tree[i].getLink(j) != &tree[g.getLink(i,j)]){identical = false;}
+	    }
+	}
+      delete [] tree;
+
+      printf("%10d %10d %10.3f %12.2f %12.3f %12.2f %12s\n", g.numNodes(), g.numEdges(),
+	     graphTime, g.bytes()/1.0e6, treeTime, allocBytes/1.0e6,
+	     identical ? "IDENTICAL" : "DIFFERENT");
+    }
+  return 0;
+}
+
+int benchMemory(int nsizes, char** sizes)
+{
+  //Map generated sources counting the allocations performed
+  //by appendSources, sort and clear
+  const int perFile = 1000;
+
+  printf("%10s %12s %12s %12s %14s %10s %10s\n","functions","allocs","alloc (MB)","arena (MB)","peak RSS (MB)","map (s)","clear (s)");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+      nfunctions = nfiles*perFile;
+
+      //Write the sources in a temporary directory
+      corpus files;
+      if(writeCorpus(files, "Memory", nfiles, perFile, writeChained) != 0)
+	{
+	  return -1;
+	}
+      const char** cpaths = files.cpaths.data();
+
+      source_map map;
+      nAllocs = 0;
+      allocBytes = 0;
+      countAllocs = true;
+      double tstart = wallTime();
+      map.appendSources(cpaths, nfiles);
+      map.sort();
+      double mapTime = wallTime()-tstart;
+      countAllocs = false;
+      std::size_t arenaBytes = map.arenaBytes();
+
+      //Peak resident size of the whole process
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+
+      tstart = wallTime();
+      map.clear();
+      double clearTime = wallTime()-tstart;
+      
+      removeCorpus(files);
+
+      printf("%10d %12llu %12.2f %12.2f %14.2f %10.3f %10.3f\n", nfunctions,
+	     nAllocs, allocBytes/1.0e6, arenaBytes/1.0e6, usage.ru_maxrss/1.0e3,
+	     mapTime, clearTime);
+    }
+  return 0;
+}
+
+/// Write a function like #writeChained with a scrambled name
+static void writeScrambled(FILE* fout, int i, int j, int perFile, int nfunctions)
+{
+  int id = (int) ((i*perFile+j)*7919LL % nfunctions);
+  writeChained(fout, id/perFile, id%perFile, perFile, nfunctions);
+}
+
+int benchSort(int nsizes, char** sizes)
+{
+  //Sort maps of generated sources with scrambled function
+  //names, and arrays with a copy of their functions
+  const int perFile = 1000;
+
+  printf("%10s %14s %14s %12s\n","functions","map sort (s)","std::sort (s)","check");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+      nfunctions = nfiles*perFile;
+
+      //Write the sources in a temporary directory and map them
+      corpus files;
+      if(writeCorpus(files, "Sort", nfiles, perFile, writeScrambled) != 0)
+	{
+	  return -1;
+	}
+      source_map map;
+      map.appendSources(files.cpaths.data(), nfiles);
+      removeCorpus(files);
+
+      //Copy the unsorted functions
+      int n = map.numF();
+      function_map* array = new function_map[n > 0 ? n : 1];
+      for(int i = 0; i < n; i++){array[i] = *map.getFunction(i);}
+
+      double tstart = wallTime();
+      std::sort(array, array+n);
+      double arrayTime = wallTime()-tstart;
+      
+      tstart = wallTime();
+      map.sort();
+      double mapTime = wallTime()-tstart;
+
+      //Both must have the same order
+      bool identical = true;
+      for(int i = 0; identical && i < n; i++)
+	{
+	  const function_map* f = map.getFunction(i);
+	  if(f->name != array[i].name || f->sourceFile != array[i].sourceFile ||
+	     f->numFC() != array[i].numFC()){identical = false;}
+	}
+      delete [] array;
+      
+      printf("%10d %14.3f %14.3f %12s\n", n, mapTime, arrayTime,
+	     identical ? "IDENTICAL" : "DIFFERENT");
+    }
+  return 0;
+}
+
+int benchRemove(int nsizes, char** sizes)
+{
+  //Remove functions from generated maps one by one
+  //with removeF and in a batch with removeFunctions.
+  //Then remove functions whose names are also defined
+  //in the last file, so the name is kept by a distant
+  //function
+  const int perFile = 1000;
+  const int nsingle = 100;
+  const int nbatch = 1000;
+
+  printf("%10s %16s %16s %16s %12s\n","functions","removeF (ms)","batch (ms)","duplicate (ms)","check");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+      nfunctions = nfiles*perFile;
+      if(nfunctions < 2*(nsingle+nbatch)){continue;}
+
+      //Write the sources in a temporary directory
+      corpus files;
+      if(writeCorpus(files, "Remove", nfiles, perFile, writeChained) != 0)
+	{
+	  return -1;
+	}
+      const char** cpaths = files.cpaths.data();
+
+      //Define again, in the last file, the functions
+      //next to the ones removed one by one
+      std::string dupPath = files.dir + "/duplicates.c";
+      FILE* fout = fopen(dupPath.c_str(), "w");
+      if(fout == 0)
+	{
+	  printf("Unable to write %s\n", dupPath.c_str());
+	  removeCorpus(files);
+	  return -1;
+	}
+      std::vector<int> dupIds(nsingle);
+      for(int i = 0; i < nsingle; i++)
+	{
+	  dupIds[i] = (int) ((long long) i*nfunctions/(nsingle+nbatch))+1;
+	  fprintf(fout, "int fun%d(int x)\n{\n  return x;\n}\n", dupIds[i]);
+	}
+      fclose(fout);
+
+      source_map map;
+      map.appendSources(cpaths, nfiles);
+      map.appendSource(dupPath.c_str());
+
+      //Names of the functions to remove, spread over the map
+      int nremove = nsingle+nbatch;
+      std::string* names = new std::string[nremove];
+      const char** cnames = new const char*[nremove];
+      for(int i = 0; i < nremove; i++)
+	{
+	  char name[32];
+	  sprintf(name, "fun%d", (int) ((long long) i*nfunctions/nremove));
+	  names[i].assign(name);
+	  cnames[i] = names[i].c_str();
+	}
+
+      double tstart = wallTime();
+      for(int i = 0; i < nsingle; i++)
+	{
+	  map.removeF(cnames[i]);
+	}
+      double singleTime = wallTime()-tstart;
+
+      tstart = wallTime();
+      int nremoved = map.removeFunctions(cnames+nsingle, nbatch);
+      double batchTime = wallTime()-tstart;
+
+      //Remove the first definition of the duplicated names
+      std::vector<std::string> dupNames(nsingle);
+      int ndup = 0;
+      tstart = wallTime();
+      for(int i = 0; i < nsingle; i++)
+	{
+	  char name[32];
+	  sprintf(name, "fun%d", dupIds[i]);
+	  dupNames[i].assign(name);
+	  if(map.removeF(name, cpaths[dupIds[i]/perFile]) == 0){ndup++;}
+	}
+      double dupTime = wallTime()-tstart;
+
+      //Removed functions must not be found, and the
+      //duplicated names must keep the last definition
+      bool correct = nremoved == nbatch && ndup == nsingle && map.numF() == nfunctions-nremove;
+      for(int i = 0; correct && i < nremove; i++)
+	{
+	  if(map.getFunction(cnames[i]) != 0){correct = false;}
+	}
+      for(int i = 0; correct && i < nsingle; i++)
+	{
+	  const function_map* f = map.getFunction(dupNames[i].c_str());
+	  if(f == 0 || f->getSource() != dupPath){correct = false;}
+	}
+      removeCorpus(files);
+      delete [] cnames;
+      delete [] names;
+
+      printf("%10d %16.3f %16.3f %16.3f %12s\n", nfunctions,
+	     1000.0*singleTime/nsingle, 1000.0*batchTime, 1000.0*dupTime/nsingle, correct ? "OK" : "WRONG");
+    }
+  return 0;
+}
+
+int benchSource(int nsizes, char** sizes)
+{
+  //Remove files from generated maps calling removeF for
+  //each function of the file and with removeSource, and
+  //map files again with replaceSource. Then, map
+  //again the same file many times to check that the
+  //arena memory is reused
+  const int perFile = 100;
+  const int nloop = 5;
+  const int nremove = 50;
+  const int nreplace = 50;
+
+  printf("%10s %18s %18s %18s %23s %12s\n","functions","removeF (ms)","removeSource (ms)","replaceSource (ms)",
+	 "arena before/after (KB)","check");
+  for(int isize = 0; isize < nsizes; isize++)
+    {
+      int nfunctions = atoi(sizes[isize]);
+      if(nfunctions <= 0){continue;}
+      int nfiles = (nfunctions+perFile-1)/perFile;
+      nfunctions = nfiles*perFile;
+      if(nfiles < 2*(nloop+nremove+nreplace)){continue;}
+
+      //Write the sources in a temporary directory
+      corpus files;
+      if(writeCorpus(files, "Source", nfiles, perFile, writeChained) != 0)
+	{
+	  return -1;
+	}
+      const char** cpaths = files.cpaths.data();
+
+      source_map map;
+      map.appendSources(cpaths, nfiles);
+
+      //Files to process, spread over the map
+      int nselected = nloop+nremove+nreplace;
+      int* selected = new int[nselected];
+      for(int i = 0; i < nselected; i++)
+	{
+	  selected[i] = (int) ((long long) i*nfiles/nselected);
+	}
+
+      //Remove each function of the file
+      double tstart = wallTime();
+      for(int i = 0; i < nloop; i++)
+	{
+	  int file = selected[i];
+	  for(int j = 0; j < perFile; j++)
+	    {
+	      char name[32];
+	      sprintf(name, "fun%d", file*perFile+j);
+	      map.removeF(name, cpaths[file]);
+	    }
+	}
+      double loopTime = wallTime()-tstart;
+
+      //Remove the whole file
+      tstart = wallTime();
+      for(int i = nloop; i < nloop+nremove; i++)
+	{
+	  map.removeSource(cpaths[selected[i]]);
+	}
+      double removeTime = wallTime()-tstart;
+
+      //Map files again, the functions keep their positions
+      const function_map* first = map.getFunction(0);
+      std::string firstName = first->getName();
+      tstart = wallTime();
+      for(int i = nloop+nremove; i < nselected; i++)
+	{
+	  map.replaceSource(cpaths[selected[i]]);
+	}
+      double replaceTime = wallTime()-tstart;
+
+      //Replace the same file again and again. The memory of
+      //the replaced functions must be reused, so the arena
+      //must not grow with the number of replacements
+      int nrepeat = 4*nfiles;
+      std::size_t arenaBefore = map.arenaBytes();
+      for(int i = 0; i < nrepeat; i++)
+	{
+	  map.replaceSource(cpaths[selected[nselected-1]]);
+	}
+      std::size_t arenaAfter = map.arenaBytes();
+
+      //Removed functions must not be found and
+      //replaced ones must be in the same files
+      bool correct = map.numF() == nfunctions-(nloop+nremove)*perFile &&
+	map.numFiles() == nfiles-nremove && map.getFunction(0)->getName() == firstName &&
+	arenaAfter <= 2*arenaBefore;
+      for(int i = 0; correct && i < nselected; i++)
+	{
+	  char name[32];
+	  sprintf(name, "fun%d", selected[i]*perFile+perFile/2);
+	  const function_map* f = map.getFunction(name);
+	  if((f != 0) != (i >= nloop+nremove)){correct = false;}
+	  if(f != 0 && f->getSource() != files.paths[selected[i]]){correct = false;}
+	}
+      delete [] selected;
+      removeCorpus(files);
+
+      printf("%10d %18.3f %18.3f %18.3f %11zu/%-11zu %12s\n", nfunctions,
+	     1000.0*loopTime/nloop, 1000.0*removeTime/nremove,
+	     1000.0*replaceTime/nreplace, arenaBefore/1024, arenaAfter/1024,
+	     correct ? "OK" : "WRONG");
+    }
+  return 0;
+}
+
+int main (int argc, char** argv)
+{
+  if(argc < 3)
+    {
+      printf("Usage: %s benchmark path/to/file1 path/to/file2 ...\n",argv[0]);
+      printf("       %s lookup nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s dispatch nhandlers1 nhandlers2 ...\n",argv[0]);
+      printf("       %s filter nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s graph nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s memory nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s sort nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s remove nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("       %s source nfunctions1 nfunctions2 ...\n",argv[0]);
+      printf("Benchmarks: scan, alloc, ingest, rescan, cache, stream, symbols, lookup, dispatch, filter, graph, memory, sort, remove, source\n");
+      return 0;
+    }
+
+  std::string bench(argv[1]);
+  
+  if(bench.compare("scan") == 0)
+    {
+      return benchScan(argc-2, argv+2);
+    }
+
+  if(bench.compare("alloc") == 0)
+    {
+      return benchAlloc(argc-2, argv+2);
+    }
+
+  if(bench.compare("ingest") == 0)
+    {
+      return benchIngest(argc-2, argv+2);
+    }
+
+  if(bench.compare("rescan") == 0)
+    {
+      return benchRescan(argc-2, argv+2);
+    }
+
+  if(bench.compare("cache") == 0)
+    {
+      return benchCache(argc-2, argv+2);
+    }
+
+  if(bench.compare("stream") == 0)
+    {
+      return benchStream(argc-2, argv+2);
+    }
+
+  if(bench.compare("symbols") == 0)
+    {
+      return benchSymbols(argc-2, argv+2);
+    }
+
+  if(bench.compare("lookup") == 0)
+    {
+      return benchLookup(argc-2, argv+2);
+    }
+
+  if(bench.compare("dispatch") == 0)
+    {
+      return benchDispatch(argc-2, argv+2);
+    }
+
+  if(bench.compare("filter") == 0)
+    {
+      return benchFilter(argc-2, argv+2);
+    }
+
+  if(bench.compare("graph") == 0)
+    {
+      return benchGraph(argc-2, argv+2);
+    }
+
+  if(bench.compare("memory") == 0)
+    {
+      return benchMemory(argc-2, argv+2);
+    }
+
+  if(bench.compare("sort") == 0)
+    {
+      return benchSort(argc-2, argv+2);
+    }
+
+  if(bench.compare("remove") == 0)
+    {
+      return benchRemove(argc-2, argv+2);
+    }
+
+  if(bench.compare("source") == 0)
+    {
+      return benchSource(argc-2, argv+2);
+    }
+
+  printf("Unknown benchmark %s\n",argv[1]);
+  return -1;
+}
@@ -0,0 +1 @@
+g++ -O2 -o benchmark benchmark.cpp ../../src/codeMap.cpp -pthread -Wall -Wpedantic -Wshadow -Wextra
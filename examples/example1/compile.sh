@@ -1 +1 @@
-g++ -o example1 example1.cpp ../../src/codeMap.cpp -Wall -Wpedantic -Wshadow -Wextra
+g++ -o example1 example1.cpp ../../src/codeMap.cpp -pthread -Wall -Wpedantic -Wshadow -Wextra
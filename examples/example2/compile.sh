@@ -1 +1 @@
-g++ -o example2 example2.cpp ../../src/codeMap.cpp -lgvc -lcgraph -lcdt -Wall -Wpedantic -Wshadow -Wextra
+g++ -o example2 example2.cpp ../../src/codeMap.cpp -lgvc -lcgraph -lcdt -pthread -Wall -Wpedantic -Wshadow -Wextra
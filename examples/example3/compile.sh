@@ -1 +1 @@
-g++ -o example3 example3.cpp ../../src/codeMap.cpp -lgvc -lcgraph -lcdt -Wall -Wpedantic -Wshadow -Wextra
+g++ -o example3 example3.cpp ../../src/codeMap.cpp -lgvc -lcgraph -lcdt -pthread -Wall -Wpedantic -Wshadow -Wextra
@@ -21,20 +21,24 @@ int main (int argc, char** argv)
 
   source_map map;
 
-  //Append all specified source files
-  for(int i = 1; i < argc; i++)
+  //Append all specified source files concurrently
+  int nfiles = argc-1;
+  int* errors = new int[nfiles];
+  printf("Appending %d sources...\n",nfiles);
+  fflush(stdout);
+  map.appendSources((const char**) (argv+1), nfiles, 0, errors);
+  for(int i = 0; i < nfiles; i++)
     {
-      printf("Appending source %s...\n",argv[i]);
-      fflush(stdout);
-      int err = map.appendSource(argv[i]);
-      if(err != 0)
+      if(errors[i] != 0)
 	{
-	  printf("Error (%d) appending source %s.",err,argv[i]);
+	  printf("Error (%d) appending source %s.",errors[i],argv[i+1]);
+	  delete [] errors;
 	  return -1;
 	}
-      printf("Done!\n");
-      fflush(stdout);
     }
+  delete [] errors;
+  printf("Done!\n");
+  fflush(stdout);
 
   //Sort map alphabeticaly
   printf("Sorting...\n");
@@ -0,0 +1 @@
+g++ -o example4 example4.cpp ../../src/codeMap.cpp -pthread -Wall -Wpedantic -Wshadow -Wextra
@@ -0,0 +1,53 @@
+
+/* 
+   This example maps a directory tree and keeps
+   the map updated while the files are edited
+ */
+
+#include <stdio.h>
+#include <string>
+
+#include "../../src/codeMap.h"
+
+int main (int argc, char** argv)
+{
+  if(argc < 2)
+    {
+      printf("Usage: %s path/to/directory \n",argv[0]);
+      return 0;
+    }
+
+  source_map map;
+
+  //Map the directory tree
+  printf("Mapping %s...\n",argv[1]);
+  fflush(stdout);
+  int nfiles = map.appendDirectory(argv[1]);
+  if(nfiles < 0)
+    {
+      printf("Error (%d) opening directory %s\n",nfiles,argv[1]);
+      return -1;
+    }
+  printf("Done! %d files, %d functions\n",nfiles,map.numF());
+
+  //Watch the mapped tree
+  source_watch watch;
+  if(watch.start(map) < 0 || watch.addDirectory(argv[1]) < 0)
+    {
+      printf("Error starting the watch\n");
+      return -2;
+    }
+  printf("Watching %d directories. Edit some file (Ctrl+C to exit)...\n",watch.numDirs());
+  fflush(stdout);
+
+  //Print each update
+  watch_update info;
+  while(watch.poll(-1, &info) == 1)
+    {
+      printf("%d events, %d changed files: %d functions (latency %.1f ms, update %.1f ms)\n",
+	     info.events, info.changed, map.numF(), 1000.0*info.latency, 1000.0*info.updateTime);
+      fflush(stdout);
+    }
+  
+  return 0;
+}
@@ -19,910 +19,6282 @@
 */ 
 
 #include "codeMap.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <signal.h>
+#include <setjmp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define __CODE_MAP_X86__
+#endif
 
 //**************************//
-//      leaf functions      //
+//     symbol functions     //
 //**************************//
 
-leaf::leaf() : maxLinks(0), nLinks(0), overload(0)
+// Interned texts are distributed in shards, each one with its
+// own lock and open addressing table, so parsing threads can
+// intern names concurrently. The text of each id is stored in
+// chunks that are never moved, so ids are resolved without locks.
+// The chunk 'c' stores 2^c*256 ids, so a few chunks cover all ids.
+
+static const unsigned int symbolShardBits = 6;
+static const unsigned int symbolChunkBits = 8;
+static const unsigned int symbolMaxChunks = 32;
+
+/// Return the chunk of symbol 'id' and its position in the chunk
+static inline unsigned int symbolChunk(unsigned int id, unsigned int& offset)
 {
-  name.assign("****");
+  unsigned int x = (id >> symbolChunkBits) + 1;
+  unsigned int c = 31 - __builtin_clz(x);
+  offset = id - (((1u << c) - 1) << symbolChunkBits);
+  return c;
 }
 
-int leaf::connect(leaf* pleaf)
+struct symbol_shard
+{
+  std::mutex lock;
+  /// Interned ids plus one (0 marks an empty slot).
+  unsigned int* slots;
+  /// Hash of the text of each slot.
+  unsigned int* hashes;
+  /// Number of slots minus one.
+  unsigned int mask;
+  /// Number of used slots.
+  unsigned int used;
+};
+
+struct symbol_table
+{
+  symbol_shard shards[1u << symbolShardBits];
+  /// Chunks of text pointers, indexed by id.
+  std::atomic<const std::string**> chunks[symbolMaxChunks];
+  std::mutex chunksLock;
+  std::atomic<unsigned int> nsymbols;
+  std::atomic<std::size_t> textBytes;
+
+  symbol_table()
+  {
+    init();
+  }
+
+  /// Start an empty table
+  void init()
+  {
+    nsymbols.store(0);
+    textBytes.store(0);
+    for(unsigned int i = 0; i < symbolMaxChunks; i++)
+      {
+	chunks[i].store(0, std::memory_order_relaxed);
+      }
+    for(unsigned int i = 0; i < (1u << symbolShardBits); i++)
+      {
+	shards[i].mask = 15;
+	shards[i].used = 0;
+	shards[i].slots = new unsigned int[16];
+	shards[i].hashes = new unsigned int[16];
+	memset(shards[i].slots, 0, 16*sizeof(unsigned int));
+      }
+    //The empty text is the id 0 and the default
+    //name of maps and calls the id 1
+    store(std::string());
+    intern("****", 4, true);
+  }
+
+  /// Release all texts and tables
+  void release()
+  {
+    unsigned int n = nsymbols.load();
+    for(unsigned int id = 0; id < n; id++)
+      {
+	delete &text(id);
+      }
+    for(unsigned int i = 0; i < symbolMaxChunks; i++)
+      {
+	delete [] chunks[i].load();
+      }
+    for(unsigned int i = 0; i < (1u << symbolShardBits); i++)
+      {
+	delete [] shards[i].slots;
+	delete [] shards[i].hashes;
+      }
+  }
+
+  /// Return the id of a text, adding it if 'create' is true (see symbol::intern)
+  unsigned int intern(const char* text, std::size_t length, bool create);
+
+  /// Store a new text and return its id
+  unsigned int store(const std::string& text)
+  {
+    unsigned int id = nsymbols.fetch_add(1, std::memory_order_relaxed);
+    unsigned int offset;
+    unsigned int ichunk = symbolChunk(id, offset);
+    const std::string** chunk = chunks[ichunk].load(std::memory_order_acquire);
+    if(chunk == 0)
+      {
+	std::lock_guard<std::mutex> guard(chunksLock);
+	chunk = chunks[ichunk].load(std::memory_order_acquire);
+	if(chunk == 0)
+	  {
+	    chunk = new const std::string*[(std::size_t) 1 << (ichunk+symbolChunkBits)];
+	    chunks[ichunk].store(chunk, std::memory_order_release);
+	  }
+      }
+    chunk[offset] = new std::string(text);
+    textBytes.fetch_add(sizeof(std::string) + (text.length() > 15 ? text.length()+1 : 0), std::memory_order_relaxed);
+    return id;
+  }
+
+  /// Return the text of a stored id
+  inline const std::string& text(unsigned int id) const
+  {
+    unsigned int offset;
+    unsigned int ichunk = symbolChunk(id, offset);
+    return *chunks[ichunk].load(std::memory_order_acquire)[offset];
+  }
+};
+
+/// Return the global symbol table, created on first use
+static symbol_table& symbolTable()
 {
+  static symbol_table* table = new symbol_table;
+  return *table;
+}
 
-  //Connect current leaf with leaf pointed by 'pleaf'
-  //
-  //return 0 if connection has been added
-  //return 1 if connection already exists
-  //return 2 on self connections (will not be connected)
+/// Hash of a text (FNV-1a)
+static unsigned long long symbolHash(const char* text, std::size_t length)
+{
+  unsigned long long h = 14695981039346656037ULL;
+  for(std::size_t i = 0; i < length; i++)
+    {
+      h ^= (unsigned char) text[i];
+      h *= 1099511628211ULL;
+    }
+  return h;
+}
+
+unsigned int symbol_table::intern(const char* text, std::size_t length, bool create)
+{
+  // This function returns the id of 'text'. If the text
+  // is not interned and 'create' is true, it is added
+  // to the table.
   //
+  // return UINT_MAX if the text is not interned and 'create' is false
   
-  //Check 'links' array dimension 
-  if(nLinks >= maxLinks)
+  if(length == 0){return 0;}
+
+  unsigned long long h = symbolHash(text, length);
+  symbol_shard& shard = shards[h >> (64-symbolShardBits)];
+  const unsigned int hash = (unsigned int) h;
+  
+  std::lock_guard<std::mutex> guard(shard.lock);
+  unsigned int slot = hash & shard.mask;
+  while(shard.slots[slot] != 0)
     {
-      if(maxLinks <= 0)
-	{
-	  links = new leaf*[10];
-	  maxLinks = 10;
-	  nLinks = 0;
-	}
-      else
+      if(shard.hashes[slot] == hash)
 	{
-	  //Resize array
-	  leaf** paux = links;
-	  maxLinks *= 2;
-	  links = new leaf*[maxLinks];
-
-	  //Copy old array to new 
-	  for(unsigned int i = 0; i < nLinks; i++)
+	  const std::string& stored = this->text(shard.slots[slot]-1);
+	  if(stored.length() == length && memcmp(stored.data(), text, length) == 0)
 	    {
-	      links[i] = paux[i];
+	      return shard.slots[slot]-1;
 	    }
-
-	  //Delete old array
-	  delete [] paux;
 	}
+      slot = (slot+1) & shard.mask;
     }
 
-  //Check if this connection already exists
-  for(unsigned int i = 0; i < nLinks; i++)
-    if(pleaf == links[i])
-      return 1;
+  if(!create){return UINT_MAX;}
 
-  //Check if the connection is a self-connection
-  if(pleaf == this)
-    return 2;
+  //New text
+  unsigned int id = store(std::string(text, length));
+  shard.slots[slot] = id+1;
+  shard.hashes[slot] = hash;
+  shard.used++;
+
+  //Keep the load factor under 1/2
+  if(2*shard.used > shard.mask)
+    {
+      unsigned int newMask = 2*shard.mask+1;
+      unsigned int* slots = new unsigned int[newMask+1];
+      unsigned int* hashes = new unsigned int[newMask+1];
+      memset(slots, 0, (newMask+1)*sizeof(unsigned int));
+      for(unsigned int i = 0; i <= shard.mask; i++)
+	{
+	  if(shard.slots[i] == 0){continue;}
+	  unsigned int j = shard.hashes[i] & newMask;
+	  while(slots[j] != 0){j = (j+1) & newMask;}
+	  slots[j] = shard.slots[i];
+	  hashes[j] = shard.hashes[i];
+	}
+      delete [] shard.slots;
+      delete [] shard.hashes;
+      shard.slots = slots;
+      shard.hashes = hashes;
+      shard.mask = newMask;
+    }
   
-  //Add connection
-  links[nLinks] = pleaf;
-  nLinks++;
+  return id;
+}
+
+unsigned int symbol::intern(const char* text, std::size_t length, bool create)
+{
+  return symbolTable().intern(text, length, create);
+}
+
+/// Number of source maps alive. The symbol table can't be reset while some map uses it
+static std::atomic<int> liveMaps(0);
+
+int symbol::reset()
+{
+  // This function releases all interned texts
+  // and starts an empty table.
+  //
+  // return  0 on succes
+  // return -1 if some source map is alive
+
+  if(liveMaps.load() > 0)
+    return -1;
   
+  symbol_table& table = symbolTable();
+  table.release();
+  table.init();
   return 0;
 }
 
-void leaf::clear()
+bool symbol::find(const char* text, symbol& out)
 {
-  //Clear arrays
-  if(maxLinks > 0)
+  unsigned int id = intern(text, strlen(text), false);
+  if(id == UINT_MAX){return false;}
+  out.sid = id;
+  return true;
+}
+
+unsigned int symbol::count()
+{
+  return symbolTable().nsymbols.load();
+}
+
+std::size_t symbol::bytes()
+{
+  // Stored texts, chunks and shard tables
+  symbol_table& table = symbolTable();
+  std::size_t total = table.textBytes.load();
+  unsigned int n = table.nsymbols.load();
+  unsigned int offset;
+  unsigned int lastChunk = symbolChunk(n > 0 ? n-1 : 0, offset);
+  total += (((std::size_t) 2 << lastChunk) - 1)*(sizeof(const std::string*) << symbolChunkBits);
+  for(unsigned int i = 0; i < (1u << symbolShardBits); i++)
     {
-      delete [] links;
+      std::lock_guard<std::mutex> guard(table.shards[i].lock);
+      total += (std::size_t) (table.shards[i].mask+1)*2*sizeof(unsigned int);
     }
-  maxLinks = 0;
-  nLinks = 0;
-  name.assign("****");
-  overload = 0;
+  return total;
 }
 
-leaf::~leaf()
+const std::string& symbol::str() const
 {
-  clear();
+  return symbolTable().text(sid);
+}
+
+/// Symbol of the default name of maps and calls. The table interns it
+/// before any other text, so his id is the same after symbol::reset
+static const symbol& defaultName()
+{
+  static const symbol unnamed("****");
+  return unnamed;
 }
 
 //**************************//
-//     calls functions      //
+//     id index functions   //
 //**************************//
 
-//Constructor
+id_index::id_index() : keys(0), values(0), mask(0), used(0)
+{}
 
-fcall::fcall()
+id_index::id_index(const id_index& c) : keys(0), values(0), mask(0), used(0)
 {
-  name.assign("****");
-  calls = 0;
+  (*this) = c;
 }
 
-fcall::fcall(const fcall& c)
+void id_index::rehash(unsigned int nslots)
 {
-  (*this) = c;
+  // Move the stored keys to a table of 'nslots' slots
+  
+  unsigned int* oldKeys = keys;
+  int* oldValues = values;
+  unsigned int oldSlots = keys != 0 ? mask+1 : 0;
+
+  keys = new unsigned int[nslots];
+  values = new int[nslots];
+  memset(keys, 0, nslots*sizeof(unsigned int));
+  mask = nslots-1;
+  
+  for(unsigned int i = 0; i < oldSlots; i++)
+    {
+      if(oldKeys[i] == 0){continue;}
+      unsigned int slot = ((oldKeys[i]-1) * 0x9E3779B1u) & mask;
+      while(keys[slot] != 0){slot = (slot+1) & mask;}
+      keys[slot] = oldKeys[i];
+      values[slot] = oldValues[i];
+    }
+  delete [] oldKeys;
+  delete [] oldValues;
 }
 
-fcall& fcall::operator=(const fcall& c)
+int id_index::insert(unsigned int id, int value)
 {
-  this->name.assign(c.name);
-  this->calls = c.calls;
-
-  return *this;
-}
+  // This function stores 'value' with key 'id'.
+  //
+  // return -1 if 'id' has been inserted
+  // return the stored value if 'id' already exists
 
-//Comparision overloads
+  //Keep the load factor under 1/2
+  if(keys == 0 || 2*(used+1) > mask+1)
+    {
+      rehash(keys == 0 ? 16 : 2*(mask+1));
+    }
 
-//Operator <
+  unsigned int slot = (id * 0x9E3779B1u) & mask;
+  while(keys[slot] != 0)
+    {
+      if(keys[slot] == id+1){return values[slot];}
+      slot = (slot+1) & mask;
+    }
+  keys[slot] = id+1;
+  values[slot] = value;
+  used++;
+  return -1;
+}
 
-bool fcall::operator<(const fcall& c) const
+int id_index::erase(unsigned int id)
 {
-  //operator < used for sort function_map variables
+  // This function removes the key 'id'.
+  //
+  // return the stored value or -1 if 'id' doesn't exist
 
-  int value = this->name.compare(c.name);
-  if(value < 0)
+  if(used == 0){return -1;}
+  unsigned int slot = (id * 0x9E3779B1u) & mask;
+  while(keys[slot] != id+1)
     {
-      // The first character that does not match has a lower value in
-      // "this->name". Considere "this" smaller than "c".
-      return true;      
-    }
-  else if(value > 0)
-    {
-      // The first character that does not match has a lower value in
-      // "c.name". Considere "c" smaller than "this".
-      return false;      
+      if(keys[slot] == 0){return -1;}
+      slot = (slot+1) & mask;
     }
-  else
+  int value = values[slot];
+
+  //Move back the following keys of the cluster that
+  //can not be found if the slot is left empty
+  unsigned int hole = slot;
+  for(unsigned int next = (slot+1) & mask; keys[next] != 0; next = (next+1) & mask)
     {
-      // Both names are equal. Compare number of calls
-      return (this->calls < c.calls);
+      unsigned int home = ((keys[next]-1) * 0x9E3779B1u) & mask;
+      if(((next-home) & mask) >= ((next-hole) & mask))
+	{
+	  keys[hole] = keys[next];
+	  values[hole] = values[next];
+	  hole = next;
+	}
     }
+  keys[hole] = 0;
+  used--;
+  return value;
 }
 
-//Operator >
-
-bool fcall::operator>(const fcall& c) const
+void id_index::reserve(unsigned int n)
 {
-  //operator < used for sort function_map variables
-  
-  int value = this->name.compare(c.name);
-  if(value < 0)
+  unsigned int nslots = 16;
+  while(nslots < 2*n){nslots *= 2;}
+  if(keys == 0 || nslots > mask+1)
     {
-      // The first character that does not match has a lower value in
-      // "this->name". Considere "this" smaller than "c".
-      return false;      
+      rehash(nslots);
     }
-  else if(value > 0)
+}
+
+void id_index::clear()
+{
+  if(keys != 0 && used > 0)
     {
-      // The first character that does not match has a lower value in
-      // "c.name". Considere "c" smaller than "this".
-      return true;      
+      memset(keys, 0, (mask+1)*sizeof(unsigned int));
     }
-  else
+  used = 0;
+}
+
+id_index& id_index::operator=(const id_index& c)
+{
+  if(this == &c){return *this;}
+  delete [] keys;
+  delete [] values;
+  keys = 0;
+  values = 0;
+  mask = c.mask;
+  used = c.used;
+  if(c.keys != 0)
     {
-      // Both names are equal. Compare number of calls
-      return (this->calls > c.calls);
+      keys = new unsigned int[mask+1];
+      values = new int[mask+1];
+      memcpy(keys, c.keys, (mask+1)*sizeof(unsigned int));
+      memcpy(values, c.values, (mask+1)*sizeof(int));
     }
+  return *this;
 }
 
+id_index::~id_index()
+{
+  delete [] keys;
+  delete [] values;
+}
 
 //**************************//
-// namespaces map functions //
+//    id bitmap functions   //
 //**************************//
 
-namespace_map::namespace_map()
+//Containers with more ids are stored as bit sets
+static const unsigned int containerMaxArray = 4096;
+static const unsigned int containerWords = 1024;
+
+static inline unsigned int bitCount(unsigned long long w)
 {
-  functionsNames = 0;
-  maxnfnames = 0;
-  nfnames = 0;
-  name.assign("****");
+  //Count the set bits without requiring the popcnt instruction,
+  //so the word loops of the containers are vectorized
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (unsigned int) ((w * 0x0101010101010101ULL) >> 56);
 }
 
-namespace_map::namespace_map(const namespace_map& c)
+static inline bool containerHas(const id_container& c, unsigned short low)
 {
-  functionsNames = 0;
-  maxnfnames = 0;
-  nfnames = 0;
-  name.assign("****");
-  
-  (*this) = c;
+  if(c.bits != 0)
+    {
+      return (c.bits[low >> 6] >> (low & 63)) & 1;
+    }
+  return std::binary_search(c.values, c.values+c.card, low);
 }
 
-int namespace_map::appendF(const char* fname)
+static void containerToBits(id_container& c)
 {
-
-  //This function append a function name to
-  //function names array.
-  //
-  //return 0 on succes
-  //return 1 if the name already exists
-
-  //Check array space
-  if(nfnames >= maxnfnames)
+  //Convert the sorted array to a bit set
+  unsigned long long* bits = new unsigned long long[containerWords];
+  memset(bits, 0, containerWords*sizeof(unsigned long long));
+  for(unsigned int i = 0; i < c.card; i++)
     {
-      resizeFNames(10+2*maxnfnames);
+      bits[c.values[i] >> 6] |= 1ULL << (c.values[i] & 63);
     }
+  delete [] c.values;
+  c.values = 0;
+  c.maxValues = 0;
+  c.bits = bits;
+}
 
-  //Check if this value already exists
+static void containerFromBits(id_container& c)
+{
+  //Convert the bit set to a sorted array if it
+  //has few ids. 'card' must be updated.
 
-  for(int i = 0; i < nfnames; i++)
+  if(c.card > containerMaxArray){return;}
+
+  unsigned int maxValues = c.card > 0 ? c.card : 1;
+  unsigned short* values = new unsigned short[maxValues];
+  unsigned int n = 0;
+  for(unsigned int w = 0; w < containerWords; w++)
     {
-      if(functionsNames[i].compare(fname) == 0)
+      unsigned long long word = c.bits[w];
+      while(word != 0)
 	{
-	  //Exists!
-	  return 1;
+	  values[n++] = (unsigned short) (w*64 + __builtin_ctzll(word));
+	  word &= word-1;
 	}
     }
+  delete [] c.bits;
+  c.bits = 0;
+  c.values = values;
+  c.maxValues = maxValues;
+}
+
+static unsigned int mergeValues(id_container& a, const id_container& b, bool common)
+{
+  //Keep in place the values of 'a' that are also ('common' true)
+  //or are not ('common' false) in 'b'. Both must be arrays.
+  //
+  //return the number of kept values
   
-  //append value
-  functionsNames[nfnames].assign(fname);
-  nfnames++;
-  return 0;
+  unsigned int kept = 0;
+  unsigned int j = 0;
+  for(unsigned int i = 0; i < a.card; i++)
+    {
+      while(j < b.card && b.values[j] < a.values[i]){j++;}
+      bool found = j < b.card && b.values[j] == a.values[i];
+      if(found == common){a.values[kept++] = a.values[i];}
+    }
+  return kept;
 }
 
-void namespace_map::sort()
+static void containerCopy(id_container& dest, const id_container& c)
 {
-  //Sorts names in 'functinsNames' array
-  std::sort(functionsNames, functionsNames+nfnames, stringOrder);  
+  dest.key = c.key;
+  dest.card = c.card;
+  dest.values = 0;
+  dest.bits = 0;
+  dest.maxValues = 0;
+  if(c.bits != 0)
+    {
+      dest.bits = new unsigned long long[containerWords];
+      memcpy(dest.bits, c.bits, containerWords*sizeof(unsigned long long));
+    }
+  else
+    {
+      dest.maxValues = c.card > 0 ? c.card : 1;
+      dest.values = new unsigned short[dest.maxValues];
+      memcpy(dest.values, c.values, c.card*sizeof(unsigned short));
+    }
 }
 
-void namespace_map::resizeFNames(int dim)
+static void containerFree(id_container& c)
 {
-  //Resize array 'functionsNames' to size 'dim'
+  delete [] c.values;
+  delete [] c.bits;
+  c.values = 0;
+  c.bits = 0;
+  c.maxValues = 0;
+  c.card = 0;
+}
 
-  if(nfnames > 0)
-    {  
-      std::string* paux = functionsNames;
-      functionsNames = 0;
-      functionsNames = new std::string[dim];
+id_bitmap::id_bitmap() : containers(0), nContainers(0), maxContainers(0), total(0)
+{}
+
+id_bitmap::id_bitmap(const id_bitmap& c) : containers(0), nContainers(0), maxContainers(0), total(0)
+{
+  (*this) = c;
+}
 
-      int limit =  nfnames < dim ? nfnames : dim;
+int id_bitmap::findContainer(unsigned short key) const
+{
+  int first = 0;
+  int last = nContainers;
+  while(first < last)
+    {
+      int mid = (first+last)/2;
+      if(containers[mid].key < key){first = mid+1;}
+      else{last = mid;}
+    }
+  if(first < nContainers && containers[first].key == key){return first;}
+  return -(first+1);
+}
 
-      for(int i = 0; i < limit; i++)
+void id_bitmap::insertContainer(int pos, unsigned short key)
+{
+  //Check array space
+  if(nContainers >= maxContainers)
+    {
+      int newMax = maxContainers > 0 ? 2*maxContainers : 4;
+      id_container* paux = containers;
+      containers = new id_container[newMax];
+      for(int i = 0; i < nContainers; i++)
 	{
-	  functionsNames[i].assign(paux[i]);
+	  containers[i] = paux[i];
 	}
-
-      nfnames = limit;
-  
-      // delete old array
       delete [] paux;
+      maxContainers = newMax;
     }
-  else if(functionsNames != 0)
+
+  for(int i = nContainers; i > pos; i--)
     {
-      delete [] functionsNames;
-      functionsNames = new std::string[dim];      
-      nfnames = 0;
+      containers[i] = containers[i-1];
     }
-  else
+  id_container& c = containers[pos];
+  c.key = key;
+  c.card = 0;
+  c.maxValues = 4;
+  c.values = new unsigned short[c.maxValues];
+  c.bits = 0;
+  nContainers++;
+}
+
+void id_bitmap::compact()
+{
+  int kept = 0;
+  total = 0;
+  for(int i = 0; i < nContainers; i++)
     {
-      functionsNames = new std::string[dim];      
-      nfnames = 0;
+      if(containers[i].card == 0)
+	{
+	  containerFree(containers[i]);
+	  continue;
+	}
+      total += containers[i].card;
+      containers[kept++] = containers[i];
     }
-  maxnfnames = dim;  
+  nContainers = kept;
 }
 
-std::string namespace_map::to_string(int tabs) const
+int id_bitmap::add(unsigned int id)
 {
-  // This function convert the function_map
-  // to formated string.
+  // This function adds 'id' to the set
   //
-  // 'tabs' variable specifies the number of
-  // inintial tabs to align the text
-
-  std::string out;
+  // return 0 if 'id' has been added
+  // return 1 if 'id' already exists
 
-  //Name
-  out.append(tabs,'\t');
-  out.append("namespace name: ");
-  out.append(name);
-  out.append(1,'\n');
-  
-  //functions that uses this namespace
-  out.append(tabs+1,'\t');
-  out.append("    functions: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nfnames; i++)
+  unsigned short key = (unsigned short) (id >> 16);
+  unsigned short low = (unsigned short) (id & 0xFFFF);
+  int pos = findContainer(key);
+  if(pos < 0)
     {
-      out.append(tabs+2,'\t');
-      out.append("               ");
-      out.append(functionsNames[i]);
-      out.append(1,'\n');
+      pos = -pos-1;
+      insertContainer(pos, key);
     }
-  
-  return out;
-  
-}
+  id_container& c = containers[pos];
 
-//Clear function
-
-void namespace_map::clear()
-{
-  if(maxnfnames > 0)
+  if(c.bits != 0)
     {
-      delete [] functionsNames;
+      unsigned long long bit = 1ULL << (low & 63);
+      if(c.bits[low >> 6] & bit){return 1;}
+      c.bits[low >> 6] |= bit;
     }
-  
-  functionsNames = 0;
-
-  nfnames = 0;
-
-  maxnfnames = 0;
-  
-  name.assign("****"); //Default name
-  
+  else
+    {
+      unsigned short* p = std::lower_bound(c.values, c.values+c.card, low);
+      if(p != c.values+c.card && *p == low){return 1;}
+      if(c.card >= containerMaxArray)
+	{
+	  containerToBits(c);
+	  c.bits[low >> 6] |= 1ULL << (low & 63);
+	}
+      else
+	{
+	  unsigned int ipos = p-c.values;
+	  if(c.card >= c.maxValues)
+	    {
+	      //Resize array
+	      unsigned short* paux = c.values;
+	      c.maxValues *= 2;
+	      c.values = new unsigned short[c.maxValues];
+	      memcpy(c.values, paux, c.card*sizeof(unsigned short));
+	      delete [] paux;
+	    }
+	  memmove(c.values+ipos+1, c.values+ipos, (c.card-ipos)*sizeof(unsigned short));
+	  c.values[ipos] = low;
+	}
+    }
+  c.card++;
+  total++;
+  return 0;
 }
 
-//Assign operator
-
-namespace_map& namespace_map::operator=(const namespace_map& c)
+int id_bitmap::remove(unsigned int id)
 {
-  //Operator assign
-
-  //Clear actual state
-  clear();
-
-  //Copy
-  maxnfnames = c.maxnfnames;
-  nfnames = c.nfnames;
+  // This function removes 'id' from the set
+  //
+  // return 0 if 'id' has been removed
+  // return 1 if 'id' doesn't exist
 
-  functionsNames = new std::string[maxnfnames];
+  unsigned short low = (unsigned short) (id & 0xFFFF);
+  int pos = findContainer((unsigned short) (id >> 16));
+  if(pos < 0){return 1;}
+  id_container& c = containers[pos];
 
-  for(int i = 0; i < nfnames; i++)
+  if(c.bits != 0)
     {
-      functionsNames[i].assign(c.functionsNames[i]);
+      unsigned long long bit = 1ULL << (low & 63);
+      if((c.bits[low >> 6] & bit) == 0){return 1;}
+      c.bits[low >> 6] &= ~bit;
+      c.card--;
+      if(c.card <= containerMaxArray){containerFromBits(c);}
     }
-
-  name.assign(c.name);
-
-  return (*this);
+  else
+    {
+      unsigned short* p = std::lower_bound(c.values, c.values+c.card, low);
+      if(p == c.values+c.card || *p != low){return 1;}
+      memmove(p, p+1, (c.values+c.card-p-1)*sizeof(unsigned short));
+      c.card--;
+    }
+  total--;
+  if(c.card == 0){compact();}
+  return 0;
 }
 
-//Comparison operators
-
-bool namespace_map::operator<(const namespace_map& c) const
-{
-  return stringOrder(name,c.name);
-}
-bool namespace_map::operator>(const namespace_map& c) const
+bool id_bitmap::contains(unsigned int id) const
 {
-  return stringOrderInv(name,c.name);  
+  int pos = findContainer((unsigned short) (id >> 16));
+  if(pos < 0){return false;}
+  return containerHas(containers[pos], (unsigned short) (id & 0xFFFF));
 }
 
-
-//Destructor
-
-namespace_map::~namespace_map()
+void id_bitmap::andWith(const id_bitmap& c)
 {
-  clear();
-}
+  // Keep the ids that are also stored in 'c'.
+  // Containers without pair are emptied and
+  // removed at the end.
 
-//**************************//
-//  function map functions  //
-//**************************//
+  int j = 0;
+  for(int i = 0; i < nContainers; i++)
+    {
+      id_container& a = containers[i];
+      while(j < c.nContainers && c.containers[j].key < a.key){j++;}
+      if(j >= c.nContainers || c.containers[j].key != a.key)
+	{
+	  a.card = 0;
+	  continue;
+	}
+      const id_container& b = c.containers[j];
 
-//Constructor
+      if(a.bits == 0 && b.bits == 0)
+	{
+	  //Merge both sorted arrays, the result fits in place
+	  a.card = mergeValues(a, b, true);
+	}
+      else if(a.bits == 0)
+	{
+	  //Filter the array in place
+	  unsigned int kept = 0;
+	  for(unsigned int k = 0; k < a.card; k++)
+	    {
+	      if(containerHas(b, a.values[k])){a.values[kept++] = a.values[k];}
+	    }
+	  a.card = kept;
+	}
+      else if(b.bits == 0)
+	{
+	  //The result fits in the array of 'b'
+	  unsigned short* values = new unsigned short[b.card > 0 ? b.card : 1];
+	  unsigned int n = 0;
+	  for(unsigned int k = 0; k < b.card; k++)
+	    {
+	      if(containerHas(a, b.values[k])){values[n++] = b.values[k];}
+	    }
+	  delete [] a.bits;
+	  a.bits = 0;
+	  a.values = values;
+	  a.maxValues = b.card > 0 ? b.card : 1;
+	  a.card = n;
+	}
+      else
+	{
+	  unsigned int card = 0;
+	  for(unsigned int w = 0; w < containerWords; w++)
+	    {
+	      a.bits[w] &= b.bits[w];
+	      card += bitCount(a.bits[w]);
+	    }
+	  a.card = card;
+	  containerFromBits(a);
+	}
+    }
+  compact();
+}
 
-function_map::function_map()
+void id_bitmap::orWith(const id_bitmap& c)
 {
-  nNamespaces = 0;
-  nCalledF = 0;
+  // Add the ids stored in 'c'. Containers of 'c'
+  // without pair are copied.
 
-  maxNamespaces = 0;
-  maxCalledF = 0;
-  
-  nOverload = 0;
+  for(int j = 0; j < c.nContainers; j++)
+    {
+      const id_container& b = c.containers[j];
+      int pos = findContainer(b.key);
+      if(pos < 0)
+	{
+	  pos = -pos-1;
+	  insertContainer(pos, b.key);
+	  containerFree(containers[pos]);
+	  containerCopy(containers[pos], b);
+	  continue;
+	}
+      id_container& a = containers[pos];
 
-  name.assign("****"); //Default name
-  sourceFile.assign("****"); //Default source
-  namespaces = 0;
-  fcalls = 0;
+      if(a.bits == 0 && b.bits == 0 && a.card + b.card <= containerMaxArray)
+	{
+	  //Merge both sorted arrays
+	  unsigned int maxValues = a.card + b.card > 0 ? a.card + b.card : 1;
+	  unsigned short* values = new unsigned short[maxValues];
+	  unsigned short* end = std::set_union(a.values, a.values+a.card,
+					       b.values, b.values+b.card, values);
+	  delete [] a.values;
+	  a.values = values;
+	  a.maxValues = maxValues;
+	  a.card = end-values;
+	  continue;
+	}
+
+      if(a.bits == 0){containerToBits(a);}
+      if(b.bits != 0)
+	{
+	  unsigned int card = 0;
+	  for(unsigned int w = 0; w < containerWords; w++)
+	    {
+	      a.bits[w] |= b.bits[w];
+	      card += bitCount(a.bits[w]);
+	    }
+	  a.card = card;
+	}
+      else
+	{
+	  for(unsigned int k = 0; k < b.card; k++)
+	    {
+	      unsigned long long bit = 1ULL << (b.values[k] & 63);
+	      if((a.bits[b.values[k] >> 6] & bit) == 0)
+		{
+		  a.bits[b.values[k] >> 6] |= bit;
+		  a.card++;
+		}
+	    }
+	}
+      containerFromBits(a);
+    }
+  compact();
 }
 
-function_map::function_map(const function_map& c)
+void id_bitmap::andNotWith(const id_bitmap& c)
 {
-  //Init all parameters
-  nNamespaces = 0;
-  nCalledF = 0;
-
-  maxNamespaces = 0;
-  maxCalledF = 0;
+  // Remove the ids stored in 'c'
   
-  nOverload = 0;
+  int j = 0;
+  for(int i = 0; i < nContainers; i++)
+    {
+      id_container& a = containers[i];
+      while(j < c.nContainers && c.containers[j].key < a.key){j++;}
+      if(j >= c.nContainers || c.containers[j].key != a.key){continue;}
+      const id_container& b = c.containers[j];
 
-  name.assign("****"); //Default name
-  sourceFile.assign("****"); //Default source
-  namespaces = 0;
-  fcalls = 0;
-  
-  (*this) = c; //Copy object C
+      if(a.bits == 0 && b.bits == 0)
+	{
+	  a.card = mergeValues(a, b, false);
+	  continue;
+	}
+      if(a.bits == 0)
+	{
+	  unsigned int kept = 0;
+	  for(unsigned int k = 0; k < a.card; k++)
+	    {
+	      if(!containerHas(b, a.values[k])){a.values[kept++] = a.values[k];}
+	    }
+	  a.card = kept;
+	  continue;
+	}
+      
+      if(b.bits != 0)
+	{
+	  unsigned int card = 0;
+	  for(unsigned int w = 0; w < containerWords; w++)
+	    {
+	      a.bits[w] &= ~b.bits[w];
+	      card += bitCount(a.bits[w]);
+	    }
+	  a.card = card;
+	}
+      else
+	{
+	  for(unsigned int k = 0; k < b.card; k++)
+	    {
+	      unsigned long long bit = 1ULL << (b.values[k] & 63);
+	      if(a.bits[b.values[k] >> 6] & bit)
+		{
+		  a.bits[b.values[k] >> 6] &= ~bit;
+		  a.card--;
+		}
+	    }
+	}
+      containerFromBits(a);
+    }
+  compact();
 }
 
-//Resize functions
-
-void function_map::resizeFCalls(int dim)
+unsigned int id_bitmap::toArray(unsigned int* out) const
 {
-  //Resize array 'fcalls' to size 'dim'
-
-  if(nCalledF > 0)
-    {  
-      fcall* paux = fcalls;
-      fcalls = 0;
-      fcalls = new fcall[dim];
+  unsigned int n = 0;
+  for(int i = 0; i < nContainers; i++)
+    {
+      const id_container& c = containers[i];
+      unsigned int high = ((unsigned int) c.key) << 16;
+      if(c.bits == 0)
+	{
+	  for(unsigned int k = 0; k < c.card; k++)
+	    {
+	      out[n++] = high | c.values[k];
+	    }
+	  continue;
+	}
+      for(unsigned int w = 0; w < containerWords; w++)
+	{
+	  unsigned long long word = c.bits[w];
+	  while(word != 0)
+	    {
+	      out[n++] = high | (w*64 + __builtin_ctzll(word));
+	      word &= word-1;
+	    }
+	}
+    }
+  return n;
+}
 
-      int limit =  nCalledF < dim ? nCalledF : dim;
+unsigned int id_bitmap::nthMissing(unsigned int n) const
+{
+  // This function returns the 'n'th id that is not
+  // stored. Each container holds 65536 ids, 'card' of
+  // them stored, so whole containers are skipped.
 
-      for(int i = 0; i < limit; i++)
+  unsigned int stored = 0;
+  for(int i = 0; i < nContainers; i++)
+    {
+      const id_container& c = containers[i];
+      unsigned int high = ((unsigned int) c.key) << 16;
+      if(n+stored < high)
+	break;
+      unsigned int missing = high+65536-stored-c.card;
+      if(n >= missing)
 	{
-	  fcalls[i] = paux[i];
+	  stored += c.card;
+	  continue;
 	}
 
-      nCalledF = limit;
-  
-      // delete old array
-      delete [] paux;
+      //Missing id of this container, 'r' after 'high'
+      unsigned int r = n+stored-high;
+      if(c.bits == 0)
+	{
+	  //The k-th value has values[k]-k missing ids before it
+	  unsigned int first = 0;
+	  unsigned int last = c.card;
+	  while(first < last)
+	    {
+	      unsigned int mid = (first+last)/2;
+	      if((unsigned int) c.values[mid]-mid <= r){first = mid+1;}
+	      else{last = mid;}
+	    }
+	  return high+r+first;
+	}
+      for(unsigned int w = 0; w < containerWords; w++)
+	{
+	  unsigned long long word = ~c.bits[w];
+	  unsigned int count = __builtin_popcountll(word);
+	  if(r >= count)
+	    {
+	      r -= count;
+	      continue;
+	    }
+	  for(; r > 0; r--){word &= word-1;}
+	  return high+w*64+__builtin_ctzll(word);
+	}
     }
-  else if(fcalls != 0)
+  return n+stored;
+}
+
+std::size_t id_bitmap::bytes() const
+{
+  std::size_t size = maxContainers*sizeof(id_container);
+  for(int i = 0; i < nContainers; i++)
     {
-      delete [] fcalls;
-      fcalls = new fcall[dim];      
-      nCalledF = 0;
+      if(containers[i].bits != 0)
+	{
+	  size += containerWords*sizeof(unsigned long long);
+	}
+      else
+	{
+	  size += containers[i].maxValues*sizeof(unsigned short);
+	}
     }
-  else
+  return size;
+}
+
+void id_bitmap::clear()
+{
+  for(int i = 0; i < nContainers; i++)
     {
-      fcalls = new fcall[dim];      
-      nCalledF = 0;
+      containerFree(containers[i]);
     }
-  maxCalledF = dim;  
+  delete [] containers;
+  containers = 0;
+  nContainers = 0;
+  maxContainers = 0;
+  total = 0;
 }
 
-//Load information function
+void id_bitmap::swap(id_bitmap& c) noexcept
+{
+  std::swap(containers, c.containers);
+  std::swap(nContainers, c.nContainers);
+  std::swap(maxContainers, c.maxContainers);
+  std::swap(total, c.total);
+}
 
-int function_map::loadFunction(std::string inS, const char* fname, int overload)
+id_bitmap& id_bitmap::operator=(const id_bitmap& c)
 {
-  //This function will search and extract information
-  //for the specified function name (fname) defined in
-  //source stored in 'inS'. To handle overload functions,
-  //an overload paramter can be specified.
-  //
-  //A overload equal to 1 will load the first function
-  //definition match.
-  //
-  //return 0 on succes.
-  //return -1 if the function has not been found
-  //return -2 if no marks exists in input string
-  //
-  
-  //Clear function
+  if(this == &c){return *this;}
   clear();
-  
-  //Load data
-
-  //Namespaces
-  nNamespaces = usedNamespaces(inS, namespaces, fname, overload);
-  
-  if(nNamespaces < 0)
-    {
-      //Function not found or source file
-      //not marked previously
-      int returnv = nNamespaces; //Save return value before clear call
-      clear();
-      return returnv;
-    }
-  maxNamespaces = nNamespaces;
-  
-  //Called functions
-  nCalledF = calledFunc(inS, fcalls, fname, overload);
-
-  if(nCalledF < 0)
+  if(c.nContainers > 0)
     {
-      //Function not found or source file
-      //not marked previously
-      int returnv = nCalledF; //Save return value before clear call
-      clear();
-      return returnv;
+      containers = new id_container[c.nContainers];
+      maxContainers = c.nContainers;
+      for(int i = 0; i < c.nContainers; i++)
+	{
+	  containerCopy(containers[i], c.containers[i]);
+	}
+      nContainers = c.nContainers;
     }
+  total = c.total;
+  return *this;
+}
 
-  maxCalledF = nCalledF;
+id_bitmap::~id_bitmap()
+{
+  clear();
+}
 
-  //Store specified overload
-  nOverload = overload;
+//**************************//
+//      arena functions     //
+//**************************//
 
-  //Store function name
-  name.assign(fname);
+struct arena_chunk
+{
+  /// Previous chunk
+  arena_chunk* prev;
+  /// Chunk size in bytes, including this header
+  std::size_t size;
+};
+
+//Chunk sizes grow from 'arenaMinChunk' to 'arenaMaxChunk'
+static const std::size_t arenaMinChunk = 4096;
+static const std::size_t arenaMaxChunk = 1 << 20;
+static const std::size_t arenaAlign = alignof(std::max_align_t);
+static const std::size_t arenaHeader = (sizeof(arena_chunk)+arenaAlign-1) & ~(arenaAlign-1);
+
+arena::arena() : last(0), next(0), end(0), reserved(0), nChunks(0)
+{}
+
+void* arena::allocate(std::size_t bytes)
+{
+  // This function returns 'bytes' bytes from the last
+  // chunk, allocating a new chunk if they doesn't fit.
   
-  return 0;
-}
+  bytes = (bytes+arenaAlign-1) & ~(arenaAlign-1);
+  if(bytes == 0){bytes = arenaAlign;}
+  
+  if(last == 0 || (std::size_t) (end-next) < bytes)
+    {
+      //Chunks double its size up to the maximum. Large
+      //requests get a chunk of its own size
+      std::size_t size = last == 0 ? arenaMinChunk : 2*last->size;
+      if(size > arenaMaxChunk){size = arenaMaxChunk;}
+      if(size < bytes+arenaHeader){size = bytes+arenaHeader;}
+
+      arena_chunk* chunk = static_cast<arena_chunk*>(malloc(size));
+      if(chunk == 0){throw std::bad_alloc();}
+      chunk->prev = last;
+      chunk->size = size;
+      last = chunk;
+      next = reinterpret_cast<char*>(chunk)+arenaHeader;
+      end = reinterpret_cast<char*>(chunk)+size;
+      reserved += size;
+      nChunks++;
+    }
 
-//Acces functions
+  void* p = next;
+  next += bytes;
+  return p;
+}
 
-std::string function_map::getNamespace(int i) const
+void arena::adopt(arena& c)
 {
-  std::string aux;
-  if(i >= 0 && i < nNamespaces)
+  // This function links the chunks of 'c' before the
+  // last chunk of this arena, which is still used for
+  // next allocations.
+
+  if(&c == this || c.last == 0){return;}
+
+  if(last == 0)
     {
-      aux.assign(namespaces[i]);
+      last = c.last;
+      next = c.next;
+      end = c.end;
     }
-  else{aux.clear();}
-  
-  return aux;
+  else
+    {
+      arena_chunk* first = c.last;
+      while(first->prev != 0){first = first->prev;}
+      first->prev = last->prev;
+      last->prev = c.last;
+    }
+  reserved += c.reserved;
+  nChunks += c.nChunks;
+
+  c.last = 0;
+  c.next = 0;
+  c.end = 0;
+  c.reserved = 0;
+  c.nChunks = 0;
 }
 
-std::string function_map::getFName(int i) const
+void arena::release()
 {
-  std::string aux;
-  if(i >= 0 && i < nCalledF)
+  while(last != 0)
     {
-      aux.assign(fcalls[i].name);
+      arena_chunk* prev = last->prev;
+      free(last);
+      last = prev;
     }
-  else{aux.clear();}
+  next = 0;
+  end = 0;
+  reserved = 0;
+  nChunks = 0;
+}
+
+arena::~arena()
+{
+  release();
+}
+
+//**************************//
+//      leaf functions      //
+//**************************//
+
+leaf::leaf() : maxLinks(0), nLinks(0), overload(0)
+{
+  name.assign("****");
+}
+
+leaf::leaf(leaf&& c) noexcept : links(0), maxLinks(0), nLinks(0), overload(0)
+{
+  name.assign("****");
+  swap(c);
+}
+
+int leaf::connect(leaf* pleaf)
+{
+
+  //Connect current leaf with leaf pointed by 'pleaf'
+  //
+  //return 0 if connection has been added
+  //return 1 if connection already exists
+  //return 2 on self connections (will not be connected)
+  //
+  
+  //Check 'links' array dimension 
+  if(nLinks >= maxLinks)
+    {
+      if(maxLinks <= 0)
+	{
+	  links = new leaf*[10];
+	  maxLinks = 10;
+	  nLinks = 0;
+	}
+      else
+	{
+	  //Resize array
+	  leaf** paux = links;
+	  maxLinks *= 2;
+	  links = new leaf*[maxLinks];
+
+	  //Copy old array to new 
+	  for(unsigned int i = 0; i < nLinks; i++)
+	    {
+	      links[i] = paux[i];
+	    }
+
+	  //Delete old array
+	  delete [] paux;
+	}
+    }
+
+  //Check if this connection already exists
+  for(unsigned int i = 0; i < nLinks; i++)
+    if(pleaf == links[i])
+      return 1;
+
+  //Check if the connection is a self-connection
+  if(pleaf == this)
+    return 2;
+  
+  //Add connection
+  links[nLinks] = pleaf;
+  nLinks++;
+  
+  return 0;
+}
+
+void leaf::clear()
+{
+  //Clear arrays
+  if(maxLinks > 0)
+    {
+      delete [] links;
+    }
+  maxLinks = 0;
+  nLinks = 0;
+  name.assign("****");
+  overload = 0;
+}
+
+void leaf::swap(leaf& c) noexcept
+{
+  std::swap(links, c.links);
+  std::swap(maxLinks, c.maxLinks);
+  std::swap(nLinks, c.nLinks);
+  name.swap(c.name);
+  std::swap(overload, c.overload);
+}
+
+leaf& leaf::operator=(leaf&& c) noexcept
+{
+  if(this != &c)
+    {
+      clear();
+      swap(c);
+    }
+  return *this;
+}
+
+leaf::~leaf()
+{
+  clear();
+}
+
+//**************************//
+//  dep graph functions     //
+//**************************//
+
+dep_graph::dep_graph() : nNodes(0), nEdges(0), offsets(0), targets(0), weights(0), names(0), overloads(0)
+{}
+
+dep_graph::dep_graph(const dep_graph& c) : nNodes(0), nEdges(0), offsets(0), targets(0), weights(0), names(0), overloads(0)
+{
+  (*this) = c;
+}
+
+bool dep_graph::checkLink(int node, int target) const
+{
+  for(int i = offsets[node]; i < offsets[node+1]; i++)
+    {
+      if(targets[i] == target)
+	return true;
+    }
+  return false;
+}
+
+std::size_t dep_graph::bytes() const
+{
+  if(offsets == 0){return 0;}
+  return (nNodes+1)*sizeof(int) + nEdges*2*sizeof(int) +
+    nNodes*(sizeof(symbol)+sizeof(int));
+}
+
+void dep_graph::clear()
+{
+  delete [] offsets;
+  delete [] targets;
+  delete [] weights;
+  delete [] names;
+  delete [] overloads;
+  offsets = 0;
+  targets = 0;
+  weights = 0;
+  names = 0;
+  overloads = 0;
+  nNodes = 0;
+  nEdges = 0;
+}
+
+dep_graph& dep_graph::operator=(const dep_graph& c)
+{
+  if(this == &c){return *this;}
+  clear();
+  if(c.offsets == 0){return *this;}
+  
+  nNodes = c.nNodes;
+  nEdges = c.nEdges;
+  offsets = new int[nNodes+1];
+  targets = new int[nEdges > 0 ? nEdges : 1];
+  weights = new int[nEdges > 0 ? nEdges : 1];
+  names = new symbol[nNodes];
+  overloads = new int[nNodes];
+  memcpy(offsets, c.offsets, (nNodes+1)*sizeof(int));
+  memcpy(targets, c.targets, nEdges*sizeof(int));
+  memcpy(weights, c.weights, nEdges*sizeof(int));
+  for(int i = 0; i < nNodes; i++)
+    {
+      names[i] = c.names[i];
+    }
+  memcpy(overloads, c.overloads, nNodes*sizeof(int));
+  return *this;
+}
+
+dep_graph::~dep_graph()
+{
+  clear();
+}
+
+//**************************//
+//     calls functions      //
+//**************************//
+
+//Constructor
+
+fcall::fcall()
+{
+  name = defaultName();
+  calls = 0;
+}
+
+fcall::fcall(const fcall& c)
+{
+  (*this) = c;
+}
+
+fcall::fcall(fcall&& c) noexcept : name(c.name), calls(c.calls)
+{}
+
+fcall& fcall::operator=(const fcall& c)
+{
+  this->name.assign(c.name);
+  this->calls = c.calls;
+
+  return *this;
+}
+
+fcall& fcall::operator=(fcall&& c) noexcept
+{
+  this->name.assign(c.name);
+  this->calls = c.calls;
+
+  return *this;
+}
+
+void fcall::swap(fcall& c) noexcept
+{
+  name.swap(c.name);
+  std::swap(calls, c.calls);
+}
+
+//Comparision overloads
+
+//Operator <
+
+bool fcall::operator<(const fcall& c) const
+{
+  //operator < used for sort function_map variables
+
+  int value = this->name.compare(c.name);
+  if(value < 0)
+    {
+      // The first character that does not match has a lower value in
+      // "this->name". Considere "this" smaller than "c".
+      return true;      
+    }
+  else if(value > 0)
+    {
+      // The first character that does not match has a lower value in
+      // "c.name". Considere "c" smaller than "this".
+      return false;      
+    }
+  else
+    {
+      // Both names are equal. Compare number of calls
+      return (this->calls < c.calls);
+    }
+}
+
+//Operator >
+
+bool fcall::operator>(const fcall& c) const
+{
+  //operator < used for sort function_map variables
+  
+  int value = this->name.compare(c.name);
+  if(value < 0)
+    {
+      // The first character that does not match has a lower value in
+      // "this->name". Considere "this" smaller than "c".
+      return false;      
+    }
+  else if(value > 0)
+    {
+      // The first character that does not match has a lower value in
+      // "c.name". Considere "c" smaller than "this".
+      return true;      
+    }
+  else
+    {
+      // Both names are equal. Compare number of calls
+      return (this->calls > c.calls);
+    }
+}
+
+
+//**************************//
+// namespaces map functions //
+//**************************//
+
+namespace_map::namespace_map()
+{
+  functionsNames = 0;
+  maxnfnames = 0;
+  nfnames = 0;
+  pool = 0;
+  name = defaultName();
+}
+
+namespace_map::namespace_map(const namespace_map& c)
+{
+  functionsNames = 0;
+  maxnfnames = 0;
+  nfnames = 0;
+  pool = 0;
+  name = defaultName();
+  
+  (*this) = c;
+}
+
+namespace_map::namespace_map(namespace_map&& c) noexcept
+{
+  functionsNames = 0;
+  maxnfnames = 0;
+  nfnames = 0;
+  pool = 0;
+  name = defaultName();
+
+  swap(c);
+}
+
+int namespace_map::appendF(const char* fname)
+{
+  return appendF(symbol(fname));
+}
+
+int namespace_map::appendF(const symbol& fname)
+{
+
+  //This function append a function name to
+  //function names array.
+  //
+  //return 0 on succes
+  //return 1 if the name already exists
+
+  //Check if this value already exists
+  if(fnameSet.add(fname.id()) != 0)
+    {
+      //Exists! Count the reference
+      fnameRefs[fname.id()]++;
+      return 1;
+    }
+
+  //Removed names are still in the array
+  if(staleNames.remove(fname.id()) == 0)
+    {
+      return 0;
+    }
+  
+  //Check array space
+  if(nfnames >= maxnfnames)
+    {
+      resizeFNames(10+2*maxnfnames);
+    }
+
+  //append value
+  functionsNames[nfnames] = fname;
+  nfnames++;
+  return 0;
+}
+
+int namespace_map::removeF(const char* fname)
+{
+  symbol sname;
+  if(!symbol::find(fname, sname)){return -1;}
+  return removeF(sname);
+}
+
+int namespace_map::removeF(const symbol& fname)
+{
+  //This function removes a reference to a
+  //function name. The name is removed with
+  //its last reference.
+  //
+  //return 0 if the name has been removed
+  //return 1 if the name has other references
+  //return -1 if the name doesn't exist
+
+  if(!fnameSet.contains(fname.id()))
+    {
+      return -1;
+    }
+
+  std::unordered_map<unsigned int,int>::iterator it = fnameRefs.find(fname.id());
+  if(it != fnameRefs.end())
+    {
+      if(--it->second <= 0){fnameRefs.erase(it);}
+      return 1;
+    }
+
+  //The array is compacted when half of
+  //its names have been removed
+  fnameSet.remove(fname.id());
+  staleNames.add(fname.id());
+  if(2*staleNames.size() > (unsigned int) nfnames)
+    {
+      dropRemoved();
+    }
+  return 0;
+}
+
+int namespace_map::references(const symbol& fname) const
+{
+  if(!fnameSet.contains(fname.id()))
+    {
+      return 0;
+    }
+  std::unordered_map<unsigned int,int>::const_iterator it = fnameRefs.find(fname.id());
+  return it != fnameRefs.end() ? 1+it->second : 1;
+}
+
+void namespace_map::dropRemoved()
+{
+  //Remove the names of 'staleNames'
+  //keeping the order of the others
+  if(staleNames.empty())
+    {
+      return;
+    }
+  int n = 0;
+  for(int i = 0; i < nfnames; i++)
+    {
+      if(!staleNames.contains(functionsNames[i].id()))
+	{
+	  functionsNames[n] = functionsNames[i];
+	  n++;
+	}
+    }
+  nfnames = n;
+  staleNames.clear();
+}
+
+void namespace_map::sort()
+{
+  //Sorts names in 'functinsNames' array
+  dropRemoved();
+  std::sort(functionsNames, functionsNames+nfnames);
+}
+
+void namespace_map::sort(const unsigned int* ranks)
+{
+  //Sorts names in 'functinsNames' array comparing
+  //their ranks instead of their texts
+  dropRemoved();
+  std::sort(functionsNames, functionsNames+nfnames,
+	    [ranks](const symbol& a, const symbol& b){return ranks[a.id()] < ranks[b.id()];});
+}
+
+void namespace_map::resizeFNames(int dim)
+{
+  //Resize array 'functionsNames' to size 'dim'. Arrays
+  //of the arena are released with the arena.
+
+  symbol* paux = functionsNames;
+  functionsNames = pool != 0 ? pool->allocArray<symbol>(dim) : new symbol[dim];
+
+  int limit =  nfnames < dim ? nfnames : dim;
+
+  for(int i = 0; i < limit; i++)
+    {
+      functionsNames[i].assign(paux[i]);
+    }
+
+  nfnames = limit;
+  
+  // delete old array
+  if(pool == 0 && maxnfnames > 0)
+    {
+      delete [] paux;
+    }
+  maxnfnames = dim;  
+}
+
+void namespace_map::swap(namespace_map& c) noexcept
+{
+  std::swap(maxnfnames, c.maxnfnames);
+  std::swap(nfnames, c.nfnames);
+  std::swap(functionsNames, c.functionsNames);
+  std::swap(pool, c.pool);
+  fnameSet.swap(c.fnameSet);
+  fnameRefs.swap(c.fnameRefs);
+  staleNames.swap(c.staleNames);
+  name.swap(c.name);
+}
+
+std::string namespace_map::to_string(int tabs) const
+{
+  // This function convert the function_map
+  // to formated string.
+  //
+  // 'tabs' variable specifies the number of
+  // inintial tabs to align the text
+
+  std::string out;
+
+  //Name
+  out.append(tabs,'\t');
+  out.append("namespace name: ");
+  out.append(name);
+  out.append(1,'\n');
+  
+  //functions that uses this namespace
+  out.append(tabs+1,'\t');
+  out.append("    functions: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nfnames; i++)
+    {
+      if(!staleNames.empty() && staleNames.contains(functionsNames[i].id()))
+	continue;
+      out.append(tabs+2,'\t');
+      out.append("               ");
+      out.append(functionsNames[i]);
+      out.append(1,'\n');
+    }
+  
+  return out;
+  
+}
+
+//Clear function
+
+void namespace_map::clear()
+{
+  //Arrays of the arena are released with the arena
+  if(maxnfnames > 0 && pool == 0)
+    {
+      delete [] functionsNames;
+    }
+  
+  functionsNames = 0;
+
+  nfnames = 0;
+
+  maxnfnames = 0;
+
+  fnameSet.clear();
+  fnameRefs.clear();
+  staleNames.clear();
+  
+  name = defaultName(); //Default name
+  
+}
+
+//Assign operator
+
+namespace_map& namespace_map::operator=(const namespace_map& c)
+{
+  //Operator assign
+
+  //Clear actual state
+  clear();
+
+  //Copy
+  maxnfnames = c.maxnfnames;
+  nfnames = c.nfnames;
+
+  functionsNames = 0;
+  if(maxnfnames > 0)
+    {
+      functionsNames = pool != 0 ? pool->allocArray<symbol>(maxnfnames) : new symbol[maxnfnames];
+    }
+
+  for(int i = 0; i < nfnames; i++)
+    {
+      functionsNames[i].assign(c.functionsNames[i]);
+    }
+
+  name.assign(c.name);
+  fnameSet = c.fnameSet;
+  fnameRefs = c.fnameRefs;
+  staleNames = c.staleNames;
+
+  return (*this);
+}
+
+namespace_map& namespace_map::operator=(namespace_map&& c) noexcept
+{
+  //Take the arrays of 'c', which gets the cleared state
+  if(this != &c)
+    {
+      clear();
+      swap(c);
+    }
+  return (*this);
+}
+
+//Comparison operators
+
+bool namespace_map::operator<(const namespace_map& c) const
+{
+  return name < c.name;
+}
+bool namespace_map::operator>(const namespace_map& c) const
+{
+  return name > c.name;
+}
+
+
+//Destructor
+
+namespace_map::~namespace_map()
+{
+  clear();
+}
+
+//**************************//
+//     key map functions    //
+//**************************//
+
+key_map::key_map() : length(0), nwords(0), bits(0), ranks(0), positions(0), partners(0), nkeys(0), nunmatched(0)
+{
+}
+
+int key_map::build(const std::string& text)
+{
+  return build(text.c_str(), text.length());
+}
+
+int key_map::build(const char* text, std::size_t textLength)
+{
+  // This function builds the matching keys table
+  // of 'text' in a single pass. Keys of each type
+  // ('()', '[]' and '{}') are matched independently.
+  //
+  // return the number of not matched keys
+
+  // Key types: 1,2,3 for open keys and -1,-2,-3 for close keys.
+  // The table is built once, before any thread can read it.
+  struct keyTypeTable
+  {
+    signed char type[256];
+    keyTypeTable()
+    {
+      memset(type, 0, sizeof(type));
+      type[(unsigned char) '('] =  1;  type[(unsigned char) ')'] = -1;
+      type[(unsigned char) '['] =  2;  type[(unsigned char) ']'] = -2;
+      type[(unsigned char) '{'] =  3;  type[(unsigned char) '}'] = -3;
+    }
+  };
+  static const keyTypeTable table;
+  const signed char* keyType = table.type;
+  
+  clear();
+
+  //Count keys and open keys of each type
+  int nopen[3] = {0,0,0};
+  for(std::size_t i = 0; i < textLength; i++)
+    {
+      const int type = keyType[(unsigned char) text[i]];
+      if(type != 0)
+	{
+	  nkeys++;
+	  if(type > 0){nopen[type-1]++;}
+	}
+    }
+  
+  length = textLength;
+  nwords = (length >> 6) + 1;
+  bits = new unsigned long long[nwords];
+  ranks = new unsigned int[nwords];
+  positions = new std::size_t[nkeys > 0 ? nkeys : 1];
+  partners = new int[nkeys > 0 ? nkeys : 1];
+  memset(bits, 0, nwords*sizeof(unsigned long long));
+
+  //Stacks of open keys of each type
+  int* stacks[3];
+  int depth[3] = {0,0,0};
+  for(int k = 0; k < 3; k++)
+    {
+      stacks[k] = new int[nopen[k] > 0 ? nopen[k] : 1];
+    }
+  
+  int ikey = 0;
+  for(std::size_t i = 0; i < textLength; i++)
+    {
+      const int type = keyType[(unsigned char) text[i]];
+      if(type == 0){continue;}
+
+      //Register key position
+      bits[i >> 6] |= 1ULL << (i & 63);
+      positions[ikey] = i;
+      partners[ikey] = -1;
+      
+      if(type > 0)
+	{
+	  //Open key, push it
+	  stacks[type-1][depth[type-1]++] = ikey;
+	}
+      else if(depth[-type-1] > 0)
+	{
+	  //Close key, match it with the last open key of the same type
+	  int open = stacks[-type-1][--depth[-type-1]];
+	  partners[open] = ikey;
+	  partners[ikey] = open;
+	}
+      else
+	{
+	  //Close key without open key
+	  nunmatched++;
+	}
+      ikey++;
+    }
+
+  for(int k = 0; k < 3; k++)
+    {
+      //Remaining open keys are not matched
+      nunmatched += depth[k];
+      delete [] stacks[k];
+    }
+
+  //Build rank directory
+  unsigned int rank = 0;
+  for(std::size_t w = 0; w < nwords; w++)
+    {
+      ranks[w] = rank;
+      rank += __builtin_popcountll(bits[w]);
+    }
+  
+  return nunmatched;
+}
+
+void key_map::clear()
+{
+  delete [] bits;
+  delete [] ranks;
+  delete [] positions;
+  delete [] partners;
+  
+  bits = 0;
+  ranks = 0;
+  positions = 0;
+  partners = 0;
+  length = 0;
+  nwords = 0;
+  nkeys = 0;
+  nunmatched = 0;
+}
+
+key_map::~key_map()
+{
+  clear();
+}
+
+//**************************//
+//  parsed source functions //
+//**************************//
+
+parsed_source::parsed_source() : names(0), nnames(0), spans(0), nspans(0)
+{
+}
+
+int parsed_source::parse(const char* text, std::size_t length)
+{
+  // This function clears the specified code, builds
+  // his key map and locates all defined functions.
+  //
+  // return the number of defined functions
+
+  //Release previous contents
+  clear();
+
+  //Copy the code removing strings and comments
+  clearCode(text, length, code);
+
+  //Build matching keys table
+  keys.build(code);
+
+  //Extract defined function names and their locations
+  function_span* auxSpans = 0;
+  int nauxSpans = 0;
+  nnames = definedFunc(code, keys, names, auxSpans, nauxSpans);
+
+  //Sort spans by name keeping the overload order
+  //(counting sort, names are already numbered)
+  int* first = new int[nnames+1];
+  for(int i = 0; i <= nnames; i++){first[i] = 0;}
+  for(int i = 0; i < nauxSpans; i++){first[auxSpans[i].name+1]++;}
+  for(int i = 0; i < nnames; i++){first[i+1] += first[i];}
+
+  spans = new function_span[nauxSpans > 0 ? nauxSpans : 1];
+  for(int i = 0; i < nauxSpans; i++)
+    {
+      spans[first[auxSpans[i].name]++] = auxSpans[i];
+    }
+  nspans = nauxSpans;
+  
+  delete [] first;
+  delete [] auxSpans;
+  
+  return nspans;
+}
+
+int parsed_source::load(const char* filename)
+{
+  // This function reads and parses the
+  // specified file.
+  //
+  // return the number of defined functions on succes
+  // return -1 if the file can't be opened
+  // return -2 if an error occurs reading the file
+
+  mapped_file file;
+  int err = file.open(filename);
+  if(err != 0)
+    {
+      clear();
+      return err;
+    }
+
+  //Mapped pages are only read while the text is copied
+  //to the cleared code. If the file is truncated, read
+  //it and parse it again
+  int readS = 0;
+  if(!file.readMapped([&](){readS = parse(file.data(), file.size());}))
+    {
+      err = file.open(filename, true);
+      if(err != 0)
+	{
+	  clear();
+	  return err;
+	}
+      readS = parse(file.data(), file.size());
+    }
+  return readS;
+}
+
+int parsed_source::find(const char* fname, int overload) const
+{
+  // This function returns the span position
+  // of specified function overload or -1
+  // if is not found.
+
+  int iname = nameMatch(names, nnames, fname);
+  if(iname < 0 || overload < 1){return -1;}
+
+  for(int i = 0; i < nspans; i++)
+    {
+      if(spans[i].name == iname && spans[i].overload == overload)
+	{
+	  return i;
+	}
+    }
+  return -1;
+}
+
+void parsed_source::clear()
+{
+  delete [] names;
+  delete [] spans;
+  names = 0;
+  spans = 0;
+  nnames = 0;
+  nspans = 0;
+  code.clear();
+  keys.clear();
+}
+
+parsed_source::~parsed_source()
+{
+  clear();
+}
+
+//**************************//
+//  function map functions  //
+//**************************//
+
+//Constructor
+
+function_map::function_map()
+{
+  nNamespaces = 0;
+  nCalledF = 0;
+
+  maxNamespaces = 0;
+  maxCalledF = 0;
+  
+  nOverload = 0;
+
+  name = defaultName(); //Default name
+  sourceFile = defaultName(); //Default source
+  namespaces = 0;
+  fcalls = 0;
+  pool = 0;
+}
+
+function_map::function_map(const function_map& c)
+{
+  //Init all parameters
+  nNamespaces = 0;
+  nCalledF = 0;
+
+  maxNamespaces = 0;
+  maxCalledF = 0;
+  
+  nOverload = 0;
+
+  name = defaultName(); //Default name
+  sourceFile = defaultName(); //Default source
+  namespaces = 0;
+  fcalls = 0;
+  pool = 0;
+  
+  (*this) = c; //Copy object C
+}
+
+function_map::function_map(function_map&& c) noexcept
+{
+  //Init all parameters
+  nNamespaces = 0;
+  nCalledF = 0;
+
+  maxNamespaces = 0;
+  maxCalledF = 0;
+  
+  nOverload = 0;
+
+  name = defaultName(); //Default name
+  sourceFile = defaultName(); //Default source
+  namespaces = 0;
+  fcalls = 0;
+  pool = 0;
+
+  swap(c); //Take arrays of C
+}
+
+//Resize functions
+
+void function_map::resizeFCalls(int dim)
+{
+  //Resize array 'fcalls' to size 'dim'. Arrays
+  //of the arena are released with the arena.
+
+  fcall* paux = fcalls;
+  fcalls = pool != 0 ? pool->allocArray<fcall>(dim) : new fcall[dim];
+
+  int limit =  nCalledF < dim ? nCalledF : dim;
+
+  for(int i = 0; i < limit; i++)
+    {
+      fcalls[i] = paux[i];
+    }
+
+  nCalledF = limit;
+  
+  // delete old array
+  if(pool == 0 && maxCalledF > 0)
+    {
+      delete [] paux;
+    }
+  maxCalledF = dim;  
+}
+
+//Load information function
+
+int function_map::loadFunction(const std::string& inS, const char* fname, int overload, const key_map* keys)
+{
+  //This function will search and extract information
+  //for the specified function name (fname) defined in
+  //source stored in 'inS'. To handle overload functions,
+  //an overload paramter can be specified.
+  //
+  //A overload equal to 1 will load the first function
+  //definition match.
+  //
+  //return 0 on succes.
+  //return -1 if the function has not been found
+  //return -2 if no marks exists in input string
+  //
+  
+  //Clear function
+  clear();
+  
+  // Check if 'inS' has already been marked
+  if(inS.find("%00%",0) == std::string::npos){return -2;}
+
+  // Search the specified function overload
+  std::size_t pos = posDefinedFunc(inS, fname, overload, keys);
+  if(pos == std::string::npos)
+    {
+      // This function/overload doesn't exists
+      return -1;
+    }
+
+  //Extract end of function (position of close '}')
+  std::size_t endf = keys != 0 ? keys->close(pos) : closeKey(inS, pos);
+
+  //Load namespaces and called functions
+  scanBody(inS, pos, endf, namespaces, nNamespaces, fcalls, nCalledF, pool);
+  maxNamespaces = nNamespaces;
+  maxCalledF = nCalledF;
+
+  //Store specified overload
+  nOverload = overload;
+
+  //Store function name
+  name.assign(fname);
+  
+  return 0;
+}
+
+int function_map::loadFunction(const std::string& inS, const function_span& span, const char* fname, const key_map&)
+{
+  //This function extract information of the function
+  //defined in the specified 'span' of source 'inS'.
+  //'inS' must be a cleared code and 'keys' the
+  //corresponding key map.
+  //
+  //return 0 on succes.
+  //
+
+  //Clear function
+  clear();
+
+  //Load namespaces and called functions
+  scanBody(inS, span.open, span.close, namespaces, nNamespaces, fcalls, nCalledF, pool);
+  maxNamespaces = nNamespaces;
+  maxCalledF = nCalledF;
+  
+  //Store specified overload
+  nOverload = span.overload;
+
+  //Store function name
+  name.assign(fname);
+  
+  return 0;
+}
+
+int function_map::loadFunction(const parsed_source& src, int i)
+{
+  //This function extract information of the function
+  //stored in position 'i' of parsed source 'src'.
+  //
+  //return 0 on succes.
+  //return -1 if 'i' is out of range
+  //
+
+  if(i < 0 || i >= src.numSpans())
+    {
+      clear();
+      return -1;
+    }
+  
+  return loadFunction(src.text(), src.span(i), src.spanName(i).c_str(), src.keyMap());
+}
+
+void function_map::swap(function_map& c) noexcept
+{
+  std::swap(nNamespaces, c.nNamespaces);
+  std::swap(nCalledF, c.nCalledF);
+  std::swap(maxNamespaces, c.maxNamespaces);
+  std::swap(maxCalledF, c.maxCalledF);
+  std::swap(namespaces, c.namespaces);
+  std::swap(fcalls, c.fcalls);
+  std::swap(pool, c.pool);
+  name.swap(c.name);
+  sourceFile.swap(c.sourceFile);
+  std::swap(nOverload, c.nOverload);
+}
+
+//Acces functions
+
+std::string function_map::getNamespace(int i) const
+{
+  std::string aux;
+  if(i >= 0 && i < nNamespaces)
+    {
+      aux.assign(namespaces[i]);
+    }
+  else{aux.clear();}
+  
+  return aux;
+}
+
+std::string function_map::getFName(int i) const
+{
+  std::string aux;
+  if(i >= 0 && i < nCalledF)
+    {
+      aux.assign(fcalls[i].name);
+    }
+  else{aux.clear();}
+  
+  return aux;
+}
+
+fcall function_map::getCall(int i) const
+{
+  if(i >= 0 && i < nCalledF)
+    {
+      return fcalls[i];
+    }
+  
+  return fcall();  
+}
+
+//Append functions
+
+int function_map::appendCall(fcall call)
+{
+  //This function append a call pair function/number of call to
+  //the 'fcalls' array. The addition will not be performed if
+  //specified pair already exists.
+  //
+  //return number of function calls on succes
+  //return -1 if the pair already exists
+
+  return appendCall(call.name.c_str(), call.calls);
+  
+}
+
+int function_map::appendCall(const char* fname, int ncalls)
+{
+  //This function append a call pair function/number of calls to
+  //the 'fcalls' array. The addition will not be performed if
+  //specified pair already exists.
+  //
+  //return number of function calls on succes
+  //return -1 if the pair already exists
+
+  //Check if this name already exists
+  symbol sname(fname);
+  for(int i = 0; i < nCalledF; i++)
+    {
+      if(fcalls[i].name == sname)
+	{
+	  return -1;
+	}
+    }
+
+  //Check call array size
+  if(nCalledF >= maxCalledF)
+    {
+      int size;
+      if(maxCalledF == 0){size = 10;}
+      else{size = 2*maxCalledF;}
+      resizeFCalls(size); //Enlarge array
+    }
+
+  //Store new function call
+  fcalls[nCalledF].name = sname;
+  fcalls[nCalledF].calls = ncalls;
+  nCalledF++;
+  
+  return nCalledF;
+}
+
+//Set functions
+
+int function_map::setCall(fcall call)
+{
+  //This function set a call pair function/number of 
+  //the 'fcalls' array. If the specified pair doesn't exists
+  //will be appendet.
+  //
+  //return 0 on succes
+  //return number of function calls if the pair doesn't exist
+
+  return setCall(call.name.c_str(), call.calls);
+  
+}
+
+int function_map::setCall(const char* fname, int ncalls)
+{
+  //This function set a call pair function/number of 
+  //the 'fcalls' array. If the specified pair doesn't exists
+  //will be appendet.
+  //
+  //return 0 on succes
+  //return number of function calls if the pair doesn't exist
+
+  //Check if this name already exists
+  symbol sname(fname);
+  for(int i = 0; i < nCalledF; i++)
+    {
+      if(fcalls[i].name == sname)
+	{
+	  fcalls[i].calls = ncalls;
+	  return 0;
+	}
+    }
+
+  return appendCall(fname, ncalls);
+}
+
+int function_map::removeCall(const char* fname)
+{
+  //This function remove a call pair function/number of 
+  //the 'fcalls' array.
+  //
+  //return number of function calls on succes
+  //return -1 if the pair doesn't exist
+
+  //Check if this name already exists. Not
+  //interned names can't be in the array.
+  symbol sname;
+  if(!symbol::find(fname, sname)){return -1;}
+  for(int i = 0; i < nCalledF; i++)
+    {
+      if(fcalls[i].name == sname)
+	{
+	  //Found, move all following calls
+	  for(int j = i; j < nCalledF-1; j++)
+	    {
+	      fcalls[j] = fcalls[j+1];
+	    }
+	  nCalledF--;
+	  return 0;
+	}
+    }
+
+  return -1;
+}
+
+
+//Clear function
+
+void function_map::clear()
+{
+  //Arrays of the arena are released with the arena
+  if(maxNamespaces > 0 && pool == 0)
+    {
+      delete [] namespaces;
+    }
+  if(maxCalledF > 0 && pool == 0)
+    {
+      delete [] fcalls;
+    }
+  namespaces = 0;
+  fcalls = 0;
+  
+  nNamespaces = 0;
+  nCalledF = 0;
+
+  maxNamespaces = 0;
+  maxCalledF = 0;
+  
+  nOverload = 0;
+
+  name = defaultName(); //Default name
+  sourceFile = defaultName(); //Default source
+  
+}
+
+//To string function
+
+std::string function_map::to_string(int tabs) const
+{
+  // This function convert the function_map
+  // to formated string.
+  //
+  // 'tabs' variable specifies the number of
+  // inintial tabs to align the text
+
+  std::string out;
+
+  //Name
+  out.append(tabs,'\t');
+  out.append("function name: ");
+  out.append(name);
+  out.append(1,'\n');
+
+  //source file
+  out.append(tabs+1,'\t');
+  out.append("  source file: ");
+  out.append(sourceFile);
+  out.append(1,'\n');
+
+  //overload
+  out.append(tabs+1,'\t');
+  out.append("     overload: ");
+
+  char overloadChar[10];
+  sprintf(overloadChar,"%d",nOverload);
+  
+  out.append(overloadChar);
+  out.append(1,'\n');
+  
+  //namespaces used
+  out.append(tabs+1,'\t');
+  out.append("   namespaces: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nNamespaces; i++)
+    {
+      out.append(tabs+2,'\t');
+      out.append("               ");
+      out.append(namespaces[i]);
+      out.append(1,'\n');
+    }
+
+  //functions called
+  out.append(tabs+1,'\t');
+  out.append("        calls: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nCalledF; i++)
+    {
+      out.append(tabs+2,'\t');
+
+      int auxL = fcalls[i].name.length();
+      int remaining = 15-auxL;
+
+      if(remaining > 0)
+	{
+	  out.append(remaining,' ');
+	}
+      out.append(fcalls[i].name);
+      out.append(": ");
+
+      char callsChar[30];
+      sprintf(callsChar,"%20d",fcalls[i].calls);
+      
+      out.append(callsChar);
+      out.append(1,'\n');
+    }
+
+  return out;
+  
+}
+
+//Acces functions
+
+//Sort function
+
+void function_map::sort()
+{
+  //This function sort function and namespace names in function_map
+
+  //Namespaces
+  std::sort(namespaces, namespaces+nNamespaces);
+
+  //Function calls
+  std::sort(fcalls,fcalls+nCalledF);
+}
+
+void function_map::sort(const unsigned int* ranks)
+{
+  //This function sort function and namespace names in
+  //function_map comparing their ranks instead of their texts
+
+  //Namespaces
+  std::sort(namespaces, namespaces+nNamespaces,
+	    [ranks](const symbol& a, const symbol& b){return ranks[a.id()] < ranks[b.id()];});
+
+  //Function calls, by name and number of calls
+  std::sort(fcalls, fcalls+nCalledF,
+	    [ranks](const fcall& a, const fcall& b)
+	    {
+	      unsigned int ra = ranks[a.name.id()], rb = ranks[b.name.id()];
+	      return ra != rb ? ra < rb : a.calls < b.calls;
+	    });
+}
+
+//Operator =
+
+function_map& function_map::operator=(const function_map& c)
+{  
+  //Clear local function_map
+  clear();
+
+  //Copy all variables
+  nNamespaces    = c.nNamespaces;
+  nCalledF       = c.nCalledF;
+
+  maxNamespaces  = c.maxNamespaces;
+  maxCalledF     = c.maxCalledF;
+  
+  nOverload      = c.nOverload;
+
+  //Handle dinamic arrays and pointers
+
+  //namespaces
+  namespaces = 0;
+  if(maxNamespaces > 0)
+    {
+      namespaces = pool != 0 ? pool->allocArray<symbol>(maxNamespaces) : new symbol[maxNamespaces];
+      for(int i = 0; i < nNamespaces; i++)
+	{
+	  namespaces[i].assign(c.namespaces[i]);
+	}
+    }
+  
+  //fcalls
+  fcalls = 0;
+  if(maxCalledF > 0)
+    {
+      fcalls = pool != 0 ? pool->allocArray<fcall>(maxCalledF) : new fcall[maxCalledF];
+      for(int i = 0; i < nCalledF; i++)
+	{
+	  fcalls[i] = c.fcalls[i];
+	}
+    }
+
+  //Handle strings
+  name.assign(c.name);
+  sourceFile.assign(c.sourceFile);
+  
+  return (*this);
+}
+
+function_map& function_map::operator=(function_map&& c) noexcept
+{
+  //Take the arrays of 'c', which gets the cleared state
+  if(this != &c)
+    {
+      clear();
+      swap(c);
+    }
+  return (*this);
+}
+
+//Operator <
+
+bool function_map::operator<(const function_map& c) const
+{
+  //operator < used for sort function_map variables
+
+  int value = this->name.compare(c.name);
+  if(value < 0)
+    {
+      // The first character that does not match has a lower value in
+      // "this->name". Considere "this" smaller than "c".
+      return true;      
+    }
+  else if(value > 0)
+    {
+      // The first character that does not match has a lower value in
+      // "c.name". Considere "c" smaller than "this".
+      return false;      
+    }
+  else
+    {
+      // Both names are equal. Compare source files
+      value = this->sourceFile.compare(c.sourceFile);
+      if(value < 0)
+	{
+	  // The first character that does not match has a lower value in
+	  // "this->sourceFile". Considere "this" smaller than "c".
+	  return true;      
+	}
+      else if(value > 0)
+	{
+	  // The first character that does not match has a lower value in
+	  // "c.sourceFile" or both are equal. Don't considere "this" smaller than "c".
+	  return false;      
+	}
+      else
+	{
+	  //Check overload
+	  return (this->nOverload < c.nOverload);
+	}
+    }
+}
+
+//Operator >
+
+bool function_map::operator>(const function_map& c) const
+{
+  //operator > used for sort function_map variables
+
+  int value = this->name.compare(c.name);
+  if(value < 0)
+    {
+      // The first character that does not match has a lower value in
+      // "this->name". Considere "this" smaller than "c".
+      return false;      
+    }
+  else if(value > 0)
+    {
+      // The first character that does not match has a lower value in
+      // "c.name". Considere "c" smaller than "this".
+      return true;      
+    }
+  else
+    {
+      // Both names are equal. Compare source files
+      value = this->sourceFile.compare(c.sourceFile);
+      if(value < 0)
+	{
+	  // The first character that does not match has a lower value in
+	  // "this->sourceFile". Considere "this" smaller than "c".
+	  return false;      
+	}
+      else if (value > 0)
+	{
+	  // The first character that does not match has a lower value in
+	  // "c.sourceFile" or both are equal. Don't considere "this" smaller than "c".
+	  return true;      
+	}
+      else
+	{
+	  //Check overload
+	  return (this->nOverload > c.nOverload);
+	}
+    }
+}
+
+//Destructor
+
+function_map::~function_map()
+{
+  clear();
+}
+
+
+//**************************//
+//   mapped file functions  //
+//**************************//
+
+mapped_file::mapped_file() : pdata(""), length(0), mapped(false), modTime(0)
+{
+}
+
+//Jump buffer of the guarded read running in each thread
+static thread_local sigjmp_buf* busJump = 0;
+//SIGBUS action replaced by 'busHandler'
+static struct sigaction previousBus;
+static std::once_flag busInstalled;
+
+static void busHandler(int sig, siginfo_t* info, void* context)
+{
+  //Faults of a guarded read return to it
+  if(busJump != 0)
+    {
+      siglongjmp(*busJump, 1);
+    }
+
+  //Other faults go to the previous handler. Otherwise the
+  //default action is restored, so the fault is raised again
+  //with it when the instruction is repeated
+  if((previousBus.sa_flags & SA_SIGINFO) && previousBus.sa_sigaction != 0)
+    {
+      previousBus.sa_sigaction(sig, info, context);
+    }
+  else if(previousBus.sa_handler != SIG_DFL && previousBus.sa_handler != SIG_IGN)
+    {
+      previousBus.sa_handler(sig);
+    }
+  else
+    {
+      signal(SIGBUS, SIG_DFL);
+    }
+}
+
+static void installBusHandler()
+{
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+  action.sa_sigaction = busHandler;
+  action.sa_flags = SA_SIGINFO;
+  sigaction(SIGBUS, &action, &previousBus);
+}
+
+int mapped_file::open(const char* filename, bool copy)
+{
+  // This function maps the contents of the file specified
+  // by 'filename'. If the file can't be mapped (pipes,
+  // special files...) or 'copy' is set, the contents are
+  // read to 'buffer'.
+  //
+  // return 0 on succes
+  // return -1 if the file can't be opened
+  // return -2 if an error occurs reading the file
+
+  //Release previous contents
+  close();
+  
+  int fd = ::open(filename, O_RDONLY);
+  if(fd < 0)
+    {
+      return -1;
+    }
+
+  struct stat st;
+  bool statOK = fstat(fd, &st) == 0;
+  if(statOK)
+    {
+      modTime = 1000000000LL*(long long) st.st_mtim.tv_sec + (long long) st.st_mtim.tv_nsec;
+    }
+  if(!copy && statOK && S_ISREG(st.st_mode) && (std::size_t) st.st_size >= mapMinBytes)
+    {
+      //Large regular file, try to map it
+      void* paddr = mmap(0, (std::size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(paddr != MAP_FAILED)
+	{
+	  //The file will be read sequentially
+	  madvise(paddr, (std::size_t) st.st_size, MADV_SEQUENTIAL);
+	  
+	  pdata = (const char*) paddr;
+	  length = (std::size_t) st.st_size;
+	  mapped = true;
+	  ::close(fd);
+	  return 0;
+	}
+    }
+
+  //Can't be mapped, read the file until EOF. A file
+  //truncated while it is read gives shorter contents
+  if(statOK && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+      buffer.reserve((std::size_t) st.st_size);
+    }
+  char block[65536];
+  while(1)
+    {
+      ssize_t nread = read(fd, block, sizeof(block));
+      if(nread > 0)
+	{
+	  buffer.append(block, (std::size_t) nread);
+	}
+      else if(nread == 0)
+	{
+	  //End of file
+	  break;
+	}
+      else if(errno != EINTR)
+	{
+	  //Read error
+	  ::close(fd);
+	  buffer.clear();
+	  return -2;
+	}
+    }
+  ::close(fd);
+
+  pdata = buffer.c_str();
+  length = buffer.length();
+  return 0;
+}
+
+bool mapped_file::readMapped(const std::function<void()>& reader) const
+{
+  // This function calls 'reader' returning false if
+  // it raises SIGBUS reading the mapped pages.
+
+  if(!mapped)
+    {
+      reader();
+      return true;
+    }
+
+  std::call_once(busInstalled, installBusHandler);
+  sigjmp_buf jump;
+  sigjmp_buf* outer = busJump;
+  if(sigsetjmp(jump, 1) != 0)
+    {
+      //The file has been truncated while it was read
+      busJump = outer;
+      return false;
+    }
+  busJump = &jump;
+  reader();
+  busJump = outer;
+  return true;
+}
+
+void mapped_file::close()
+{
+  if(mapped)
+    {
+      munmap((void*) pdata, length);
+    }
+  buffer.clear();
+  pdata = "";
+  length = 0;
+  mapped = false;
+  modTime = 0;
+}
+
+mapped_file::~mapped_file()
+{
+  close();
+}
+
+//**************************//
+//   ingest stats functions //
+//**************************//
+
+ingest_stats::ingest_stats()
+{
+  clear();
+}
+
+void ingest_stats::clear()
+{
+  files = 0;
+  mappedFiles = 0;
+  cachedFiles = 0;
+  unbalancedFiles = 0;
+  bytes = 0;
+  readTime = 0.0;
+  parseTime = 0.0;
+}
+
+double ingest_stats::readMBps() const
+{
+  if(readTime <= 0.0){return 0.0;}
+  return ((double) bytes)/(1.0e6*readTime);
+}
+
+double ingest_stats::totalMBps() const
+{
+  double total = readTime + parseTime;
+  if(total <= 0.0){return 0.0;}
+  return ((double) bytes)/(1.0e6*total);
+}
+
+std::string ingest_stats::to_string(int tabs) const
+{
+  // This function convert the counters
+  // to formated string.
+  //
+  // 'tabs' variable specifies the number of
+  // inintial tabs to align the text
+
+  std::string out;
+  char aux[100];
+
+  out.append(tabs,'\t');
+  sprintf(aux,"        files: %lu (%lu mapped, %lu cached)\n",files,mappedFiles,cachedFiles);
+  out.append(aux);
+  out.append(tabs,'\t');
+  sprintf(aux,"   unbalanced: %lu\n",unbalancedFiles);
+  out.append(aux);
+  out.append(tabs,'\t');
+  sprintf(aux,"        bytes: %llu\n",bytes);
+  out.append(aux);
+  out.append(tabs,'\t');
+  sprintf(aux,"    read time: %.6f s (%.2f MB/s)\n",readTime,readMBps());
+  out.append(aux);
+  out.append(tabs,'\t');
+  sprintf(aux,"   parse time: %.6f s\n",parseTime);
+  out.append(aux);
+  out.append(tabs,'\t');
+  sprintf(aux,"   throughput: %.2f MB/s\n",totalMBps());
+  out.append(aux);
+  
+  return out;
+}
+
+//**************************//
+//     file map functions   //
+//**************************//
+
+file_map::file_map() : status(0), functions(0), nFunctions(0), names(0), nNames(0), unmatched(0), mapped(false), bytes(0), readTime(0.0), parseTime(0.0), mtime(0), hash(0), cached(false)
+{
+}
+
+static bool unchangedFile(const char* filename, std::size_t bytes, long long mtime)
+{
+  //Check the size and modification time of a read file
+  struct stat st;
+  if(stat(filename, &st) != 0)
+    return false;
+  long long current = 1000000000LL*(long long) st.st_mtim.tv_sec + (long long) st.st_mtim.tv_nsec;
+  return (std::size_t) st.st_size == bytes && current == mtime;
+}
+
+int file_map::load(const char* fname, const file_record* known, parse_cache* cache, bool copy)
+{
+  // This function maps the specified file. It
+  // doesn't use any shared state, so it can be
+  // called concurrently for different objects.
+  // If the content hash is the same than 'known'
+  // the file is not parsed. If the content is in
+  // 'cache', the functions are taken from it. If
+  // 'copy' is set, the file is read instead of mapped.
+  //
+  // return 0 on succes
+  // return 1 if the content has not changed
+  // return -1 if file can't be opened
+  // return -3 if there are not any function definition
+  //           in specified source file
+  //
+
+  //Release previous contents
+  clear();
+  filename.assign(fname);
+  
+  //Map the file
+  double tstart = wallTime();
+  mapped_file file;
+  if(file.open(fname, copy) != 0)
+    {
+      //Error reading the specified filename
+      status = -1;
+      return status;
+    }
+  mapped = file.isMapped();
+  bytes = file.size();
+  mtime = file.mtime();
+  if(!file.readMapped([&](){hash = contentHash(file.data(), file.size());}))
+    {
+      //The mapped file has been truncated, read it again
+      return load(fname, known, cache, true);
+    }
+  double tread = wallTime();
+  readTime = tread-tstart;
+
+  //If the file has been modified while it was read, the
+  //fingerprint doesn't match the content. Clear the time
+  //to check the file again in the next rescan
+  if(!unchangedFile(fname, bytes, mtime))
+    {
+      mtime = 0;
+    }
+
+  //Check if the content has changed
+  if(known != 0 && known->size == bytes && known->hash == hash)
+    {
+      status = 1;
+      return status;
+    }
+
+  //Look for a previous parse of this content
+  if(cache != 0 && cache->fetch(*this) == 0)
+    {
+      parseTime = wallTime()-tread;
+      return status;
+    }
+  
+  //Parse the code from mapped pages. The cleared
+  //text is stored once and shared by all functions.
+  //Mapped pages are only read while the text is copied
+  //to the reserved cleared code, so 'src' is valid if
+  //the file is truncated and the copy is interrupted
+  parsed_source src;
+  int readS = 0;
+  if(!file.readMapped([&](){readS = src.parse(file.data(), file.size());}))
+    {
+      return load(fname, known, cache, true);
+    }
+  file.close();
+  unmatched = src.keyMap().unmatched();
+
+  //Mapped pages are read again by the parser. Don't store
+  //the functions with the hash if the file has changed
+  if(mapped && mtime != 0 && !unchangedFile(fname, bytes, mtime))
+    {
+      mtime = 0;
+    }
+  if(mtime == 0)
+    {
+      cache = 0;
+    }
+  
+  if(src.numNames() == 0)
+    {
+      //No function definitions in specified source file
+      status = -3;
+      if(cache != 0){cache->store(*this);}
+      parseTime = wallTime()-tread;
+      return status;
+    }
+
+  //Store defined names
+  nNames = src.numNames();
+  names = new std::string[nNames];
+  for(int i = 0; i < nNames; i++)
+    {
+      names[i].assign(src.name(i));
+    }
+
+  //Extract information of each function
+  //defined in this source file
+  functions = new function_map[readS > 0 ? readS : 1];
+  symbol source(filename);
+  for(int i = 0; i < readS; i++)
+    {
+      functions[i].pool = &pool;
+      functions[i].loadFunction(src, i);
+
+      //Store source filename
+      functions[i].sourceFile = source;
+    }
+  nFunctions = readS;
+
+  status = 0;
+  if(cache != 0){cache->store(*this);}
+  parseTime = wallTime()-tread;
+  return status;
+}
+
+void file_map::clear()
+{
+  delete [] functions;
+  delete [] names;
+  pool.release();
+  functions = 0;
+  names = 0;
+  nFunctions = 0;
+  nNames = 0;
+  filename.clear();
+  status = 0;
+  unmatched = 0;
+  mapped = false;
+  bytes = 0;
+  readTime = 0.0;
+  parseTime = 0.0;
+  mtime = 0;
+  hash = 0;
+  cached = false;
+}
+
+file_map::~file_map()
+{
+  clear();
+}
+
+//**************************//
+//   parse cache functions  //
+//**************************//
+
+// Cache entry layout (native byte order):
+//
+//   magic "CMAPCACH", version, byte order mark,
+//   content hash, content size, payload size, payload hash
+//   payload: status, not matched keys, names, functions
+//
+// Strings are stored as length and characters. Each function
+// stores name, overload, namespaces and pairs name/calls.
+
+static const char cacheMagic[8] = {'C','M','A','P','C','A','C','H'};
+static const unsigned int cacheOrderMark = 0x01020304;
+static const std::size_t cacheHeaderSize = 8 + 2*sizeof(unsigned int) + 4*sizeof(unsigned long long);
+
+/// Append the raw bytes of 'value' to 'out'
+template<class T> static void cachePut(std::string& out, const T& value)
+{
+  out.append((const char*) &value, sizeof(T));
+}
+
+static void cachePutString(std::string& out, const std::string& value)
+{
+  cachePut(out, (unsigned int) value.length());
+  out.append(value);
+}
+
+/// Read a 'T' value from '[p,end)'. Return false if there are not enough bytes.
+template<class T> static bool cacheGet(const char*& p, const char* end, T& value)
+{
+  if((std::size_t) (end-p) < sizeof(T)){return false;}
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+static bool cacheGetString(const char*& p, const char* end, std::string& value)
+{
+  unsigned int length;
+  if(!cacheGet(p, end, length) || (std::size_t) (end-p) < length){return false;}
+  value.assign(p, length);
+  p += length;
+  return true;
+}
+
+/// Read a string and intern it
+static bool cacheGetString(const char*& p, const char* end, symbol& value)
+{
+  unsigned int length;
+  if(!cacheGet(p, end, length) || (std::size_t) (end-p) < length){return false;}
+  value = symbol(p, length);
+  p += length;
+  return true;
+}
+
+/// Read a non negative count not greater than 'max'
+static bool cacheGetCount(const char*& p, const char* end, int& value, std::size_t max)
+{
+  return cacheGet(p, end, value) && value >= 0 && (std::size_t) value <= max;
+}
+
+parse_cache::parse_cache() : maxBytes(0), totalBytes(0), nextTmp(0), hits(0), misses(0), stores(0)
+{}
+
+int parse_cache::open(const char* path, unsigned long long inMaxBytes)
+{
+  // This function opens (and creates if is necessary)
+  // the cache directory 'path'.
+  //
+  // return 0 on success
+  // return -1 if the directory can't be created
+  //
+
+  dir.clear();
+  std::string dirPath(path);
+  while(dirPath.length() > 1 && dirPath[dirPath.length()-1] == '/')
+    {
+      dirPath.erase(dirPath.length()-1);
+    }
+  if(dirPath.empty()){return -1;}
+
+  //Create each path component
+  for(std::size_t pos = dirPath.find('/', 1); ; pos = dirPath.find('/', pos+1))
+    {
+      std::string component(dirPath, 0, pos);
+      if(mkdir(component.c_str(), 0755) != 0 && errno != EEXIST)
+	{
+	  return -1;
+	}
+      if(pos == std::string::npos){break;}
+    }
+  struct stat st;
+  if(stat(dirPath.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+      return -1;
+    }
+
+  dir = dirPath;
+  maxBytes = inMaxBytes;
+  hits = 0;
+  misses = 0;
+  stores = 0;
+  trim();
+  return 0;
+}
+
+std::string parse_cache::entryPath(unsigned long long hash, unsigned long long size) const
+{
+  // Entries are distributed in 256 subdirectories
+  // by the first byte of the hash
+
+  char name[64];
+  sprintf(name, "/%02x/%016llx-%llx.cme", (unsigned int) (hash >> 56), hash, size);
+  return dir + name;
+}
+
+int parse_cache::fetch(file_map& file)
+{
+  // This function fills 'file' with the entry of
+  // his content, if exists and is valid.
+  //
+  // return 0 on success
+  // return -1 if there is no valid entry
+  //
+
+  if(dir.empty()){return -1;}
+  
+  std::string path = entryPath(file.hash, file.bytes);
+  std::string entry;
+  if(readFile(path.c_str(), entry) != 0 || entry.length() < cacheHeaderSize)
+    {
+      misses++;
+      return -1;
+    }
+
+  //Check header
+  const char* p = entry.data();
+  const char* end = p + entry.length();
+  unsigned int entryVersion, orderMark;
+  unsigned long long hash, size, payloadSize, payloadHash;
+  if(memcmp(p, cacheMagic, 8) != 0){misses++; return -1;}
+  p += 8;
+  cacheGet(p, end, entryVersion);
+  cacheGet(p, end, orderMark);
+  cacheGet(p, end, hash);
+  cacheGet(p, end, size);
+  cacheGet(p, end, payloadSize);
+  cacheGet(p, end, payloadHash);
+  if(entryVersion != version || orderMark != cacheOrderMark ||
+     hash != file.hash || size != file.bytes ||
+     payloadSize != (unsigned long long) (end-p) ||
+     payloadHash != contentHash(p, end-p))
+    {
+      misses++;
+      return -1;
+    }
+
+  //Read payload. Counts are bounded by the remaining bytes
+  int status, unmatched, nNames, nFunctions;
+  std::size_t remaining = end-p;
+  if(!cacheGet(p, end, status) || (status != 0 && status != -3) ||
+     !cacheGet(p, end, unmatched) ||
+     !cacheGetCount(p, end, nNames, remaining) ||
+     !cacheGetCount(p, end, nFunctions, remaining))
+    {
+      misses++;
+      return -1;
+    }
+
+  std::string* names = new std::string[nNames > 0 ? nNames : 1];
+  function_map* functions = new function_map[nFunctions > 0 ? nFunctions : 1];
+  symbol source(file.filename);
+  bool valid = true;
+  for(int i = 0; valid && i < nNames; i++)
+    {
+      valid = cacheGetString(p, end, names[i]);
+    }
+  for(int i = 0; valid && i < nFunctions; i++)
+    {
+      function_map& f = functions[i];
+      f.pool = &file.pool;
+      int nNS, nCalls;
+      valid = cacheGetString(p, end, f.name) && cacheGet(p, end, f.nOverload) &&
+	cacheGetCount(p, end, nNS, remaining);
+      if(!valid){break;}
+      if(nNS > 0)
+	{
+	  f.namespaces = file.pool.allocArray<symbol>(nNS);
+	  f.maxNamespaces = nNS;
+	}
+      for(int j = 0; valid && j < nNS; j++)
+	{
+	  valid = cacheGetString(p, end, f.namespaces[j]);
+	  f.nNamespaces = j+1;
+	}
+      valid = valid && cacheGetCount(p, end, nCalls, remaining);
+      if(!valid){break;}
+      if(nCalls > 0)
+	{
+	  f.fcalls = file.pool.allocArray<fcall>(nCalls);
+	  f.maxCalledF = nCalls;
+	}
+      for(int j = 0; valid && j < nCalls; j++)
+	{
+	  valid = cacheGetString(p, end, f.fcalls[j].name) && cacheGet(p, end, f.fcalls[j].calls);
+	  f.nCalledF = j+1;
+	}
+      f.sourceFile = source;
+    }
+  if(!valid || p != end)
+    {
+      delete [] names;
+      delete [] functions;
+      misses++;
+      return -1;
+    }
+
+  //Mark entry as recently used
+  struct timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_NOW;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+  utimensat(AT_FDCWD, path.c_str(), times, 0);
+
+  delete [] file.names;
+  delete [] file.functions;
+  file.names = names;
+  file.nNames = nNames;
+  file.functions = functions;
+  file.nFunctions = nFunctions;
+  file.unmatched = unmatched;
+  file.status = status;
+  file.cached = true;
+  hits++;
+  return 0;
+}
+
+int parse_cache::store(const file_map& file)
+{
+  // This function writes the entry of 'file'.
+  // The entry is written in a temporary file
+  // and renamed, so readers never see partial
+  // entries.
+  //
+  // return 0 on success
+  // return -1 if the entry can't be written
+  //
+
+  if(dir.empty()){return -1;}
+
+  //Serialize payload
+  std::string payload;
+  cachePut(payload, file.status);
+  cachePut(payload, file.unmatched);
+  cachePut(payload, file.nNames);
+  cachePut(payload, file.nFunctions);
+  for(int i = 0; i < file.nNames; i++)
+    {
+      cachePutString(payload, file.names[i]);
+    }
+  for(int i = 0; i < file.nFunctions; i++)
+    {
+      const function_map& f = file.functions[i];
+      cachePutString(payload, f.name);
+      cachePut(payload, f.nOverload);
+      cachePut(payload, f.nNamespaces);
+      for(int j = 0; j < f.nNamespaces; j++)
+	{
+	  cachePutString(payload, f.namespaces[j]);
+	}
+      cachePut(payload, f.nCalledF);
+      for(int j = 0; j < f.nCalledF; j++)
+	{
+	  cachePutString(payload, f.fcalls[j].name);
+	  cachePut(payload, f.fcalls[j].calls);
+	}
+    }
+
+  //Header
+  std::string entry(cacheMagic, 8);
+  cachePut(entry, (unsigned int) version);
+  cachePut(entry, cacheOrderMark);
+  cachePut(entry, file.hash);
+  cachePut(entry, file.bytes);
+  cachePut(entry, (unsigned long long) payload.length());
+  cachePut(entry, contentHash(payload.data(), payload.length()));
+  entry.append(payload);
+
+  //Write a temporary file
+  char tmpName[64];
+  sprintf(tmpName, "/tmp-%ld-%lu", (long) getpid(), (unsigned long) nextTmp++);
+  std::string tmpPath = dir + tmpName;
+  int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if(fd < 0){return -1;}
+  std::size_t written = 0;
+  while(written < entry.length())
+    {
+      ssize_t n = write(fd, entry.data()+written, entry.length()-written);
+      if(n < 0 && errno == EINTR){continue;}
+      if(n <= 0){break;}
+      written += n;
+    }
+  if(close(fd) != 0 || written < entry.length())
+    {
+      unlink(tmpPath.c_str());
+      return -1;
+    }
+
+  //Move it to his final location
+  std::string path = entryPath(file.hash, file.bytes);
+  if(rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+      //Create the subdirectory and try again
+      std::string subdir(path, 0, path.rfind('/'));
+      if(mkdir(subdir.c_str(), 0755) != 0 && errno != EEXIST)
+	{
+	  unlink(tmpPath.c_str());
+	  return -1;
+	}
+      if(rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+	  unlink(tmpPath.c_str());
+	  return -1;
+	}
+    }
+  stores++;
+  
+  //Check the size limit
+  if((totalBytes += entry.length()) > maxBytes)
+    {
+      trim();
+    }
+  return 0;
+}
+
+int parse_cache::trim()
+{
+  // This function removes the least recently used
+  // entries if the cache is over his size limit.
+  //
+  // return the number of removed entries
+  //
+
+  if(dir.empty()){return 0;}
+  std::lock_guard<std::mutex> guard(trimMutex);
+
+  //Collect entries: access time, size and path
+  std::vector< std::pair< std::pair<long long,unsigned long long>, std::string> > entries;
+  unsigned long long total = 0;
+  time_t now = time(0);
+  std::vector<std::string> subdirs(1, dir);
+  for(std::size_t k = 0; k < subdirs.size(); k++)
+    {
+      DIR* pdir = opendir(subdirs[k].c_str());
+      if(pdir == 0){continue;}
+      struct dirent* entry;
+      while((entry = readdir(pdir)) != 0)
+	{
+	  const char* name = entry->d_name;
+	  if(name[0] == '.'){continue;}
+	  std::string path = subdirs[k] + "/" + name;
+	  struct stat st;
+	  if(lstat(path.c_str(), &st) != 0){continue;}
+	  if(S_ISDIR(st.st_mode))
+	    {
+	      if(k == 0){subdirs.push_back(path);}
+	    }
+	  else if(k == 0 && strncmp(name, "tmp-", 4) == 0)
+	    {
+	      //Temporary files of interrupted processes
+	      if(now - st.st_mtime > 3600){unlink(path.c_str());}
+	    }
+	  else if(k > 0 && S_ISREG(st.st_mode))
+	    {
+	      long long atime = 1000000000LL*(long long) st.st_atim.tv_sec + (long long) st.st_atim.tv_nsec;
+	      entries.push_back(std::make_pair(std::make_pair(atime, (unsigned long long) st.st_size), path));
+	      total += st.st_size;
+	    }
+	}
+      closedir(pdir);
+    }
+
+  //Remove least recently used entries
+  int removed = 0;
+  if(total > maxBytes)
+    {
+      std::sort(entries.begin(), entries.end());
+      unsigned long long target = maxBytes - maxBytes/4;
+      for(std::size_t i = 0; i < entries.size() && total > target; i++)
+	{
+	  if(unlink(entries[i].second.c_str()) == 0)
+	    {
+	      total -= entries[i].first.second;
+	      removed++;
+	    }
+	}
+    }
+  totalBytes = total;
+  return removed;
+}
+
+//**************************//
+//  source stream functions //
+//**************************//
+
+//Minimum length of units ended by a ';'
+const std::size_t source_stream::minUnit;
+
+//Lexer states of source_stream
+enum {STREAM_CODE, STREAM_STRING, STREAM_CHAR, STREAM_LINE_COMMENT, STREAM_BLOCK_COMMENT};
+
+//Incremental steps of contentHash (see auxiliar functions)
+static void hashInit(unsigned long long lanes[4]);
+static std::size_t hashBlocks(unsigned long long lanes[4], const char* data, std::size_t length);
+static unsigned long long hashFinish(const unsigned long long lanes[4], unsigned long long length, const char* tail, std::size_t ntail);
+
+source_stream::source_stream()
+{
+  reset();
+}
+
+void source_stream::reset()
+{
+  state = STREAM_CODE;
+  prev = 0;
+  star = false;
+  code.clear();
+  start = 0;
+  scanned = 0;
+  cut = 0;
+  cuts.clear();
+  braces = 0;
+  parens = 0;
+  overloads.clear();
+  nremoved = 0;
+  nunmatched = 0;
+  stopped = false;
+  peak = 0;
+  length = 0;
+  hashInit(lanes);
+  hashTail.clear();
+  fullHash = 0;
+}
+
+void source_stream::clearText(const char* text, std::size_t n)
+{
+  // This function removes strings and comments of 'text'
+  // appending the remaining code to 'code'. The removed
+  // segments are the same than 'clearCode' removes, but
+  // the lexer state is kept between calls.
+
+  std::size_t i = 0;
+  while(i < n)
+    {
+      if(state == STREAM_STRING || state == STREAM_CHAR || state == STREAM_LINE_COMMENT)
+	{
+	  //Find next non slashed limit
+	  const char limit = state == STREAM_STRING ? '"' : (state == STREAM_CHAR ? '\'' : '\n');
+	  const char* pfound = (const char*) memchr(text+i, limit, n-i);
+	  if(pfound == 0)
+	    {
+	      prev = text[n-1];
+	      return;
+	    }
+	  std::size_t found = pfound-text;
+	  const char before = found > i ? text[found-1] : prev;
+	  if(before == '\\')
+	    {
+	      prev = limit;
+	      i = found+1;
+	      continue;
+	    }
+	  //Keep the new line character of line comments
+	  i = state == STREAM_LINE_COMMENT ? found : found+1;
+	  state = STREAM_CODE;
+	  continue;
+	}
+      
+      if(state == STREAM_BLOCK_COMMENT)
+	{
+	  //Remove until next */
+	  if(star)
+	    {
+	      star = false;
+	      if(text[i] == '/')
+		{
+		  state = STREAM_CODE;
+		  i++;
+		  continue;
+		}
+	    }
+	  const char* pfound = (const char*) memchr(text+i, '*', n-i);
+	  if(pfound == 0)
+	    {
+	      return;
+	    }
+	  i = pfound-text+1;
+	  star = true;
+	  continue;
+	}
+
+      const char c = text[i];
+      
+      //Check if previous character is a slash
+      const std::size_t size = code.size();
+      bool scapped = size > 0 && code[size-1] == '\\';
+
+      if(c == '"' || c == '\'')
+	{
+	  i++;
+	  if(scapped)
+	    {
+	      //Scapped quote, copy it
+	      code.push_back(c);
+	      continue;
+	    }
+	  nremoved++;
+	  state = c == '"' ? STREAM_STRING : STREAM_CHAR;
+	  prev = c;
+	  continue;
+	}
+
+      //Comments. The opening '/' is always copied and
+      //removed when the next character opens a comment
+      if((c == '/' || c == '*') && size > 0 && code[size-1] == '/' &&
+	 (size < 2 || code[size-2] != '\\'))
+	{
+	  code.erase(size-1);
+	  nremoved++;
+	  i++;
+	  if(c == '/')
+	    {
+	      state = STREAM_LINE_COMMENT;
+	      prev = c;
+	    }
+	  else
+	    {
+	      state = STREAM_BLOCK_COMMENT;
+	      star = true;
+	    }
+	  continue;
+	}
+
+      //Code character. Copy the following run of characters
+      //that can't open a string nor a comment
+      code.push_back(c);
+      i++;
+      if(c != '/')
+	{
+	  std::size_t run = scanCode(text+i, n-i);
+	  code.append(text+i, run);
+	  i += run;
+	}
+    }
+}
+
+void source_stream::findCuts()
+{
+  // This function looks for the end of top level units:
+  // positions after a '}' outside any block and parenthesis,
+  // or after a ';' if the unit is long enough. The last
+  // character is not checked if it is a '/', because
+  // it can be removed by a comment opening.
+
+  std::size_t end = code.size();
+  if(end > scanned && code[end-1] == '/'){end--;}
+  for(; scanned < end; scanned++)
+    {
+      switch(code[scanned])
+	{
+	case '{':
+	  braces++;
+	  break;
+	case '}':
+	  if(braces > 0){braces--;}
+	  if(braces == 0 && parens == 0)
+	    {
+	      cut = scanned+1;
+	      cuts.push_back(cut);
+	    }
+	  break;
+	case '(':
+	  if(braces == 0){parens++;}
+	  break;
+	case ')':
+	  if(braces == 0 && parens > 0){parens--;}
+	  break;
+	case ';':
+	  if(braces == 0 && parens == 0 && scanned+1-cut >= minUnit)
+	    {
+	      cut = scanned+1;
+	      cuts.push_back(cut);
+	    }
+	  break;
+	default:
+	  break;
+	}
+    }
+}
+
+void source_stream::parseUnit(std::size_t end, bool last, file_map& out, int& maxF, int& maxN)
+{
+  // This function extracts the functions defined in
+  // code interval [start,end) and appends them to 'out'.
+  // 'maxF' and 'maxN' are the sizes of 'out' arrays.
+  // If the unit ends waiting for a body and is not the
+  // 'last' one, it is joined to the next unit.
+
+  if(end <= start){return;}
+  std::string unit(code, start, end-start);
+
+  key_map keys;
+  int unmatched = keys.build(unit);
+  std::string* names = 0;
+  function_span* spans = 0;
+  int nspans = 0;
+  int nnames = 0;
+  if(!stopped)
+    {
+      //A whole-code scan doesn't reach the units
+      //after it stops
+      int ending = 0;
+      nnames = definedFunc(unit, keys, names, spans, nspans, &ending);
+      if(ending == 2 && !last)
+	{
+	  delete [] names;
+	  delete [] spans;
+	  return;
+	}
+      stopped = ending == 1;
+    }
+  start = end;
+  nunmatched += unmatched;
+
+  //Check output arrays size
+  if(out.nNames + nnames > maxN)
+    {
+      maxN = 2*(out.nNames + nnames);
+      std::string* aux = new std::string[maxN];
+      for(int i = 0; i < out.nNames; i++){aux[i].swap(out.names[i]);}
+      delete [] out.names;
+      out.names = aux;
+    }
+  if(out.nFunctions + nspans > maxF)
+    {
+      maxF = 2*(out.nFunctions + nspans);
+      function_map* aux = new function_map[maxF];
+      for(int i = 0; i < out.nFunctions; i++){aux[i].swap(out.functions[i]);}
+      delete [] out.functions;
+      out.functions = aux;
+    }
+  
+  //Number overloads from the beginning of the source
+  //and store the names found for the first time
+  int* previous = new int[nnames > 0 ? nnames : 1];
+  for(int i = 0; i < nnames; i++)
+    {
+      int& count = overloads[names[i]];
+      previous[i] = count;
+      if(count == 0)
+	{
+	  out.names[out.nNames++].assign(names[i]);
+	}
+    }
+  for(int i = 0; i < nspans; i++)
+    {
+      function_span span = spans[i];
+      span.overload += previous[span.name];
+      out.functions[out.nFunctions].pool = &out.pool;
+      out.functions[out.nFunctions++].loadFunction(unit, span, names[span.name].c_str(), keys);
+      overloads[names[span.name]]++;
+    }
+
+  delete [] previous;
+  delete [] names;
+  delete [] spans;
+}
+
+int source_stream::parseCode(std::size_t end, bool last, file_map& out)
+{
+  // This function parses each complete unit until
+  // 'end' and stores the extracted functions in 'out'.
+  //
+  // return the number of extracted functions
+  //
+
+  delete [] out.functions;
+  delete [] out.names;
+  out.functions = 0;
+  out.names = 0;
+  out.nFunctions = 0;
+  out.nNames = 0;
+  int maxF = 0, maxN = 0;
+
+  for(std::size_t i = 0; i < cuts.size(); i++)
+    {
+      parseUnit(cuts[i], false, out, maxF, maxN);
+    }
+  cuts.clear();
+  parseUnit(end, last, out, maxF, maxN);
+  return out.nFunctions;
+}
+
+int source_stream::feed(const char* text, std::size_t n, file_map& out)
+{
+  // This function processes the next chunk of
+  // the source.
+  //
+  // return the number of completed functions
+  //
+
+  //Hash the received bytes in 32 bytes blocks
+  length += n;
+  std::size_t hashed = 0;
+  if(!hashTail.empty())
+    {
+      hashed = std::min(n, 32-hashTail.size());
+      hashTail.append(text, hashed);
+      if(hashTail.size() == 32)
+	{
+	  hashBlocks(lanes, hashTail.data(), 32);
+	  hashTail.clear();
+	}
+    }
+  hashed += hashBlocks(lanes, text+hashed, n-hashed);
+  hashTail.append(text+hashed, n-hashed);
+
+  //Clear the code and look for cut points
+  clearText(text, n);
+  if(code.size() > peak){peak = code.size();}
+  findCuts();
+
+  //Parse the completed units
+  int nfunctions = parseCode(cut, false, out);
+  
+  //Discard parsed code, keeping the last characters
+  //which are used to detect scapes and comments
+  const std::size_t keep = 16;
+  if(start > keep && start >= code.size()/2)
+    {
+      std::size_t drop = start-keep;
+      code.erase(0, drop);
+      start -= drop;
+      scanned -= drop;
+      cut -= drop;
+    }
+  return nfunctions;
+}
+
+int source_stream::finish(file_map& out)
+{
+  // This function parses the remaining code.
+  //
+  // return the number of extracted functions
+  //
+
+  switch(state)
+    {
+    case STREAM_STRING:
+      printf("clearCode:warning: Non limited string (\"__\")\n");
+      break;
+    case STREAM_CHAR:
+      printf("clearCode:warning: Non limited char ('__')\n");
+      break;
+    case STREAM_LINE_COMMENT:
+      printf("clearCode:warning: Non limited comment (//__\\n)\n");
+      break;
+    case STREAM_BLOCK_COMMENT:
+      printf("clearCode:warning: Non limited comment (/*__*/n)\n");
+      break;
+    default:
+      break;
+    }
+  state = STREAM_CODE;
+  
+  int nfunctions = parseCode(code.size(), true, out);
+  scanned = cut = code.size();
+  fullHash = hashFinish(lanes, length, hashTail.data(), hashTail.size());
+  return nfunctions;
+}
+
+//**************************//
+//  crawl options functions //
+//**************************//
+
+crawl_options::crawl_options() : extensions(0), nExtensions(0), maxExtensions(0), excludes(0), nExcludes(0), maxExcludes(0), followLinks(false), threads(0)
+{
+  //Default C/C++ extensions
+  const char* defaults[] = {".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx"};
+  for(unsigned int i = 0; i < sizeof(defaults)/sizeof(defaults[0]); i++)
+    {
+      addExtension(defaults[i]);
+    }
+}
+
+crawl_options::crawl_options(const crawl_options& c) : extensions(0), nExtensions(0), maxExtensions(0), excludes(0), nExcludes(0), maxExcludes(0), followLinks(false), threads(0)
+{
+  (*this) = c; //Copy object C
+}
+
+crawl_options& crawl_options::operator=(const crawl_options& c)
+{
+  if(this == &c){return *this;}
+
+  clearExtensions();
+  clearExcludes();
+  for(int i = 0; i < c.nExtensions; i++)
+    {
+      addExtension(c.extensions[i].c_str());
+    }
+  for(int i = 0; i < c.nExcludes; i++)
+    {
+      addExclude(c.excludes[i].c_str());
+    }
+  followLinks = c.followLinks;
+  threads = c.threads;
+  return *this;
+}
+
+void crawl_options::append(std::string*& array, int& n, int& max, const char* value)
+{
+  //Check array size
+  if(n >= max)
+    {
+      int dim = max == 0 ? 8 : 2*max;
+      std::string* auxp = array;
+      array = new std::string[dim];
+      for(int i = 0; i < n; i++)
+	{
+	  array[i].swap(auxp[i]);
+	}
+      delete [] auxp;
+      max = dim;
+    }
+  array[n].assign(value);
+  n++;
+}
+
+void crawl_options::addExtension(const char* extension)
+{
+  append(extensions, nExtensions, maxExtensions, extension);
+}
+
+void crawl_options::clearExtensions()
+{
+  delete [] extensions;
+  extensions = 0;
+  nExtensions = 0;
+  maxExtensions = 0;
+}
+
+void crawl_options::addExclude(const char* pattern)
+{
+  append(excludes, nExcludes, maxExcludes, pattern);
+}
+
+void crawl_options::clearExcludes()
+{
+  delete [] excludes;
+  excludes = 0;
+  nExcludes = 0;
+  maxExcludes = 0;
+}
+
+bool crawl_options::accepted(const char* name) const
+{
+  // This function checks if the file 'name' ends
+  // with some accepted extension. If there are not
+  // extensions, all files are accepted.
+
+  if(nExtensions == 0){return true;}
+  
+  std::size_t length = strlen(name);
+  for(int i = 0; i < nExtensions; i++)
+    {
+      std::size_t extLength = extensions[i].length();
+      if(extLength <= length && extensions[i].compare(0, extLength, name+length-extLength) == 0)
+	{
+	  return true;
+	}
+    }
+  return false;
+}
+
+bool crawl_options::excluded(const char* relPath, const char* name, bool isDir) const
+{
+  // This function checks if some exclude pattern
+  // matches the specified entry.
+
+  for(int i = 0; i < nExcludes; i++)
+    {
+      std::string pattern(excludes[i]);
+
+      //A final '/' only matches directories
+      if(pattern.length() > 1 && pattern[pattern.length()-1] == '/')
+	{
+	  if(!isDir){continue;}
+	  pattern.erase(pattern.length()-1);
+	}
+
+      //Patterns with '/' are matched with the relative path
+      if(pattern.find('/') != std::string::npos)
+	{
+	  if(fnmatch(pattern.c_str(), relPath, FNM_PATHNAME) == 0){return true;}
+	}
+      else if(fnmatch(pattern.c_str(), name, 0) == 0)
+	{
+	  return true;
+	}
+    }
+  return false;
+}
+
+crawl_options::~crawl_options()
+{
+  clearExtensions();
+  clearExcludes();
+}
+
+//**************************//
+//   json parser functions  //
+//**************************//
+
+/// Skip JSON whitespaces
+static inline void jsonSpace(const char*& p, const char* end)
+{
+  while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')){p++;}
+}
+
+/// Read 4 hexadecimal digits. Return -1 on error.
+static long jsonHex(const char* p, const char* end)
+{
+  if(end-p < 4){return -1;}
+  long value = 0;
+  for(int i = 0; i < 4; i++)
+    {
+      char c = p[i];
+      value <<= 4;
+      if(c >= '0' && c <= '9'){value |= c-'0';}
+      else if(c >= 'a' && c <= 'f'){value |= c-'a'+10;}
+      else if(c >= 'A' && c <= 'F'){value |= c-'A'+10;}
+      else{return -1;}
+    }
+  return value;
+}
+
+/// Read the JSON string that begins at 'p' (on '"') and store it in 'out'. Return false on error.
+static bool jsonString(const char*& p, const char* end, std::string& out)
+{
+  out.clear();
+  if(p >= end || *p != '"'){return false;}
+  p++;
+  while(p < end)
+    {
+      //Copy characters until next quote or escape
+      const char* start = p;
+      while(p < end && *p != '"' && *p != '\\'){p++;}
+      out.append(start, p-start);
+      if(p >= end){return false;}
+      if(*p == '"')
+	{
+	  p++;
+	  return true;
+	}
+
+      //Escaped character
+      p++;
+      if(p >= end){return false;}
+      switch(*p)
+	{
+	case '"':  out.append(1,'"');  break;
+	case '\\': out.append(1,'\\'); break;
+	case '/':  out.append(1,'/');  break;
+	case 'b':  out.append(1,'\b'); break;
+	case 'f':  out.append(1,'\f'); break;
+	case 'n':  out.append(1,'\n'); break;
+	case 'r':  out.append(1,'\r'); break;
+	case 't':  out.append(1,'\t'); break;
+	case 'u':
+	  {
+	    long code = jsonHex(p+1, end);
+	    if(code < 0){return false;}
+	    p += 4;
+	    //Surrogate pair
+	    if(code >= 0xD800 && code <= 0xDBFF && end-p > 6 && p[1] == '\\' && p[2] == 'u')
+	      {
+		long low = jsonHex(p+3, end);
+		if(low >= 0xDC00 && low <= 0xDFFF)
+		  {
+		    code = 0x10000 + ((code-0xD800) << 10) + (low-0xDC00);
+		    p += 6;
+		  }
+	      }
+	    //Encode as UTF-8
+	    if(code < 0x80){out.append(1,(char) code);}
+	    else if(code < 0x800)
+	      {
+		out.append(1,(char) (0xC0 | (code >> 6)));
+		out.append(1,(char) (0x80 | (code & 0x3F)));
+	      }
+	    else if(code < 0x10000)
+	      {
+		out.append(1,(char) (0xE0 | (code >> 12)));
+		out.append(1,(char) (0x80 | ((code >> 6) & 0x3F)));
+		out.append(1,(char) (0x80 | (code & 0x3F)));
+	      }
+	    else
+	      {
+		out.append(1,(char) (0xF0 | (code >> 18)));
+		out.append(1,(char) (0x80 | ((code >> 12) & 0x3F)));
+		out.append(1,(char) (0x80 | ((code >> 6) & 0x3F)));
+		out.append(1,(char) (0x80 | (code & 0x3F)));
+	      }
+	    break;
+	  }
+	default:
+	  return false;
+	}
+      p++;
+    }
+  return false;
+}
+
+/// Skip the JSON value that begins at 'p'. Return false on error.
+static bool jsonSkip(const char*& p, const char* end)
+{
+  std::string aux;
+  int depth = 0;
+  do
+    {
+      jsonSpace(p, end);
+      if(p >= end){return false;}
+      const char c = *p;
+      if(c == '"')
+	{
+	  if(!jsonString(p, end, aux)){return false;}
+	}
+      else if(c == '{' || c == '[')
+	{
+	  depth++;
+	  p++;
+	}
+      else if(c == '}' || c == ']')
+	{
+	  if(depth == 0){return false;}
+	  depth--;
+	  p++;
+	}
+      else if(c == ',' || c == ':')
+	{
+	  if(depth == 0){return false;}
+	  p++;
+	}
+      else
+	{
+	  //Number, true, false or null
+	  while(p < end && *p != ',' && *p != ':' && *p != ']' && *p != '}' &&
+		*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r'){p++;}
+	}
+    }while(depth > 0);
+  return true;
+}
+
+//**************************//
+//   source map functions   //
+//**************************//
+
+//Constructor
+
+source_map::source_map()
+{
+  nNamespaces = 0;
+  nFunctions = 0;
+  nFnames = 0;
+  nNamespaceMaps = 0;
+
+  maxFunctions = 0;
+  maxFnames = 0;
+  maxNamespaces = 0;
+  maxNamespaceMaps = 0;
+  
+  namespaces = 0;
+  defFuncNames = 0;
+  functions = 0;
+  namespaceMaps = 0;
+
+  nFiles = 0;
+  maxFiles = 0;
+  files = 0;
+
+  cache = 0;
+  poolCheck = 0;
+  liveMaps++;
+}
+
+//Load function
+
+int source_map::loadSource(const char* filename)
+{
+  // This function create a map from specified
+  // filename file. The map will be cleared
+  // before the new load.
+  //
+  // return 0 on succes
+  // return -1 if file can't be opened
+  // return -2 if an error clearing the code occurs
+  // return -3 if there are not any function definition
+  //           in specified source file
+  //
+
+  //Clear map
+  clear();
+  
+  return appendSource(filename);
+}
+
+//Append map function
+
+int source_map::appendSource(const char* filename)
+{
+  // This function create a map from specified
+  // filename file. The new map will be appended
+  // to existing maps.
+  //
+  // return 0 on succes
+  // return -1 if file can't be opened
+  // return -2 if an error clearing the code occurs
+  // return -3 if there are not any function definition
+  //           in specified source file
+  //
+
+  //Map the file
+  file_map file;
+  file.load(filename, 0, cache);
+
+  //Merge the extracted functions
+  return merge(file);
+}
+
+int source_map::appendSourceStream(const char* filename, std::size_t window)
+{
+  // This function maps the specified file reading
+  // it in chunks of 'window' bytes. Functions are
+  // appended as they are completed.
+  //
+  // return 0 on succes
+  // return -1 if file can't be opened
+  // return -2 if an error occurs reading the file
+  // return -3 if there are not any function definition
+  //           in specified source file
+  //
+
+  int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      return -1;
+    }
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    {
+      close(fd);
+      return -1;
+    }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  //Use a multiple of the hash block size
+  window = window < 4096 ? 4096 : window - window%32;
+  char* buffer = new char[window];
+  source_stream stream;
+  file_map batch;
+  symbol source(filename);
+  batch.filename.assign(filename);
+  int firstF = nFunctions;
+  int err = 0;
+  double readTime = 0.0, parseTime = 0.0;
+  while(1)
+    {
+      //Fill the buffer
+      double tstart = wallTime();
+      std::size_t n = 0;
+      while(n < window)
+	{
+	  ssize_t nread = read(fd, buffer+n, window-n);
+	  if(nread < 0 && errno == EINTR){continue;}
+	  if(nread < 0){err = -2; break;}
+	  if(nread == 0){break;}
+	  n += nread;
+	}
+      double tread = wallTime();
+      readTime += tread-tstart;
+      if(err != 0){break;}
+      
+      //Parse it and append completed functions
+      bool last = n < window;
+      stream.feed(buffer, n, batch);
+      if(batch.nFunctions > 0)
+	{
+	  for(int i = 0; i < batch.nFunctions; i++)
+	    {
+	      batch.functions[i].sourceFile = source;
+	    }
+	  appendFunctions(batch);
+	}
+      parseTime += wallTime()-tread;
+      if(last){break;}
+    }
+  close(fd);
+  delete [] buffer;
+
+  //Remaining code
+  double tstart = wallTime();
+  stream.finish(batch);
+  if(batch.nFunctions > 0)
+    {
+      for(int i = 0; i < batch.nFunctions; i++)
+	{
+	  batch.functions[i].sourceFile = source;
+	}
+      appendFunctions(batch);
+    }
+  parseTime += wallTime()-tstart;
+  if(err != 0)
+    {
+      //The file is not recorded, remove the
+      //functions appended from it
+      for(int i = firstF; i < nFunctions; i++)
+	{
+	  markRemoved(i);
+	}
+      dropNames();
+      collectRemoved();
+      return err;
+    }
+
+  //Store file fingerprint and counters
+  batch.bytes = stream.bytes();
+  batch.mtime = 1000000000LL*(long long) st.st_mtim.tv_sec + (long long) st.st_mtim.tv_nsec;
+  batch.hash = stream.hash();
+  recordFile(batch);
+  stats.files++;
+  stats.bytes += batch.bytes;
+  stats.readTime += readTime;
+  stats.parseTime += parseTime;
+  if(stream.unmatched() > 0)
+    {
+      printf("appendSource:warning: %d not matched keys in %s\n",stream.unmatched(),filename);
+      stats.unbalancedFiles++;
+    }
+
+#ifdef __CODE_MAP_DEBUG__
+  //Streamed functions must be the same than parsing
+  //the whole file, unless some keys are not matched
+  parsed_source whole;
+  if(whole.load(filename) >= 0 && whole.keyMap().unmatched() == 0)
+    {
+      int nmissing = 0;
+      for(int i = firstF; i < nFunctions; i++)
+	{
+	  if(whole.find(functions[i].name.str().c_str(), functions[i].nOverload) < 0){nmissing++;}
+	}
+      if(nmissing > 0 || whole.numSpans() != nFunctions-firstF)
+	{
+	  printf("appendSourceStream:warning: %d functions streamed (%d not found) but %d parsed in %s\n",
+		 nFunctions-firstF,nmissing,whole.numSpans(),filename);
+	}
+    }
+#endif
+  
+  return stream.numNames() == 0 ? -3 : 0;
+}
+
+/// Run 'task(i)' for each 'i' in [0,n) using 'threads' threads (one per cpu if is not positive)
+static void parallelFor(int n, int threads, const std::function<void(int)>& task)
+{
+  if(threads <= 0)
+    {
+      threads = (int) std::thread::hardware_concurrency();
+      if(threads <= 0){threads = 1;}
+    }
+  if(threads > n){threads = n;}
+  if(threads <= 0){return;}
+
+  //Each worker takes the next not processed element
+  std::atomic<int> next(0);
+  auto worker = [&]()
+    {
+      int i;
+      while((i = next.fetch_add(1)) < n)
+	{
+	  task(i);
+	}
+    };
+
+  std::thread* pool = new std::thread[threads-1];
+  for(int i = 0; i < threads-1; i++)
+    {
+      pool[i] = std::thread(worker);
+    }
+  worker();
+  for(int i = 0; i < threads-1; i++)
+    {
+      pool[i].join();
+    }
+  delete [] pool;
+}
+
+int source_map::appendSources(const char** filenames, int nfiles, int threads, int* errors)
+{
+  // This function maps the specified files concurrently
+  // and merges the results in 'filenames' order.
+  //
+  // return the number of appended files
+  //
+
+  if(nfiles <= 0){return 0;}
+  
+  file_map* maps = new file_map[nfiles];
+  parallelFor(nfiles, threads, [&](int i){maps[i].load(filenames[i], 0, cache);});
+
+  //Merge results in specified order
+  int appended = 0;
+  for(int i = 0; i < nfiles; i++)
+    {
+      int err = merge(maps[i]);
+      if(errors != 0){errors[i] = err;}
+      if(err == 0){appended++;}
+    }
+
+  delete [] maps;
+  return appended;
+}
+
+int source_map::appendDirectory(const char* root, const crawl_options& options, int* nfound)
+{
+  // This function maps all accepted files in the
+  // directory tree 'root'. The tree is walked while
+  // the found files are mapped (see 'appendProduced').
+  //
+  // return the number of appended files
+  // return -1 if 'root' can't be opened
+  //
+
+  if(nfound != 0){*nfound = 0;}
+  
+  DIR* proot = opendir(root);
+  if(proot == 0)
+    {
+      return -1;
+    }
+  closedir(proot);
+
+  //Remove final '/' of root path
+  std::string rootPath(root);
+  while(rootPath.length() > 1 && rootPath[rootPath.length()-1] == '/')
+    {
+      rootPath.erase(rootPath.length()-1);
+    }
+  
+  //Crawler: depth first walk visiting entries in alphabetical order
+  auto crawler = [&](const path_sink& send)
+    {
+      std::vector<std::string> pending(1); //Relative paths of directories to walk
+      std::set< std::pair<dev_t,ino_t> > visited;
+      std::set< std::pair<dev_t,ino_t> > visitedFiles;
+      std::vector< std::pair<std::string,unsigned char> > entries;
+      std::vector<std::string> found;
+      std::vector<std::string> subdirs;
+      while(!pending.empty())
+	{
+	  std::string rel;
+	  rel.swap(pending.back());
+	  pending.pop_back();
+	  std::string dirPath = rel.empty() ? rootPath : rootPath + "/" + rel;
+	  
+	  DIR* pdir = opendir(dirPath.c_str());
+	  if(pdir == 0){continue;}
+
+	  //Avoid loops through linked directories
+	  if(options.followLinks)
+	    {
+	      struct stat st;
+	      if(fstat(dirfd(pdir), &st) == 0 && !visited.insert(std::make_pair(st.st_dev, st.st_ino)).second)
+		{
+		  closedir(pdir);
+		  continue;
+		}
+	    }
+
+	  //Read and sort directory entries
+	  entries.clear();
+	  struct dirent* entry;
+	  while((entry = readdir(pdir)) != 0)
+	    {
+	      if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0){continue;}
+	      entries.push_back(std::make_pair(std::string(entry->d_name), (unsigned char) entry->d_type));
+	    }
+	  closedir(pdir);
+	  std::sort(entries.begin(), entries.end());
+
+	  found.clear();
+	  subdirs.clear();
+	  for(std::size_t i = 0; i < entries.size(); i++)
+	    {
+	      const char* name = entries[i].first.c_str();
+	      std::string relPath = rel.empty() ? entries[i].first : rel + "/" + entries[i].first;
+	      std::string fullPath = rootPath + "/" + relPath;
+	      
+	      //Resolve entry type, only links and unknown types need a stat
+	      unsigned char type = entries[i].second;
+	      struct stat st;
+	      bool statDone = false;
+	      if(type == DT_UNKNOWN || (type == DT_LNK && options.followLinks))
+		{
+		  int err = options.followLinks ? stat(fullPath.c_str(), &st) : lstat(fullPath.c_str(), &st);
+		  if(err != 0){continue;}
+		  if(S_ISDIR(st.st_mode)){type = DT_DIR;}
+		  else if(S_ISREG(st.st_mode)){type = DT_REG;}
+		  else{continue;}
+		  statDone = true;
+		}
+	      
+	      if(type == DT_DIR)
+		{
+		  if(!options.excluded(relPath.c_str(), name, true))
+		    {
+		      subdirs.push_back(relPath);
+		    }
+		}
+	      else if(type == DT_REG)
+		{
+		  if(options.accepted(name) && !options.excluded(relPath.c_str(), name, false))
+		    {
+		      //Linked files and their targets are mapped once
+		      if(options.followLinks)
+			{
+			  if(!statDone && stat(fullPath.c_str(), &st) != 0){continue;}
+			  if(!visitedFiles.insert(std::make_pair(st.st_dev, st.st_ino)).second){continue;}
+			}
+		      found.push_back(fullPath);
+		    }
+		}
+	    }
+
+	  //Send found files to mapping threads
+	  if(!found.empty())
+	    {
+	      send(found);
+	    }
+	  
+	  //Walk subdirectories in alphabetical order
+	  for(std::size_t i = subdirs.size(); i > 0; i--)
+	    {
+	      pending.push_back(std::string());
+	      pending.back().swap(subdirs[i-1]);
+	    }
+	}
+    };
+
+  return appendProduced(crawler, options.threads, nfound);
+}
+
+int source_map::appendCompileCommands(const char* filename, int threads, int* nfound)
+{
+  // This function maps all files listed in the compilation
+  // database 'filename'. The database is parsed in a single
+  // pass and the listed files are sent to the mapping threads
+  // while parsing (see 'appendProduced').
+  //
+  // return the number of appended files
+  // return -1 if 'filename' can't be opened
+  // return -2 if the database is malformed
+  //
+
+  if(nfound != 0){*nfound = 0;}
+  
+  //The database is read while the listed files are
+  //sent to the threads, so it is not parsed from mapped
+  //pages that would fault if it is truncated
+  mapped_file database;
+  if(database.open(filename, true) != 0)
+    {
+      return -1;
+    }
+
+  bool malformed = false;
+  auto parser = [&](const path_sink& send)
+    {
+      const char* p = database.data();
+      const char* end = p + database.size();
+      std::set<std::string> listed; //Canonical paths already sent
+      std::vector<std::string> found;
+      std::string key, value, directory, file;
+      char resolved[PATH_MAX];
+
+      //The database is an array of command objects
+      jsonSpace(p, end);
+      if(p >= end || *p != '['){malformed = true; return;}
+      p++;
+      jsonSpace(p, end);
+      if(p < end && *p == ']'){return;}
+      
+      while(1)
+	{
+	  //Read command object
+	  jsonSpace(p, end);
+	  if(p >= end || *p != '{'){malformed = true; break;}
+	  p++;
+	  directory.clear();
+	  file.clear();
+	  jsonSpace(p, end);
+	  if(p < end && *p == '}'){p++;}
+	  else
+	    {
+	      while(1)
+		{
+		  //Read "key": value pairs
+		  jsonSpace(p, end);
+		  if(!jsonString(p, end, key)){malformed = true; break;}
+		  jsonSpace(p, end);
+		  if(p >= end || *p != ':'){malformed = true; break;}
+		  p++;
+		  jsonSpace(p, end);
+		  if(key.compare("directory") == 0 || key.compare("file") == 0)
+		    {
+		      if(!jsonString(p, end, value)){malformed = true; break;}
+		      if(key[0] == 'd'){directory.swap(value);}
+		      else{file.swap(value);}
+		    }
+		  else if(!jsonSkip(p, end)){malformed = true; break;}
+
+		  jsonSpace(p, end);
+		  if(p < end && *p == ','){p++; continue;}
+		  if(p < end && *p == '}'){p++; break;}
+		  malformed = true;
+		  break;
+		}
+	      if(malformed){break;}
+	    }
+
+	  //Resolve and store listed file
+	  if(!file.empty())
+	    {
+	      if(file[0] != '/' && !directory.empty())
+		{
+		  file.insert(0, directory + "/");
+		}
+	      if(realpath(file.c_str(), resolved) != 0)
+		{
+		  file.assign(resolved);
+		}
+	      if(listed.insert(file).second)
+		{
+		  found.push_back(file);
+		  if(found.size() >= 64){send(found);}
+		}
+	    }
+	  
+	  //Next command object
+	  jsonSpace(p, end);
+	  if(p < end && *p == ','){p++; continue;}
+	  if(p < end && *p == ']'){break;}
+	  malformed = true;
+	  break;
+	}
+      
+      if(!found.empty()){send(found);}
+    };
+
+  int appended = appendProduced(parser, threads, nfound);
+  if(malformed){return -2;}
+  return appended;
+}
+
+int source_map::appendProduced(const path_producer& producer, int threads, int* nfound)
+{
+  // This function runs 'producer' in its own thread. The
+  // paths it sends are mapped by the mapping threads while
+  // the calling thread merges the mapped files in the order
+  // they were sent.
+  //
+  // return the number of appended files
+  //
+
+  if(threads <= 0)
+    {
+      threads = (int) std::thread::hardware_concurrency();
+      if(threads <= 0){threads = 1;}
+    }
+
+  //State shared by producer, mapping threads and merger
+  std::mutex lock;
+  std::condition_variable pathReady;
+  std::condition_variable fileReady;
+  std::vector<std::string> paths;
+  std::vector<file_map*> results;
+  std::size_t nextLoad = 0;
+  bool produced = false;
+
+  //Sink used by the producer to send paths
+  path_sink send = [&](std::vector<std::string>& found)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      for(std::size_t i = 0; i < found.size(); i++)
+	{
+	  paths.push_back(std::string());
+	  paths.back().swap(found[i]);
+	  results.push_back(0);
+	}
+      found.clear();
+      pathReady.notify_all();
+    };
+  
+  auto run = [&]()
+    {
+      producer(send);
+      
+      std::lock_guard<std::mutex> guard(lock);
+      produced = true;
+      pathReady.notify_all();
+      fileReady.notify_all();
+    };
+  
+  //Mapping threads: load the next found path
+  auto worker = [&]()
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      while(1)
+	{
+	  pathReady.wait(guard, [&]{return nextLoad < paths.size() || produced;});
+	  if(nextLoad >= paths.size()){break;}
+	  
+	  std::size_t i = nextLoad++;
+	  std::string path(paths[i]);
+	  guard.unlock();
+
+	  file_map* file = new file_map;
+	  file->load(path.c_str(), 0, cache);
+
+	  guard.lock();
+	  results[i] = file;
+	  fileReady.notify_one();
+	}
+    };
+
+  std::thread producerThread(run);
+  std::thread* workers = new std::thread[threads];
+  for(int i = 0; i < threads; i++)
+    {
+      workers[i] = std::thread(worker);
+    }
+
+  //Merge mapped files in found order
+  int appended = 0;
+  std::size_t nextMerge = 0;
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    while(1)
+      {
+	fileReady.wait(guard, [&]{return (nextMerge < results.size() && results[nextMerge] != 0) || (produced && nextMerge >= paths.size());});
+	if(nextMerge >= paths.size()){break;}
+
+	file_map* file = results[nextMerge];
+	results[nextMerge] = 0;
+	nextMerge++;
+	guard.unlock();
+	
+	if(merge(*file) == 0){appended++;}
+	delete file;
+	
+	guard.lock();
+      }
+  }
+  
+  producerThread.join();
+  for(int i = 0; i < threads; i++)
+    {
+      workers[i].join();
+    }
+  delete [] workers;
+
+  if(nfound != 0){*nfound = (int) paths.size();}
+  return appended;
+}
+
+int source_map::rescan(int threads)
+{
+  // This function maps again the files whose
+  // content has changed since they were mapped.
+  //
+  // return the number of changed files
+  //
+
+  //Fast check: size and modification time
+  std::vector<std::string> candidates;
+  for(int i = 0; i < nFiles; i++)
+    {
+      struct stat st;
+      if(stat(files[i].path.c_str(), &st) == 0)
+	{
+	  long long mtime = 1000000000LL*(long long) st.st_mtim.tv_sec + (long long) st.st_mtim.tv_nsec;
+	  if((unsigned long long) st.st_size == files[i].size && mtime == files[i].mtime)
+	    {
+	      continue;
+	    }
+	}
+      candidates.push_back(files[i].path);
+    }
+  if(candidates.empty()){return 0;}
+
+  std::vector<const char*> paths(candidates.size());
+  for(std::size_t k = 0; k < candidates.size(); k++)
+    {
+      paths[k] = candidates[k].c_str();
+    }
+  return refresh(paths.data(), (int) paths.size(), threads);
+}
+
+int source_map::refresh(const char** filenames, int nfiles, int threads)
+{
+  // This function maps again the specified files
+  // if their content has changed. Not mapped files
+  // are appended and mapped files that can't be
+  // opened are removed.
+  //
+  // return the number of changed files
+  //
+
+  //Remove repeated paths. Paths are copied because
+  //the fingerprints array will be modified
+  std::vector<std::string> candidates;
+  std::set<std::string> unique;
+  for(int k = 0; k < nfiles; k++)
+    {
+      if(unique.insert(filenames[k]).second)
+	{
+	  candidates.push_back(filenames[k]);
+	}
+    }
+  if(candidates.empty()){return 0;}
+
+  //Confirm changes with the content hash and
+  //parse modified files concurrently
+  int ncandidates = (int) candidates.size();
+  std::vector<int> known(ncandidates);
+  for(int k = 0; k < ncandidates; k++)
+    {
+      std::unordered_map<std::string,int>::const_iterator it = fileIndex.find(candidates[k]);
+      known[k] = it == fileIndex.end() ? -1 : it->second;
+    }
+  file_map* maps = new file_map[ncandidates];
+  parallelFor(ncandidates, threads, [&](int k)
+	      {
+		maps[k].load(candidates[k].c_str(), known[k] < 0 ? 0 : &files[known[k]], cache, true);
+	      });
+  
+  //Collect changed files
+  std::set<std::string> changed;
+  bool anyRemoved = false;
+  for(int k = 0; k < ncandidates; k++)
+    {
+      if(maps[k].status == 1)
+	{
+	  //Same content, only update the modification time
+	  files[known[k]].mtime = maps[k].mtime;
+	}
+      else if(maps[k].status == -1 && known[k] < 0)
+	{
+	  //Not mapped and not readable file, ignore it
+	}
+      else
+	{
+	  changed.insert(candidates[k]);
+	  if(maps[k].status == -1){anyRemoved = true;}
+	}
+    }
+
+  if(changed.empty())
+    {
+      delete [] maps;
+      return 0;
+    }
+  
+  //Remove functions of changed files
+  for(std::set<std::string>::const_iterator it = changed.begin(); it != changed.end(); ++it)
+    {
+      symbol source;
+      if(symbol::find(it->c_str(), source))
+	{
+	  markSource(source);
+	  sourceRanges.erase(source.id());
+	}
+    }
+  dropNames();
+  collectRemoved();
+
+  //Remove fingerprints of removed files
+  if(anyRemoved)
+    {
+      std::vector<bool> removed(nFiles, false);
+      for(int k = 0; k < ncandidates; k++)
+	{
+	  if(known[k] >= 0 && maps[k].status == -1){removed[known[k]] = true;}
+	}
+      int n = 0;
+      for(int i = 0; i < nFiles; i++)
+	{
+	  if(!removed[i])
+	    {
+	      if(n != i){files[n] = files[i];}
+	      n++;
+	    }
+	}
+      nFiles = n;
+      fileIndex.clear();
+      for(int i = 0; i < nFiles; i++)
+	{
+	  fileIndex[files[i].path] = i;
+	}
+    }
+
+  //Merge new contents
+  for(int k = 0; k < ncandidates; k++)
+    {
+      if(maps[k].status != 1 && maps[k].status != -1)
+	{
+	  merge(maps[k]);
+	}
+    }
+
+  delete [] maps;
+  return (int) changed.size();
+}
+
+int source_map::removeSource(const char* filename)
+{
+  // This function removes the functions extracted
+  // from 'filename' and its fingerprint.
+  //
+  // return 0 on succes
+  // return -1 if the file is not mapped
+  //
+
+  //Remove the functions in the file range
+  int nremoved = 0;
+  symbol source;
+  if(symbol::find(filename, source))
+    {
+      nremoved = markSource(source);
+      sourceRanges.erase(source.id());
+      dropNames();
+      collectRemoved();
+    }
+
+  //Remove the fingerprint
+  std::unordered_map<std::string,int>::const_iterator it = fileIndex.find(filename);
+  if(it != fileIndex.end())
+    {
+      removeRecord(it->second);
+    }
+  else if(nremoved == 0)
+    {
+      return -1;
+    }
+  return 0;
+}
+
+int source_map::replaceSource(const char* filename)
+{
+  // This function maps again 'filename' and replaces
+  // the functions extracted before from it.
+  //
+  // return 0 on succes
+  // return -1 if file can't be opened
+  // return -3 if there are not any function definition
+  //           in specified source file
+  //
+
+  file_map file;
+  file.load(filename, 0, cache, true);
+  if(file.status == -1)
+    {
+      //Keep the previous functions
+      return -1;
+    }
+
+  //Mark the previous functions of the file. Functions
+  //removed before can be marked too, so the positions
+  //of the file are kept
+  int nold = 0;
+  std::vector<int> slots;
+  symbol source;
+  if(symbol::find(filename, source))
+    {
+      nold = markSource(source, &slots);
+    }
+
+  //Same number of functions, exchange them
+  if(nold > 0 && nold == file.nFunctions)
+    {
+      std::sort(slots.begin(), slots.end());
+      return merge(file, &slots);
+    }
+
+  //Otherwise, remove them and append the new ones.
+  //The marked functions are compacted later
+  if(nold > 0)
+    {
+      sourceRanges.erase(source.id());
+      dropNames();
+      collectRemoved();
+    }
+  return merge(file);
+}
+
+void source_map::recordFile(const file_map& file)
+{
+  // This function stores the fingerprint of
+  // 'file'. If the file has been already
+  // recorded, the fingerprint is updated.
+
+  int i;
+  std::unordered_map<std::string,int>::iterator it = fileIndex.find(file.filename);
+  if(it != fileIndex.end())
+    {
+      i = it->second;
+    }
+  else
+    {
+      //Check array size
+      if(nFiles >= maxFiles)
+	{
+	  resizeFR(maxFiles == 0 ? 16 : 2*maxFiles);
+	}
+      i = nFiles;
+      nFiles++;
+      files[i].path.assign(file.filename);
+      fileIndex[file.filename] = i;
+    }
+
+  files[i].size = file.bytes;
+  files[i].mtime = file.mtime;
+  files[i].hash = file.hash;
+}
+
+void source_map::removeRecord(int k)
+{
+  // This function removes the fingerprint 'k'. The
+  // following fingerprints are moved one position.
+
+  fileIndex.erase(files[k].path);
+  for(int i = k+1; i < nFiles; i++)
+    {
+      std::swap(files[i-1], files[i]);
+      fileIndex[files[i-1].path] = i-1;
+    }
+  nFiles--;
+  files[nFiles] = file_record();
+}
+
+int source_map::merge(file_map& file, const std::vector<int>* slots)
+{
+  // This function appends the functions extracted
+  // in 'file' to the map. The functions are moved
+  // from 'file'.
+  //
+  // return the load result of 'file'
+  //
+
+  const char* filename = file.filename.c_str();
+  if(file.status == -1)
+    {
+      //The file has not been read
+      return -1;
+    }
+
+  //Store file fingerprint
+  recordFile(file);
+  
+  //Update throughput counters
+  double tstart = wallTime();
+  stats.files++;
+  if(file.mapped){stats.mappedFiles++;}
+  if(file.cached){stats.cachedFiles++;}
+  stats.bytes += file.bytes;
+  stats.readTime += file.readTime;
+  stats.parseTime += file.parseTime;
+  
+  //Check matching keys table of cleared code
+  if(file.unmatched > 0)
+    {
+      printf("appendSource:warning: %d not matched keys in %s\n",file.unmatched,filename);
+      stats.unbalancedFiles++;
+    }
+
+  if(file.nNames == 0)
+    {
+      //No function definitions in specified source file
+      return -3;
+    }
+  
+  //Append names, functions and namespaces
+  if(slots != 0)
+    {
+      replaceFunctions(file, *slots);
+    }
+  else
+    {
+      appendFunctions(file);
+    }
+  
+  stats.parseTime += wallTime()-tstart;
+  return 0;
+}
+
+void source_map::appendFunctions(file_map& file)
+{
+  // This function appends the names and functions
+  // of 'file' to the map, and updates the namespace
+  // maps. The functions are moved from 'file'.
+
+  int readS = file.nFunctions;
+  
+  //Save readed names
+  appendNames(file);
+
+  //Check the remaining space in
+  //'functions' array
+  if(nFunctions+readS >= maxFunctions)
+    {
+      resizeF(2*(nFunctions+readS));
+    }
+  
+  //Move extracted functions. Their arrays are
+  //allocated in the arena of the file, which is
+  //taken by the map
+  pool.adopt(file.pool);
+  int firstF = nFunctions;
+  for(int i = 0; i < readS; i++)
+    {
+      functions[nFunctions].swap(file.functions[i]);
+      if(functions[nFunctions].pool == &file.pool)
+	{
+	  functions[nFunctions].pool = &pool;
+	}
+      nFunctions++;
+    }
+  indexFunctions(firstF);
+
+  //Extract used namespaces from appended functions
+  for(int i = firstF; i < nFunctions; i++)
+    {
+      useNamespaces(i);
+    }
+
+#ifdef __CODE_MAP_DEBUG__
+  if(checkMaps() != 0)
+    {
+      printf("appendSource:warning: inconsistent names or namespaces\n");
+    }
+#endif
+}
+
+void source_map::appendNames(const file_map& file)
+{
+  // This function appends the names of 'file'
+  // that are not already defined.
+
+  int readF = file.nNames;
+  
+  //Calculate total names number of defined functions
+  int totalDF = nFnames + readF;
+  if(totalDF > maxFnames)
+    {
+      //Resize arrays to save new values
+      resizeFN(2*totalDF);
+    }
+
+  //Save readed names
+  for(int i = 0; i < readF; i++)
+    {
+      //Check if this name already exists
+      symbol sname(file.names[i]);
+      if(fnameSet.add(sname.id()) == 0)
+	{
+	  //Store new function name
+	  defFuncNames[nFnames] = sname;
+	  fnamePosition.insert(sname.id(), nFnames);
+	  nFnames++;
+	}
+    }
+}
+
+/// Store 'stored' as the position of 'key' if it is new or points to a following function
+template<class K, class H>
+static void indexFirst(std::unordered_map<K,int,H>& index, const K& key, int stored)
+{
+  std::pair<typename std::unordered_map<K,int,H>::iterator,bool> it = index.emplace(key, stored);
+  if(!it.second && it.first->second > stored)
+    {
+      it.first->second = stored;
+    }
+}
+
+void source_map::replaceFunctions(file_map& file, const std::vector<int>& slots)
+{
+  // This function exchanges the marked functions
+  // in 'slots' with the functions of 'file', in
+  // the same order. The old functions are left in
+  // 'file'. Other marked functions are kept in
+  // 'removedF'.
+
+  int readS = file.nFunctions;
+
+  //Add the new names before the released ones
+  //are dropped, so shared names are kept
+  appendNames(file);
+  pool.adopt(file.pool);
+  for(int k = 0; k < readS; k++)
+    {
+      int i = slots[k];
+      removedF.remove(i);
+      functions[i].swap(file.functions[k]);
+      if(functions[i].pool == &file.pool)
+	{
+	  functions[i].pool = &pool;
+	}
+
+      //The other functions are not moved, so the
+      //stored position of 'i' doesn't change. Keys
+      //must point to the first matching function
+      const function_map& f = functions[i];
+      int stored = storedPosition(i);
+      indexPosition(f.name.id(), stored);
+      nameCount[f.name.id()]++;
+      indexFirst(nameIndex, f.name.id(), stored);
+      indexFirst(functionIndex, function_key(f.name.id(), f.sourceFile.id(), 0), stored);
+      if(f.nOverload > 0)
+	{
+	  indexFirst(functionIndex, function_key(f.name.id(), f.sourceFile.id(), f.nOverload), stored);
+	}
+      useNamespaces(i);
+    }
+
+  //The replaced functions have been released when they
+  //were marked. Drop their names if are not used again
+  dropNames();
+  reclaimPool();
+
+#ifdef __CODE_MAP_DEBUG__
+  if(checkMaps() != 0)
+    {
+      printf("replaceSource:warning: inconsistent names or namespaces\n");
+    }
+#endif
+}
+
+void source_map::useNamespaces(int i)
+{
+  // This function registers the namespaces used by
+  // the function 'i' and appends the function name to
+  // the corresponding namespace maps.
+
+  for(int j = 0; j < functions[i].nNamespaces; j++)
+    {
+      const symbol& ns = functions[i].namespaces[j];
+      if(namespaceIndex.insert(ns.id(), nNamespaces) < 0)
+	{
+	  //This namespace is not in the array
+	  //Check array sizes 
+	  if(nNamespaces >= maxNamespaces)
+	    {
+	      //Resize namespaces array
+	      resizeNSN(5+maxNamespaces*2);
+	    }
+	  if(nNamespaceMaps >= maxNamespaceMaps)
+	    {
+	      resizeNS(10+maxNamespaceMaps*2);
+	    }
+	      
+	  //Add this namespace
+	  namespaces[nNamespaces] = ns;
+	  nNamespaces++;
+
+	  namespaceMaps[nNamespaceMaps].name = ns;
+	  namespaceMaps[nNamespaceMaps].appendF(functions[i].name);
+	  namespaceMapIndex.insert(ns.id(), nNamespaceMaps);
+	  nNamespaceMaps++;
+	}
+      else
+	{
+	  //This namespace already exists, append the
+	  //function name if is not already in its map
+	  int k = namespaceMapIndex.find(ns.id());
+	  if(k >= 0)
+	    {
+	      namespaceMaps[k].appendF(functions[i].name);
+	    }
+	}
+    }
+}
+
+void source_map::indexNames()
+{
+  // This function builds again the indexes of
+  // namespaces.
+
+  namespaceIndex.clear();
+  for(int i = 0; i < nNamespaces; i++)
+    {
+      namespaceIndex.insert(namespaces[i].id(), i);
+    }
+  namespaceMapIndex.clear();
+  for(int i = 0; i < nNamespaceMaps; i++)
+    {
+      namespaceMapIndex.insert(namespaceMaps[i].name.id(), i);
+    }
+}
+
+//To string function
+
+std::string source_map::to_string(int tabs) const
+{
+  //Convert all source map to text format and
+  //return this text as string.
+  //
+  // 'tabs' specifies the number of initial
+  // tabulations '\t' to use
+  //
+
+  std::string out;
+
+  //Functions names
+  out.append(tabs,'\t');
+  out.append("Defined functions names: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nFnames; i++)
+    {
+      if(removedNames.contains(i))
+	continue;
+      out.append(tabs+1,'\t');
+      out.append("                         ");
+      out.append(defFuncNames[i]);
+      out.append(1,'\n');
+    }
+
+  //Namespace names
+  out.append(tabs,'\t');
+  out.append("        Used namespaces: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nNamespaces; i++)
+    {
+      out.append(tabs+1,'\t');
+      out.append("                         ");
+      out.append(namespaces[i]);
+      out.append(1,'\n');
+    }
+
+  //Namespaces
+  out.append(tabs,'\t');
+  out.append("         Namespace maps: ");
+  out.append(1,'\n');
+  for(int i = 0; i < nNamespaceMaps; i++)
+    {
+      out.append(namespaceMaps[i].to_string(tabs+3));
+      out.append(1,'\n');
+    }
+  
+  //Functions
+  out.append(tabs,'\t');
+  out.append("              Functions: ");
+  out.append(1,'\n');
+  for(int i = 0; i < numFN(); i++)
+    {
+      out.append(getFunction(i)->to_string(tabs+3));
+      out.append(1,'\n');
+    }
+
+  //Return output string
+  return out;
+}
+
+//Acces functions
+
+std::string source_map::getNamespaceName(int i) const
+{
+  std::string aux;
+  if(i >= 0 && i < nNamespaces)
+    {
+      aux.assign(namespaces[i]);
+    }
+  else{aux.clear();}
   
   return aux;
 }
 
-fcall function_map::getCall(int i) const
+std::string source_map::getFName(int i) const
 {
-  if(i >= 0 && i < nCalledF)
+  std::string aux;
+  if(i >= 0 && i < numFN())
     {
-      return fcalls[i];
+      aux.assign(defFuncNames[removedNames.empty() ? i : removedNames.nthMissing(i)]);
     }
+  else{aux.clear();}
   
-  return fcall();  
+  return aux;
 }
 
-//Append functions
+const function_map* source_map::getFunction(const char* functionName, const char* sourceFile, int overload) const
+{
+  //Return a inmutable pointer for the specified function.
 
-int function_map::appendCall(fcall call)
+  //Names that have not been interned are not mapped
+  symbol fname, sname;
+  if(!symbol::find(functionName, fname)){return 0;}
+
+  if(sourceFile == 0)
+    {
+      //Don't care of source name, return first function name match
+      std::unordered_map<unsigned int,int>::const_iterator it = nameIndex.find(fname.id());
+      return it != nameIndex.end() ? &functions[indexedPosition(it->second)] : 0;
+    }
+
+  //Check source filename and overload. If overload
+  //is not specified, use the "any overload" key
+  if(!symbol::find(sourceFile, sname)){return 0;}
+  std::unordered_map<function_key,int,function_key_hash>::const_iterator it =
+    functionIndex.find(function_key(fname.id(), sname.id(), overload > 0 ? overload : 0));
+  return it != functionIndex.end() ? &functions[indexedPosition(it->second)] : 0;
+}
+
+const function_map* source_map::getFunction(int i) const
 {
-  //This function append a call pair function/number of call to
-  //the 'fcalls' array. The addition will not be performed if
-  //specified pair already exists.
-  //
-  //return number of function calls on succes
-  //return -1 if the pair already exists
+  //Return a inmutable pointer for the specified function.
+  //'i' is a position of the functions that remain, so
+  //the marked functions are skipped
 
-  return appendCall(call.name.c_str(), call.calls);
-  
+  if(i < 0 || i >= numF())
+    {
+      return 0;
+    }
+  return &functions[removedF.empty() ? i : (int) removedF.nthMissing(i)];
 }
 
-int function_map::appendCall(const char* fname, int ncalls)
+void source_map::indexFunctions(int first)
 {
-  //This function append a call pair function/number of calls to
-  //the 'fcalls' array. The addition will not be performed if
-  //specified pair already exists.
-  //
-  //return number of function calls on succes
-  //return -1 if the pair already exists
+  // This function adds the functions stored from
+  // position 'first' to the function indexes. Keys
+  // already indexed keep their position. If 'first'
+  // is 0, the indexes are cleared before.
 
-  //Check if this name already exists
-  for(int i = 0; i < nCalledF; i++)
+  if(first <= 0)
+    {
+      first = 0;
+      functionIndex.clear();
+      nameIndex.clear();
+      nameCount.clear();
+      namePositions.clear();
+      sourceRanges.clear();
+      indexGaps.clear();
+      functionIndex.reserve(2*nFunctions);
+      nameIndex.reserve(nFunctions);
+      nameCount.reserve(nFunctions);
+    }
+  
+  function_range* range = 0;
+  for(int i = first; i < nFunctions; i++)
     {
-      if(fcalls[i].name.compare(fname) == 0)
+      const function_map& f = functions[i];
+      int stored = storedPosition(i);
+
+      //Extend the last range of the source file if it ends
+      //at this function. Otherwise, start a new range
+      if(range == 0 || functions[i-1].sourceFile != f.sourceFile)
 	{
-	  return -1;
+	  std::vector<function_range>& ranges = sourceRanges[f.sourceFile.id()];
+	  if(ranges.empty() || indexedPosition(ranges.back().end) != i)
+	    {
+	      if(ranges.empty() || indexedPosition(ranges.back().first) < indexedPosition(ranges.back().end))
+		{
+		  ranges.push_back(function_range());
+		}
+	      //Empty ranges are reused
+	      ranges.back().first = stored;
+	    }
+	  range = &ranges.back();
+	}
+      range->end = stored+1;
+      
+      indexPosition(f.name.id(), stored);
+      nameIndex.emplace(f.name.id(), stored);
+      nameCount[f.name.id()]++;
+      functionIndex.emplace(function_key(f.name.id(), f.sourceFile.id(), 0), stored);
+      if(f.nOverload > 0)
+	{
+	  functionIndex.emplace(function_key(f.name.id(), f.sourceFile.id(), f.nOverload), stored);
 	}
     }
+}
 
-  //Check call array size
-  if(nCalledF >= maxCalledF)
+void source_map::indexSorted()
+{
+  // This function rewrites the positions of the
+  // function indexes once the functions are sorted.
+  // Names and sources are contiguous, so the first
+  // function of each key is the one that differs
+  // from the previous function.
+
+  indexGaps.clear();
+  sourceRanges.clear();
+  namePositions.clear();
+  function_range* range = 0;
+  for(int i = 0; i < nFunctions; i++)
     {
-      int size;
-      if(maxCalledF == 0){size = 10;}
-      else{size = 2*maxCalledF;}
-      resizeFCalls(size); //Enlarge array
+      const function_map& f = functions[i];
+      const function_map* prev = i > 0 ? &functions[i-1] : 0;
+      bool newName = prev == 0 || prev->name != f.name;
+      bool newSource = prev == 0 || prev->sourceFile != f.sourceFile;
+
+      //Start a new range when the source file changes
+      if(newSource)
+	{
+	  std::vector<function_range>& ranges = sourceRanges[f.sourceFile.id()];
+	  ranges.push_back(function_range());
+	  ranges.back().first = i;
+	  range = &ranges.back();
+	}
+      range->end = i+1;
+
+      if(newName)
+	{
+	  nameIndex[f.name.id()] = i;
+	}
+      else
+	{
+	  //Functions with the same name are contiguous
+	  std::vector<int>& positions = namePositions[f.name.id()];
+	  if(positions.empty()){positions.push_back(i-1);}
+	  positions.push_back(i);
+	}
+      if(newName || newSource)
+	{
+	  functionIndex[function_key(f.name.id(), f.sourceFile.id(), 0)] = i;
+	}
+      if(f.nOverload > 0 && (newName || newSource || prev->nOverload != f.nOverload))
+	{
+	  functionIndex[function_key(f.name.id(), f.sourceFile.id(), f.nOverload)] = i;
+	}
     }
+}
 
-  //Store new function call
-  fcalls[nCalledF].name.assign(fname);
-  fcalls[nCalledF].calls = ncalls;
-  nCalledF++;
+void source_map::indexPosition(unsigned int name, int stored)
+{
+  // This function adds the position 'stored' of a new
+  // function to the positions of the functions with
+  // the same name, if there are other functions.
+
+  std::unordered_map<unsigned int,int>::const_iterator first = nameIndex.find(name);
+  if(first == nameIndex.end())
+    return;
+
+  //The name gets his second function, start
+  //the list with the position of the first one
+  std::vector<int>& positions = namePositions[name];
+  if(positions.empty()){positions.push_back(first->second);}
+
+  //Appended functions are stored at the end
+  positions.insert(std::upper_bound(positions.begin(), positions.end(), stored), stored);
+}
+
+int source_map::storedPosition(int i) const
+{
+  //Count the gaps before the function 'i'. The
+  //gap 'j' follows indexGaps[j]-j functions
+  int lo = 0;
+  int hi = (int) indexGaps.size();
+  while(lo < hi)
+    {
+      int mid = (lo+hi)/2;
+      if(indexGaps[mid]-mid <= i){lo = mid+1;}
+      else{hi = mid;}
+    }
+  return i+lo;
+}
+
+//Acces namespace
+
+const namespace_map* source_map::getNamespace(const char* namespaceName) const
+{
+  //Return a inmutable pointer for the specified namespace object.
+
+  //return null pointer if namespace name has not been found
+
+  symbol sname;
+  if(!symbol::find(namespaceName, sname)){return 0;}
+
+  int i = namespaceMapIndex.find(sname.id());
+  return i >= 0 ? &namespaceMaps[i] : 0;
+}
+
+const namespace_map* source_map::getNamespace(int i) const
+{
+  //Return a inmutable pointer for the specified function.
   
-  return nCalledF;
+  if(i >= 0 && i < nNamespaceMaps)
+    {
+      return &namespaceMaps[i];
+    }
+  return 0;
 }
 
-//Set functions
 
-int function_map::setCall(fcall call)
+//Remove functions
+
+void source_map::markRemoved(int i)
 {
-  //This function set a call pair function/number of 
-  //the 'fcalls' array. If the specified pair doesn't exists
-  //will be appendet.
-  //
-  //return 0 on succes
-  //return number of function calls if the pair doesn't exist
+  // This function marks the function 'i' as removed. The
+  // index keys that point to it are moved to the next
+  // function with the same key, or erased if there is not
+  // any. Its names and namespaces are released, but the
+  // function is removed by 'compactFunctions'.
 
-  return setCall(call.name.c_str(), call.calls);
+  if(removedF.add(i) != 0)
+    {
+      //Already removed
+      return;
+    }
+
+  const function_map& f = functions[i];
+  unsigned int fname = f.name.id();
+  unsigned int fsource = f.sourceFile.id();
+
+  //Count the remaining functions with this name
+  int remaining = 0;
+  std::unordered_map<unsigned int,int>::iterator count = nameCount.find(fname);
+  if(count != nameCount.end())
+    {
+      remaining = --count->second;
+      if(remaining <= 0){nameCount.erase(count);}
+    }
+  releaseNames(f);
+
+  //Find the keys that point to this function
+  std::unordered_map<unsigned int,int>::iterator nameIt = nameIndex.find(fname);
+  std::unordered_map<function_key,int,function_key_hash>::iterator sourceIt =
+    functionIndex.find(function_key(fname, fsource, 0));
+  std::unordered_map<function_key,int,function_key_hash>::iterator overloadIt = functionIndex.end();
+  if(f.nOverload > 0)
+    {
+      overloadIt = functionIndex.find(function_key(fname, fsource, f.nOverload));
+    }
+  int stored = storedPosition(i);
+  bool moveName = nameIt != nameIndex.end() && nameIt->second == stored;
+  bool moveSource = sourceIt != functionIndex.end() && sourceIt->second == stored;
+  bool moveOverload = overloadIt != functionIndex.end() && overloadIt->second == stored;
+
+  //The keys were pointing to the first matching function, so
+  //the next one is found after 'i' between the positions of
+  //the functions with the same name
+  std::unordered_map<unsigned int,std::vector<int> >::iterator chain = namePositions.find(fname);
+  if(chain != namePositions.end())
+    {
+      std::vector<int>& positions = chain->second;
+      std::vector<int>::iterator it = std::lower_bound(positions.begin(), positions.end(), stored);
+      if(it != positions.end() && *it == stored)
+	{
+	  it = positions.erase(it);
+	}
+      for(; it != positions.end() && (moveName || moveSource || moveOverload); ++it)
+	{
+	  const function_map& g = functions[indexedPosition(*it)];
+	  if(moveName)
+	    {
+	      nameIt->second = *it;
+	      moveName = false;
+	    }
+	  if(g.sourceFile.id() != fsource)
+	    continue;
+	  if(moveSource)
+	    {
+	      sourceIt->second = *it;
+	      moveSource = false;
+	    }
+	  if(moveOverload && g.nOverload == f.nOverload)
+	    {
+	      overloadIt->second = *it;
+	      moveOverload = false;
+	    }
+	}
+
+      //A single function is only stored in 'nameIndex'
+      if(remaining < 2){namePositions.erase(chain);}
+    }
+
+  //Erase keys without other functions
+  if(moveName){nameIndex.erase(nameIt);}
+  if(moveSource){functionIndex.erase(sourceIt);}
+  if(moveOverload){functionIndex.erase(overloadIt);}
+}
+
+int source_map::markFunctions(const symbol& fname, const symbol* sname, int overload)
+{
+  // This function marks as removed the functions with
+  // name 'fname' and, if specified, source 'sname' and
+  // overload 'overload'. Returns the number of marked
+  // functions.
+
+  std::unordered_map<unsigned int,int>::const_iterator first = nameIndex.find(fname.id());
+  if(first == nameIndex.end())
+    return 0;
+
+  //Visit the functions with this name, in map order. Marking
+  //a function erases its position, so the positions are copied
+  std::vector<int> positions;
+  std::unordered_map<unsigned int,std::vector<int> >::const_iterator chain = namePositions.find(fname.id());
+  if(chain != namePositions.end()){positions = chain->second;}
+  else{positions.push_back(first->second);}
   
+  int marked = 0;
+  for(std::size_t k = 0; k < positions.size(); k++)
+    {
+      int i = indexedPosition(positions[k]);
+      const function_map& f = functions[i];
+
+      //Check source file and overload
+      if(sname != 0 && f.sourceFile != *sname)
+	continue;
+      if(sname != 0 && overload > 0 && f.nOverload != overload)
+	continue;
+
+      markRemoved(i);
+      marked++;
+    }
+  return marked;
+}
+
+int source_map::markSource(const symbol& source, std::vector<int>* marked)
+{
+  // This function marks as removed the functions
+  // extracted from 'source'. Returns the number of
+  // marked functions and, if 'marked' is not null,
+  // their positions.
+
+  std::unordered_map<unsigned int,std::vector<function_range> >::const_iterator ranges = sourceRanges.find(source.id());
+  if(ranges == sourceRanges.end())
+    return 0;
+
+  //Each range only contains functions of the file
+  int nmarked = 0;
+  for(std::size_t k = 0; k < ranges->second.size(); k++)
+    {
+      int end = indexedPosition(ranges->second[k].end);
+      for(int i = indexedPosition(ranges->second[k].first); i < end; i++)
+	{
+	  if(removedF.contains(i))
+	    continue;
+	  markRemoved(i);
+	  if(marked != 0){marked->push_back(i);}
+	  nmarked++;
+	}
+    }
+  return nmarked;
+}
+
+void source_map::collectRemoved()
+{
+  // This function compacts the marked functions
+  // when they are more than the remaining ones.
+
+  if(2*removedF.size() > (unsigned int) nFunctions)
+    {
+      compactFunctions();
+    }
 }
 
-int function_map::setCall(const char* fname, int ncalls)
+void source_map::compactFunctions()
 {
-  //This function set a call pair function/number of 
-  //the 'fcalls' array. If the specified pair doesn't exists
-  //will be appendet.
-  //
-  //return 0 on succes
-  //return number of function calls if the pair doesn't exist
+  // This function removes the functions marked in
+  // 'removedF'. Their names and namespaces have been
+  // released when they were marked.
 
-  //Check if this name already exists
-  for(int i = 0; i < nCalledF; i++)
+  if(removedF.empty())
+    return;
+
+  int nremoved = (int) removedF.size();
+  unsigned int* removed = new unsigned int[nremoved];
+  removedF.toArray(removed);
+
+  //Move the remaining functions. The removed ones
+  //are left at the end and cleared
+  int n = removed[0];
+  for(int i = removed[0], k = 0; i < nFunctions; i++)
     {
-      if(fcalls[i].name.compare(fname) == 0)
+      if(k < nremoved && (int) removed[k] == i)
 	{
-	  fcalls[i].calls = ncalls;
-	  return 0;
+	  k++;
+	  continue;
 	}
+      functions[n].swap(functions[i]);
+      n++;
     }
+  for(int i = n; i < nFunctions; i++)
+    {
+      functions[i].clear();
+    }
+  nFunctions = n;
 
-  return appendCall(fname, ncalls);
+  //The positions stored in the indexes are shifted when they
+  //are read. Add the removed ones to the gaps
+  std::vector<int> gaps(nremoved);
+  for(int k = 0; k < nremoved; k++)
+    {
+      gaps[k] = storedPosition(removed[k]);
+    }
+  delete [] removed;
+  int ngaps = (int) indexGaps.size();
+  indexGaps.insert(indexGaps.end(), gaps.begin(), gaps.end());
+  std::inplace_merge(indexGaps.begin(), indexGaps.begin()+ngaps, indexGaps.end());
+
+  //Rewrite the indexes if there are too many gaps
+  if((int) indexGaps.size() > 256+nFunctions/16)
+    {
+      for(std::unordered_map<function_key,int,function_key_hash>::iterator it = functionIndex.begin();
+	  it != functionIndex.end(); ++it)
+	{
+	  it->second = indexedPosition(it->second);
+	}
+      for(std::unordered_map<unsigned int,int>::iterator it = nameIndex.begin(); it != nameIndex.end(); ++it)
+	{
+	  it->second = indexedPosition(it->second);
+	}
+      for(std::unordered_map<unsigned int,std::vector<int> >::iterator it = namePositions.begin();
+	  it != namePositions.end(); ++it)
+	{
+	  for(std::size_t k = 0; k < it->second.size(); k++)
+	    {
+	      it->second[k] = indexedPosition(it->second[k]);
+	    }
+	}
+      for(std::unordered_map<unsigned int,std::vector<function_range> >::iterator it = sourceRanges.begin();
+	  it != sourceRanges.end(); )
+	{
+	  //Drop the empty ranges
+	  std::vector<function_range>& ranges = it->second;
+	  std::size_t nranges = 0;
+	  for(std::size_t k = 0; k < ranges.size(); k++)
+	    {
+	      function_range range;
+	      range.first = indexedPosition(ranges[k].first);
+	      range.end = indexedPosition(ranges[k].end);
+	      if(range.first < range.end){ranges[nranges++] = range;}
+	    }
+	  ranges.resize(nranges);
+	  if(nranges == 0){it = sourceRanges.erase(it);}
+	  else{++it;}
+	}
+      indexGaps.clear();
+    }
+  removedF.clear();
+  reclaimPool();
+
+#ifdef __CODE_MAP_DEBUG__
+  if(checkMaps() != 0)
+    {
+      printf("removeF:warning: inconsistent names or namespaces\n");
+    }
+#endif
 }
 
-int function_map::removeCall(const char* fname)
+void source_map::reclaimPool()
 {
-  //This function remove a call pair function/number of 
-  //the 'fcalls' array.
-  //
-  //return number of function calls on succes
-  //return -1 if the pair doesn't exist
+  // This function copies the arrays used by the map
+  // to a new arena when most of the current arena is
+  // not used anymore.
+
+  if(pool.bytes() <= poolCheck)
+    return;
+
+  //Count the used bytes, rounded like the arena allocations
+  std::size_t used = 0;
+  auto arrayBytes = [](std::size_t bytes){return (bytes+arenaAlign-1) & ~(arenaAlign-1);};
+  used += arrayBytes(maxFnames*sizeof(symbol));
+  used += arrayBytes(maxNamespaces*sizeof(symbol));
+  for(int i = 0; i < nFunctions; i++)
+    {
+      if(functions[i].pool == &pool)
+	{
+	  used += arrayBytes(functions[i].maxNamespaces*sizeof(symbol));
+	  used += arrayBytes(functions[i].maxCalledF*sizeof(fcall));
+	}
+    }
+  for(int i = 0; i < nNamespaceMaps; i++)
+    {
+      if(namespaceMaps[i].pool == &pool)
+	{
+	  used += arrayBytes(namespaceMaps[i].maxnfnames*sizeof(symbol));
+	}
+    }
 
-  //Check if this name already exists
-  for(int i = 0; i < nCalledF; i++)
+  if(4*used < 3*pool.bytes())
     {
-      if(fcalls[i].name.compare(fname) == 0)
+      //Copy the used arrays to a new arena
+      arena fresh;
+      if(maxFnames > 0)
 	{
-	  //Found, move all following calls
-	  for(int j = i; j < nCalledF-1; j++)
+	  symbol* paux = fresh.allocArray<symbol>(maxFnames);
+	  for(int i = 0; i < nFnames; i++){paux[i] = defFuncNames[i];}
+	  defFuncNames = paux;
+	}
+      if(maxNamespaces > 0)
+	{
+	  symbol* paux = fresh.allocArray<symbol>(maxNamespaces);
+	  for(int i = 0; i < nNamespaces; i++){paux[i] = namespaces[i];}
+	  namespaces = paux;
+	}
+      for(int i = 0; i < nFunctions; i++)
+	{
+	  function_map& f = functions[i];
+	  if(f.pool != &pool)
+	    continue;
+	  if(f.maxNamespaces > 0)
 	    {
-	      fcalls[j] = fcalls[j+1];
+	      symbol* paux = fresh.allocArray<symbol>(f.maxNamespaces);
+	      for(int j = 0; j < f.nNamespaces; j++){paux[j] = f.namespaces[j];}
+	      f.namespaces = paux;
+	    }
+	  if(f.maxCalledF > 0)
+	    {
+	      fcall* paux = fresh.allocArray<fcall>(f.maxCalledF);
+	      for(int j = 0; j < f.nCalledF; j++){paux[j] = f.fcalls[j];}
+	      f.fcalls = paux;
+	    }
+	}
+      for(int i = 0; i < nNamespaceMaps; i++)
+	{
+	  namespace_map& ns = namespaceMaps[i];
+	  if(ns.pool == &pool && ns.maxnfnames > 0)
+	    {
+	      symbol* paux = fresh.allocArray<symbol>(ns.maxnfnames);
+	      for(int j = 0; j < ns.nfnames; j++){paux[j] = ns.functionsNames[j];}
+	      ns.functionsNames = paux;
 	    }
-	  nCalledF--;
-	  return 0;
 	}
-    }
 
-  return -1;
+      //Functions keep pointing to 'pool', which takes the new chunks
+      pool.release();
+      pool.adopt(fresh);
+    }
+  poolCheck = pool.bytes()+pool.bytes()/4;
 }
 
+void source_map::releaseNames(const function_map& f)
+{
+  // This function removes the references of the
+  // removed function 'f' to its namespaces. The names
+  // and namespaces left without functions are added
+  // to 'releasedNames' and 'releasedNS'.
 
-//Clear function
+  if(nameCount.count(f.name.id()) == 0)
+    {
+      releasedNames.add(f.name.id());
+    }
+  for(int j = 0; j < f.nNamespaces; j++)
+    {
+      int m = namespaceMapIndex.find(f.namespaces[j].id());
+      if(m >= 0 && namespaceMaps[m].removeF(f.name) == 0 && namespaceMaps[m].numFN() == 0)
+	{
+	  releasedNS.add(f.namespaces[j].id());
+	}
+    }
+}
 
-void function_map::clear()
+void source_map::dropNames()
 {
-  if(maxNamespaces > 0)
+  // This function removes the names and namespaces
+  // released by removed functions, unless other
+  // functions use them again.
+
+  if(releasedNames.empty() && releasedNS.empty())
+    return;
+
+  id_bitmap droppedNames;
+  id_bitmap droppedNS;
+  unsigned int* ids = new unsigned int[std::max(releasedNames.size(), releasedNS.size())];
+  int nids = (int) releasedNames.toArray(ids);
+  for(int k = 0; k < nids; k++)
     {
-      delete [] namespaces;
+      if(nameCount.count(ids[k]) == 0 && fnameSet.contains(ids[k]))
+	{
+	  droppedNames.add(ids[k]);
+	  removedNames.add(fnamePosition.erase(ids[k]));
+	}
     }
-  if(maxCalledF > 0)
+  nids = (int) releasedNS.toArray(ids);
+  for(int k = 0; k < nids; k++)
     {
-      delete [] fcalls;
+      int m = namespaceMapIndex.find(ids[k]);
+      if(m >= 0 && namespaceMaps[m].numFN() == 0){droppedNS.add(ids[k]);}
     }
-  
-  nNamespaces = 0;
-  nCalledF = 0;
+  delete [] ids;
+  releasedNames.clear();
+  releasedNS.clear();
 
-  maxNamespaces = 0;
-  maxCalledF = 0;
+  int n;
   
-  nOverload = 0;
-
-  name.assign("****"); //Default name
-  sourceFile.assign("****"); //Default source
+  //Remove the namespaces without functions
+  if(!droppedNS.empty())
+    {
+      n = 0;
+      for(int i = 0; i < nNamespaces; i++)
+	{
+	  if(!droppedNS.contains(namespaces[i].id()))
+	    {
+	      namespaces[n] = namespaces[i];
+	      n++;
+	    }
+	}
+      nNamespaces = n;
+      n = 0;
+      for(int i = 0; i < nNamespaceMaps; i++)
+	{
+	  if(!droppedNS.contains(namespaceMaps[i].name.id()))
+	    {
+	      namespaceMaps[n].swap(namespaceMaps[i]);
+	      n++;
+	    }
+	}
+      for(int i = n; i < nNamespaceMaps; i++)
+	{
+	  namespaceMaps[i].clear();
+	}
+      nNamespaceMaps = n;
+    }
   
+  //Mark the names without functions. They are
+  //moved when there are too many
+  if(!droppedNames.empty())
+    {
+      fnameSet.andNotWith(droppedNames);
+      if(2*removedNames.size() > (unsigned int) nFnames)
+	{
+	  compactNames();
+	}
+    }
+  if(!droppedNS.empty())
+    {
+      indexNames();
+    }
 }
 
-//To string function
-
-std::string function_map::to_string(int tabs) const
+void source_map::compactNames()
 {
-  // This function convert the function_map
-  // to formated string.
-  //
-  // 'tabs' variable specifies the number of
-  // inintial tabs to align the text
+  // This function removes the names marked in
+  // 'removedNames' from 'defFuncNames'.
 
-  std::string out;
+  if(removedNames.empty())
+    return;
 
-  //Name
-  out.append(tabs,'\t');
-  out.append("function name: ");
-  out.append(name);
-  out.append(1,'\n');
+  int n = 0;
+  fnamePosition.clear();
+  for(int i = 0; i < nFnames; i++)
+    {
+      if(removedNames.contains(i))
+	continue;
+      defFuncNames[n] = defFuncNames[i];
+      fnamePosition.insert(defFuncNames[n].id(), n);
+      n++;
+    }
+  nFnames = n;
+  removedNames.clear();
+}
 
-  //source file
-  out.append(tabs+1,'\t');
-  out.append("  source file: ");
-  out.append(sourceFile);
-  out.append(1,'\n');
+int source_map::removeF(const char* functionName, const char* sourceFile, int overload)
+{
+  //This function removes one or more function
+  //stored in the source map that match the
+  //specified name, source and overload.
+  //
+  //return 0 on succes
+  //return -1 if specified function doesn't exists
 
-  //overload
-  out.append(tabs+1,'\t');
-  out.append("     overload: ");
+  //Names that have not been interned are not mapped
+  symbol fname, sname;
+  if(!symbol::find(functionName, fname)){return -1;}
+  if(sourceFile != 0 && !symbol::find(sourceFile, sname)){return -1;}
 
-  char overloadChar[10];
-  sprintf(overloadChar,"%d",nOverload);
-  
-  out.append(overloadChar);
-  out.append(1,'\n');
-  
-  //namespaces used
-  out.append(tabs+1,'\t');
-  out.append("   namespaces: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nNamespaces; i++)
+  if(markFunctions(fname, sourceFile != 0 ? &sname : 0, overload) == 0)
     {
-      out.append(tabs+2,'\t');
-      out.append("               ");
-      out.append(namespaces[i]);
-      out.append(1,'\n');
+      //The specified function has not been found
+      return -1;
     }
 
-  //functions called
-  out.append(tabs+1,'\t');
-  out.append("        calls: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nCalledF; i++)
-    {
-      out.append(tabs+2,'\t');
-
-      int auxL = fcalls[i].name.length();
-      int remaining = 15-auxL;
+  //Marked functions are moved when
+  //the map is compacted
+  dropNames();
+  collectRemoved();
+  return 0;
+}
 
-      if(remaining > 0)
-	{
-	  out.append(remaining,' ');
-	}
-      out.append(fcalls[i].name);
-      out.append(": ");
+int source_map::removeFunctions(const char** functionNames, int n, const char** sourceFiles, const int* overloads)
+{
+  //This function removes the functions that match
+  //each specified name, source and overload, and
+  //returns the number of removed functions.
 
-      char callsChar[30];
-      sprintf(callsChar,"%20d",fcalls[i].calls);
-      
-      out.append(callsChar);
-      out.append(1,'\n');
+  int nremoved = 0;
+  for(int i = 0; i < n; i++)
+    {
+      const char* sourceFile = sourceFiles != 0 ? sourceFiles[i] : 0;
+      symbol fname, sname;
+      if(functionNames[i] == 0 || !symbol::find(functionNames[i], fname))
+	continue;
+      if(sourceFile != 0 && !symbol::find(sourceFile, sname))
+	continue;
+      nremoved += markFunctions(fname, sourceFile != 0 ? &sname : 0, overloads != 0 ? overloads[i] : -1);
     }
 
-  return out;
-  
+  //Marked functions are compacted later, all at once
+  dropNames();
+  collectRemoved();
+  return nremoved;
 }
 
-//Acces functions
-
-//Sort function
-
-void function_map::sort()
+int source_map::removeF(int i)
 {
-  //This function sort function and namespace names in function_map
-
-  //Namespaces
-  std::sort(namespaces, namespaces+nNamespaces, stringOrder);
+  //This function removes a function stored
+  //in the source map. The removed function
+  //is which has been stored in position 'i'.
+  //
+  //return 0 on succes
+  //return -1 if 'i' is out of range
 
-  //Function calls
-  std::sort(fcalls,fcalls+nCalledF);
+  //'i' is a position of the compacted map
+  if(i >= 0 && i < numF())
+    {
+      markRemoved(removedF.empty() ? i : (int) removedF.nthMissing(i));
+      dropNames();
+      collectRemoved();
+      return 0;
+    }
+  return -1;
 }
 
-//Operator =
+void source_map::compact()
+{
+  compactFunctions();
+  compactNames();
+}
 
-function_map& function_map::operator=(const function_map& c)
-{  
-  //Clear local function_map
-  clear();
+//Update function
 
-  //Copy all variables
-  nNamespaces    = c.nNamespaces;
-  nCalledF       = c.nCalledF;
+void source_map::update()
+{
+  //This function updates used namespaces,
+  //defined function names and function indexes
 
-  maxNamespaces  = c.maxNamespaces;
-  maxCalledF     = c.maxCalledF;
+  compactFunctions();
+  indexFunctions(0);
   
-  nOverload      = c.nOverload;
-
-  //Handle dinamic arrays and pointers
-
-  //namespaces
-  namespaces = 0;
-  if(maxNamespaces > 0)
+  //Clear namespace maps
+  for(int i = 0; i < nNamespaceMaps; i++)
     {
-      namespaces = new std::string[maxNamespaces];
-      for(int i = 0; i < nNamespaces; i++)
-	{
-	  namespaces[i].assign(c.namespaces[i]);
-	}
+      namespaceMaps[i].clear();
     }
+  nNamespaceMaps = 0;
   
-  //fcalls
-  fcalls = 0;
-  if(maxCalledF > 0)
+  nNamespaces = 0;
+  nFnames = 0;
+
+  fnameSet.clear();
+  fnamePosition.clear();
+  removedNames.clear();
+  namespaceIndex.clear();
+  namespaceMapIndex.clear();
+
+  for(int i = 0; i < nFunctions; i++)
     {
-      fcalls = new fcall[maxCalledF];
-      for(int i = 0; i < nCalledF; i++)
+      //Check namespaces
+      useNamespaces(i);
+
+      //Check existence of function name
+      if(fnameSet.add(functions[i].name.id()) == 0)
 	{
-	  fcalls[i] = c.fcalls[i];
+	  //Check array size
+	  if(nFnames >= maxFnames)
+	    {
+	      resizeFN(5+maxFnames*2);
+	    }
+
+	  //Add this function name
+	  defFuncNames[nFnames] = functions[i].name;
+	  fnamePosition.insert(functions[i].name.id(), nFnames);
+	  nFnames++;
 	}
     }
-
-  //Handle strings
-  name.assign(c.name);
-  sourceFile.assign(c.sourceFile);
-  
-  return (*this);
 }
 
-//Operator <
-
-bool function_map::operator<(const function_map& c) const
+int source_map::checkMaps() const
 {
-  //operator < used for sort function_map variables
+  // This function compares the defined names and the
+  // references of the namespace maps with the ones
+  // built from the functions by 'update'.
+  //
+  // return the number of differences. Functions
+  // marked as removed are skipped, they have released
+  // their names and namespaces.
 
-  int value = this->name.compare(c.name);
-  if(value < 0)
+  int errors = 0;
+
+  //Defined function names
+  id_bitmap names;
+  for(int i = 0; i < nFunctions; i++)
     {
-      // The first character that does not match has a lower value in
-      // "this->name". Considere "this" smaller than "c".
-      return true;      
+      if(removedF.contains(i))
+	continue;
+      names.add(functions[i].name.id());
     }
-  else if(value > 0)
+  if(names.size() != fnameSet.size() || (int) names.size() != numFN() ||
+     fnamePosition.size() != fnameSet.size())
     {
-      // The first character that does not match has a lower value in
-      // "c.name". Considere "c" smaller than "this".
-      return false;      
+      errors++;
     }
-  else
+  for(int i = 0; i < nFnames; i++)
     {
-      // Both names are equal. Compare source files
-      value = this->sourceFile.compare(c.sourceFile);
-      if(value < 0)
+      if(removedNames.contains(i))
+	continue;
+      unsigned int id = defFuncNames[i].id();
+      if(!names.contains(id) || !fnameSet.contains(id) || fnamePosition.find(id) != i)
+	errors++;
+    }
+
+  //Pairs namespace/function name, one for each function
+  std::vector<std::pair<unsigned int,unsigned int> > uses;
+  for(int i = 0; i < nFunctions; i++)
+    {
+      if(removedF.contains(i))
+	continue;
+      for(int j = 0; j < functions[i].nNamespaces; j++)
 	{
-	  // The first character that does not match has a lower value in
-	  // "this->sourceFile". Considere "this" smaller than "c".
-	  return true;      
+	  uses.push_back(std::make_pair(functions[i].namespaces[j].id(), functions[i].name.id()));
 	}
-      else if(value > 0)
+    }
+  std::sort(uses.begin(), uses.end());
+
+  //Each pair must be counted by its namespace map
+  int nused = 0;
+  for(std::size_t i = 0; i < uses.size(); )
+    {
+      std::size_t j = i;
+      while(j < uses.size() && uses[j] == uses[i]){j++;}
+      int m = namespaceMapIndex.find(uses[i].first);
+      if(m < 0 || namespaceMaps[m].references(symbol::fromId(uses[i].second)) != (int) (j-i))
+	errors++;
+      if(i == 0 || uses[i].first != uses[i-1].first)
+	nused++;
+      i = j;
+    }
+
+  //And the maps can't store other references
+  std::size_t nrefs = 0;
+  for(int m = 0; m < nNamespaceMaps; m++)
+    {
+      const namespace_map& ns = namespaceMaps[m];
+      for(int i = 0; i < ns.nfnames; i++)
 	{
-	  // The first character that does not match has a lower value in
-	  // "c.sourceFile" or both are equal. Don't considere "this" smaller than "c".
-	  return false;      
+	  nrefs += ns.references(ns.functionsNames[i]);
 	}
-      else
+    }
+  if(nrefs != uses.size() || nused != nNamespaceMaps || nused != nNamespaces)
+    {
+      errors++;
+    }
+
+  //Each function must be in one range of its file, and
+  //the ranges must only contain functions of the file
+  std::vector<int> covered(nFunctions, 0);
+  for(std::unordered_map<unsigned int,std::vector<function_range> >::const_iterator it = sourceRanges.begin();
+      it != sourceRanges.end(); ++it)
+    {
+      for(std::size_t k = 0; k < it->second.size(); k++)
 	{
-	  //Check overload
-	  return (this->nOverload < c.nOverload);
+	  int end = indexedPosition(it->second[k].end);
+	  for(int i = indexedPosition(it->second[k].first); i < end; i++)
+	    {
+	      if(i < 0 || i >= nFunctions || functions[i].sourceFile.id() != it->first)
+		{
+		  errors++;
+		  continue;
+		}
+	      covered[i]++;
+	    }
 	}
     }
-}
-
-//Operator >
-
-bool function_map::operator>(const function_map& c) const
-{
-  //operator > used for sort function_map variables
+  for(int i = 0; i < nFunctions; i++)
+    {
+      //The ranges of removed files are dropped before compaction
+      if(removedF.contains(i) ? covered[i] > 1 : covered[i] != 1)
+	errors++;
+    }
 
-  int value = this->name.compare(c.name);
-  if(value < 0)
+  //Names with more than one function must store the sorted
+  //positions of all of them, starting at the indexed one
+  std::size_t nrepeated = 0;
+  for(std::unordered_map<unsigned int,int>::const_iterator it = nameCount.begin(); it != nameCount.end(); ++it)
     {
-      // The first character that does not match has a lower value in
-      // "this->name". Considere "this" smaller than "c".
-      return false;      
+      if(it->second > 1){nrepeated++;}
     }
-  else if(value > 0)
+  if(nrepeated != namePositions.size())
     {
-      // The first character that does not match has a lower value in
-      // "c.name". Considere "c" smaller than "this".
-      return true;      
+      errors++;
     }
-  else
+  for(std::unordered_map<unsigned int,std::vector<int> >::const_iterator it = namePositions.begin();
+      it != namePositions.end(); ++it)
     {
-      // Both names are equal. Compare source files
-      value = this->sourceFile.compare(c.sourceFile);
-      if(value < 0)
-	{
-	  // The first character that does not match has a lower value in
-	  // "this->sourceFile". Considere "this" smaller than "c".
-	  return false;      
-	}
-      else if (value > 0)
+      const std::vector<int>& positions = it->second;
+      std::unordered_map<unsigned int,int>::const_iterator count = nameCount.find(it->first);
+      std::unordered_map<unsigned int,int>::const_iterator first = nameIndex.find(it->first);
+      if(count == nameCount.end() || count->second != (int) positions.size() ||
+	 first == nameIndex.end() || positions.empty() || first->second != positions[0])
 	{
-	  // The first character that does not match has a lower value in
-	  // "c.sourceFile" or both are equal. Don't considere "this" smaller than "c".
-	  return true;      
+	  errors++;
+	  continue;
 	}
-      else
+      for(std::size_t k = 0; k < positions.size(); k++)
 	{
-	  //Check overload
-	  return (this->nOverload > c.nOverload);
+	  int i = indexedPosition(positions[k]);
+	  if((k > 0 && positions[k] <= positions[k-1]) || i < 0 || i >= nFunctions ||
+	     removedF.contains(i) || functions[i].name.id() != it->first)
+	    errors++;
 	}
     }
+  
+  return errors;
 }
 
-//Destructor
+//Clear function
 
-function_map::~function_map()
+void source_map::clear()
 {
-  clear();
-}
-
-
-//**************************//
-//   source map functions   //
-//**************************//
-
-//Constructor
+  //Arrays of the arena are freed together
+  delete [] functions;
+  delete [] namespaceMaps;
+  pool.release();
+  poolCheck = 0;
+  namespaces = 0;
+  defFuncNames = 0;
+  functions = 0;
+  namespaceMaps = 0;
 
-source_map::source_map()
-{
   nNamespaces = 0;
   nFunctions = 0;
   nFnames = 0;
@@ -932,901 +6304,1040 @@ source_map::source_map()
   maxFnames = 0;
   maxNamespaces = 0;
   maxNamespaceMaps = 0;
+  fnameSet.clear();
+  fnamePosition.clear();
+  removedNames.clear();
+  namespaceIndex.clear();
+  namespaceMapIndex.clear();
+
+  delete [] files;
+  files = 0;
+  nFiles = 0;
+  maxFiles = 0;
+  fileIndex.clear();
+  functionIndex.clear();
+  nameIndex.clear();
+  nameCount.clear();
+  namePositions.clear();
+  sourceRanges.clear();
+  removedF.clear();
+  releasedNames.clear();
+  releasedNS.clear();
+  indexGaps.clear();
   
-  namespaces = 0;
-  defFuncNames = 0;
-  functions = 0;
-  namespaceMaps = 0;
-
-}
-
-//Load function
-
-int source_map::loadSource(const char* filename)
-{
-  // This function create a map from specified
-  // filename file. The map will be cleared
-  // before the new load.
-  //
-  // return 0 on succes
-  // return -1 if file can't be opened
-  // return -2 if an error clearing the code occurs
-  // return -3 if there are not any function definition
-  //           in specified source file
-  //
-
-  //Clear map
-  clear();
-  
-  return appendSource(filename);
+  stats.clear();
 }
 
-//Append map function
+//Sort function
 
-int source_map::appendSource(const char* filename)
+void source_map::nameRanks(std::vector<unsigned int>& ranks) const
 {
-  // This function create a map from specified
-  // filename file. The new map will be appended
-  // to existing maps.
-  //
-  // return 0 on succes
-  // return -1 if file can't be opened
-  // return -2 if an error clearing the code occurs
-  // return -3 if there are not any function definition
-  //           in specified source file
-  //
-
-  //Read and store the file text
-  std::string text;
-  if(readFile(filename, text) != 0)
-    {
-      //Error reading the specified filename
-      return -1;
-    }
+  // This function stores the alphabetical position
+  // of each name used by the map, indexed by his id.
 
-  //Clear code from strings and comments
-  int errClear = clearCode(text);
-  if(errClear == -5)
+  //Collect the distinct ids
+  ranks.assign(symbol::count(), UINT_MAX);
+  std::vector<std::pair<const std::string*,unsigned int> > used;
+  auto use = [&](const symbol& s)
     {
-      return -2;
-    }
-
-  //Extract defined function names
-  std::string* auxDF = 0;
-  int readF = definedFunc(text,auxDF);
-
-  if(readF == 0)
+      if(ranks[s.id()] == UINT_MAX)
+	{
+	  ranks[s.id()] = 0;
+	  used.push_back(std::make_pair(&s.str(), s.id()));
+	}
+    };
+  for(int i = 0; i < nNamespaces; i++){use(namespaces[i]);}
+  for(int i = 0; i < nFnames; i++){use(defFuncNames[i]);}
+  for(int i = 0; i < nFunctions; i++)
     {
-      //No function definitions in specified source file
-      return -3;
+      const function_map& f = functions[i];
+      use(f.name);
+      use(f.sourceFile);
+      for(int j = 0; j < f.nNamespaces; j++){use(f.namespaces[j]);}
+      for(int j = 0; j < f.nCalledF; j++){use(f.fcalls[j].name);}
     }
-  
-  //Calculate total names number of defined functions
-  int totalDF = nFnames + readF;
-  int oldnFnames = nFnames;
-  if(totalDF > maxFnames)
+  for(int i = 0; i < nNamespaceMaps; i++)
     {
-      //Resize arrays to save new values
-      resizeFN(2*totalDF);
+      const namespace_map& ns = namespaceMaps[i];
+      use(ns.name);
+      for(int j = 0; j < ns.nfnames; j++){use(ns.functionsNames[j]);}
     }
 
-  //Save readed names
-  for(int i = 0; i < readF; i++)
+  //Sort them by text once
+  std::sort(used.begin(), used.end(),
+	    [](const std::pair<const std::string*,unsigned int>& a,
+	       const std::pair<const std::string*,unsigned int>& b){return *a.first < *b.first;});
+  for(std::size_t i = 0; i < used.size(); i++)
     {
-      //Check if this name already exists
-      if(nameMatch(defFuncNames,nFnames,auxDF[i].c_str()) < 0)
-	{
-	  //Store new function name
-	  defFuncNames[nFnames].assign(auxDF[i]);
-	  nFnames++;
-	}
+      ranks[used[i].second] = (unsigned int) i;
     }
+}
 
-  //Check the remaining space in
-  //'functions' array
-  if(nFunctions == maxFunctions)
-    {
-      resizeF(maxFunctions+2*readF);
-    }
+void source_map::sort()
+{
+  //This function sort function and namespace names in function_map.
+  //Names are ranked alphabetically once, and then all arrays are
+  //sorted comparing ranks instead of texts
+
+  compactFunctions();
+  compactNames();
+  std::vector<unsigned int> ranks;
+  nameRanks(ranks);
+  const unsigned int* rank = ranks.data();
+  auto byRank = [rank](const symbol& a, const symbol& b){return rank[a.id()] < rank[b.id()];};
   
-  //Extract information of each function
-  //defined in this source file
-  for(int i = 0; i < readF; i++)
+  //Namespaces names
+  std::sort(namespaces, namespaces+nNamespaces, byRank);
+  
+  //Function names
+  std::sort(defFuncNames, defFuncNames+nFnames, byRank);
+  fnamePosition.clear();
+  for(int i = 0; i < nFnames; i++)
     {
-      int overload = 1;
-      //Load all overloads of defined 'i' function
-      while(functions[nFunctions].loadFunction(text, auxDF[i].c_str(), overload) == 0)
-	{	  
-	  //Succesfull function load
-
-	  //Store source filename
-	  functions[nFunctions].sourceFile.assign(filename);
-	  
-	  //Increment overload counter and number of functions
-	  overload++;
-	  nFunctions++;
+      fnamePosition.insert(defFuncNames[i].id(), i);
+    }
 
-	  //Check the remaining space in
-	  //'functions' array
-	  if(nFunctions == maxFunctions)
+  //Function array, by name, source file and overload. The
+  //elements are moved so their arrays are not copied
+  std::sort(functions, functions+nFunctions,
+	    [rank](const function_map& a, const function_map& b)
 	    {
-	      //Duplicate space
-	      resizeF(2*maxFunctions);
-	    }
-	}
-    }
+	      unsigned int ra = rank[a.name.id()], rb = rank[b.name.id()];
+	      if(ra != rb){return ra < rb;}
+	      ra = rank[a.sourceFile.id()];
+	      rb = rank[b.sourceFile.id()];
+	      if(ra != rb){return ra < rb;}
+	      return a.nOverload < b.nOverload;
+	    });
+  indexSorted();
 
-  //Check namespaces array remaining space
-  if(nNamespaces >= maxNamespaces)
+  //Namespaces array
+  std::sort(namespaceMaps, namespaceMaps+nNamespaceMaps,
+	    [&byRank](const namespace_map& a, const namespace_map& b){return byRank(a.name, b.name);});
+  indexNames();
+  
+  //Finally, sort each function and namespace
+  for(int i = 0; i < nFunctions; i++)
     {
-      resizeNSN(maxNamespaces+10);      
+      functions[i].sort(rank);
     }
-
-  if(nNamespaceMaps >= maxNamespaceMaps)
+  for(int i = 0; i < nNamespaceMaps; i++)
     {
-      resizeNS(maxNamespaceMaps+10);
+      namespaceMaps[i].sort(rank);
     }
-  
-  //Extract used namespaces from defined functions
-  for(int i = oldnFnames; i < nFunctions; i++)
-    {
-      for(int j = 0; j < functions[i].nNamespaces; j++)
-	{
-	  if(nameMatch(namespaces,nNamespaces,functions[i].namespaces[j].c_str()) < 0)
-	    {
-	      //This namespace is not included
-	      namespaces[nNamespaces].assign(functions[i].namespaces[j]);
-	      nNamespaces++;
+}
 
-	      namespaceMaps[nNamespaceMaps].name.assign(functions[i].namespaces[j]);
-	      namespaceMaps[nNamespaceMaps].appendF(functions[i].name.c_str());
-	      nNamespaceMaps++;
-		
-	      //Check the remaining space in
-	      //'namespaces' array
-	      if(nNamespaces == maxNamespaces)
-		{
-		  //Duplicate space
-		  resizeNSN(2*maxNamespaces);
-		}
-	      if(nNamespaceMaps >= maxNamespaceMaps)
-		{
-		  resizeNS(2*maxNamespaceMaps);
-		}
-	    }
-	  else
-	    {
-	      //This namespace already exists, find it
-	      for(int k = 0; k < nNamespaceMaps; k++)
-		{
-		  if(namespaceMaps[k].name.compare(functions[i].namespaces[j]) == 0)
-		    {
-		      //Check if this namespace contains already this function
-		      bool found = false;
-		      for(int l = 0; l < namespaceMaps[k].nfnames; l++)
-			{
-			  if(namespaceMaps[k].functionsNames[l].compare(functions[i].name) == 0)
-			    {
-			      found = true;
-			      break;
-			    }
-			}
-		      //If not found, append function name
-		      if(!found)
-			{
-			  namespaceMaps[k].appendF(functions[i].name.c_str());
-			}
-		      
-		      break;
-		    }
-		}
-	    }
+//Filter functions
+
+int source_map::filterFunctions(const char** namesNS, const int nNS, std::string* outF, int& nF) const
+{
+  //This function return function names that uses all
+  //specified namespace names.
+
+  // namesNS -> array with the names of namespaces to filter
+  //     nNS -> number of namespaces to filter
+  //    outF -> array of strings containing filtered function names
+  //      nF -> in: Maximum number of matches, out: Number of matches
+
+  //
+  // return  0 on succes
+  // return -1 if there are more possible matches than specified nF value.
+  // return -2 if some namespace doesn't exists
+
+  id_bitmap selected;
+  int rValue = filterFunctions(namesNS, nNS, selected);
+  if(rValue != 0){return rValue;}
+  return selectedNames(selected, outF, nF);
+}
+
+int source_map::filterFunctions(const char** namesNS, const int nNS, id_bitmap& selected) const
+{
+  //This function selects the functions that uses all
+  //specified namespaces intersecting their sets.
+  //
+  // return  0 on succes
+  // return -2 if some namespace doesn't exists
+
+  selected.clear();
+  for(int i = 0; i < nNS; i++)
+    {
+      const namespace_map* ns = getNamespace(namesNS[i]);
+      if(ns == 0)
+	{
+	  selected.clear();
+	  return -2;
 	}
+
+      if(i == 0){selected = ns->fnameSet;}
+      else{selected.andWith(ns->fnameSet);}
+
+      //Check for remaining possible function matches
+      if(selected.empty()){break;}
     }
-  
-  //Free auxiliar array memory 
-  delete [] auxDF;
   return 0;
 }
 
-//To string function
-
-std::string source_map::to_string(int tabs) const
+int source_map::filterAnyFunctions(const char** namesNS, const int nNS, id_bitmap& selected) const
 {
-  //Convert all source map to text format and
-  //return this text as string.
-  //
-  // 'tabs' specifies the number of initial
-  // tabulations '\t' to use
+  //This function selects the functions that uses some
+  //specified namespace joining their sets. Not existing
+  //namespaces are considered empty.
   //
+  // return  0 on succes
+  // return -2 if some namespace doesn't exists
 
-  std::string out;
-
-  //Functions names
-  out.append(tabs,'\t');
-  out.append("Defined functions names: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nFnames; i++)
+  int rValue = 0;
+  selected.clear();
+  for(int i = 0; i < nNS; i++)
     {
-      out.append(tabs+1,'\t');
-      out.append("                         ");
-      out.append(defFuncNames[i]);
-      out.append(1,'\n');
+      const namespace_map* ns = getNamespace(namesNS[i]);
+      if(ns == 0){rValue = -2;}
+      else{selected.orWith(ns->fnameSet);}
     }
+  return rValue;
+}
 
-  //Namespace names
-  out.append(tabs,'\t');
-  out.append("        Used namespaces: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nNamespaces; i++)
+int source_map::excludeFunctions(const char** namesNS, const int nNS, id_bitmap& selected) const
+{
+  //This function removes from 'selected' the functions
+  //that uses some specified namespace. Not existing
+  //namespaces are considered empty.
+  //
+  // return  0 on succes
+  // return -2 if some namespace doesn't exists
+
+  int rValue = 0;
+  for(int i = 0; i < nNS && !selected.empty(); i++)
     {
-      out.append(tabs+1,'\t');
-      out.append("                         ");
-      out.append(namespaces[i]);
-      out.append(1,'\n');
+      const namespace_map* ns = getNamespace(namesNS[i]);
+      if(ns == 0){rValue = -2;}
+      else{selected.andNotWith(ns->fnameSet);}
     }
+  return rValue;
+}
 
-  //Namespaces
-  out.append(tabs,'\t');
-  out.append("         Namespace maps: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nNamespaceMaps; i++)
+int source_map::selectedNames(const id_bitmap& selected, std::string* outF, int& nF) const
+{
+  //This function stores the names of the selected
+  //functions in alphabetical order.
+  //
+  // return  0 on succes
+  // return -1 if there are more selected functions than specified nF value.
+
+  if(selected.size() > (unsigned int) nF){return -1;}
+
+  unsigned int* ids = new unsigned int[selected.size() > 0 ? selected.size() : 1];
+  int n = (int) selected.toArray(ids);
+  symbol* names = new symbol[n > 0 ? n : 1];
+  for(int j = 0; j < n; j++)
     {
-      out.append(namespaceMaps[i].to_string(tabs+3));
-      out.append(1,'\n');
+      names[j] = symbol::fromId(ids[j]);
     }
+  std::sort(names, names+n);
   
-  //Functions
-  out.append(tabs,'\t');
-  out.append("              Functions: ");
-  out.append(1,'\n');
-  for(int i = 0; i < nFnames; i++)
+  for(int j = 0; j < n; j++)
     {
-      out.append(functions[i].to_string(tabs+3));
-      out.append(1,'\n');
+      outF[j].assign(names[j].str());
     }
-
-  //Return output string
-  return out;
+  nF = n;
+  
+  delete [] ids;
+  delete [] names;
+  return 0;
 }
 
-//Acces functions
+//Resize functions
 
-std::string source_map::getNamespaceName(int i) const
+void source_map::resizeFN(int dim)
 {
-  std::string aux;
-  if(i >= 0 && i < nNamespaces)
+  //Resize array defFuncNames to size 'dim'. The old
+  //array is released with the arena.
+
+  symbol* paux = defFuncNames;
+  defFuncNames = pool.allocArray<symbol>(dim);
+      
+  int limit =  nFnames < dim ? nFnames : dim;
+      
+  for(int i = 0; i < limit; i++)
     {
-      aux.assign(namespaces[i]);
+      defFuncNames[i].assign(paux[i]);
     }
-  else{aux.clear();}
-  
-  return aux;
+      
+  nFnames = limit;
+  maxFnames = dim;
 }
 
-std::string source_map::getFName(int i) const
+void source_map::resizeF(int dim)
 {
-  std::string aux;
-  if(i >= 0 && i < nFnames)
+  //Resize array 'functions' to size 'dim'. Functions
+  //are moved, so their arrays are not copied.
+
+  function_map* paux = functions;
+  functions = new function_map[dim];
+
+  int limit =  nFunctions < dim ? nFunctions : dim;
+
+  for(int i = 0; i < limit; i++)
     {
-      aux.assign(defFuncNames[i]);
+      functions[i].swap(paux[i]);
     }
-  else{aux.clear();}
   
-  return aux;
+  //Empty functions allocate their arrays in the arena
+  for(int i = limit; i < dim; i++)
+    {
+      functions[i].pool = &pool;
+    }
+
+  nFunctions = limit;
+  maxFunctions = dim;  
+  
+  // delete old array
+  delete [] paux;
 }
 
-const function_map* source_map::getFunction(const char* functionName, const char* sourceFile, int overload) const
+void source_map::resizeNS(int dim)
 {
-  //Return a inmutable pointer for the specified function.
-  
-  for(int i = 0; i < nFunctions; i++)
-    {
-      //Check function name
-      if(functions[i].name.compare(functionName) == 0)
-	{
-	  //Check if source file has been specified for match
-	  if(sourceFile == 0)
-	    {
-	      //Don't care of source name, return first function name match
-	      return &functions[i];
-	    }
+  //Resize array 'namespaceMaps' to size 'dim'. Namespaces
+  //are moved, so their arrays are not copied.
 
-	  //Check source filename
-	  if(functions[i].sourceFile.compare(sourceFile) == 0)
-	    {
-	      //Check if overload has been specified for match
-	      if(overload <= 0)
-		{
-		  //Don't care of overload number, return first function
-		  //that are matching in name and source file.
-		  return &functions[i];		  
-		}
+  namespace_map* paux = namespaceMaps;
+  namespaceMaps = new namespace_map[dim];
 
-	      //Check overload number
-	      if(functions[i].nOverload == overload)
-		{
-		  return &functions[i];
-		}
-	    }
-	}
-    }
-  return 0;
-}
+  int limit =  nNamespaceMaps < dim ? nNamespaceMaps : dim;
 
-const function_map* source_map::getFunction(int i) const
-{
-  //Return a inmutable pointer for the specified function.
+  for(int i = 0; i < limit; i++)
+    {
+      namespaceMaps[i].swap(paux[i]);
+    }
   
-  if(i >= 0 && i < nFunctions)
+  //Empty namespaces allocate their arrays in the arena
+  for(int i = limit; i < dim; i++)
     {
-      return &functions[i];
+      namespaceMaps[i].pool = &pool;
     }
-  return 0;
-}
 
-//Acces namespace
+  nNamespaceMaps = limit;
+  maxNamespaceMaps = dim;  
+  
+  // delete old array
+  delete [] paux;
+}
 
-const namespace_map* source_map::getNamespace(const char* namespaceName) const
+void source_map::resizeFR(int dim)
 {
-  //Return a inmutable pointer for the specified namespace object.
+  //Resize array files to size 'dim'
 
-  //return null pointer if namespace name has not been found
-  
-  for(int i = 0; i < nNamespaceMaps; i++)
+  file_record* paux = files;
+  files = new file_record[dim];
+
+  int limit =  nFiles < dim ? nFiles : dim;
+  for(int i = 0; i < limit; i++)
     {
-      if(namespaceMaps[i].name.compare(namespaceName) == 0)
-	{
-	  return &namespaceMaps[i];
-	}
+      files[i].path.swap(paux[i].path);
+      files[i].size = paux[i].size;
+      files[i].mtime = paux[i].mtime;
+      files[i].hash = paux[i].hash;
     }
-  return 0;
+  nFiles = limit;
+  maxFiles = dim;
+
+  // delete old array
+  delete [] paux;
 }
 
-const namespace_map* source_map::getNamespace(int i) const
+void source_map::resizeNSN(int dim)
 {
-  //Return a inmutable pointer for the specified function.
-  
-  if(i >= 0 && i < nNamespaceMaps)
+  //Resize array namespaces to size 'dim'. The old
+  //array is released with the arena.
+
+  symbol* paux = namespaces;
+  namespaces = pool.allocArray<symbol>(dim);
+
+  int limit =  nNamespaces < dim ? nNamespaces : dim;
+
+  for(int i = 0; i < limit; i++)
     {
-      return &namespaceMaps[i];
+      namespaces[i].assign(paux[i]);
     }
-  return 0;
-}
 
+  nNamespaces = limit;
+  maxNamespaces = dim;
+}
 
-//Remove functions
 
-int source_map::removeF(const char* functionName, const char* sourceFile, int overload)
+int source_map::tree(int& nleafs, leaf*& tree) const
 {
-  //This function removes one or more function
-  //stored in the source map. The removed functions
-  //are which has been stored in position 'i'.
+  //This function create a dependence function tree
   //
-  //return 0 on succes
-  //return -1 if specified function doesn't exists
+  //return number of leafs on succes
+  //return -1 if map has not any defined function
+  //
+  //
+  
+  //Build the links of all functions
+  dep_graph g;
+  if(graph(g) < 0)
+    return -1;
+  
+  //Allocate memory for one leaf for each node
+  tree = new leaf[g.nNodes+1];
+  nleafs = g.nNodes;
 
-  bool found = false;
-  for(int i = 0; i < nFunctions; i++)
+  //Initialize all leafs names, overloads and links. Links
+  //of the graph are unique, so are copied without checks.
+  for(int i = 0; i < g.nNodes; i++)
     {
-      //Check function name
-      if(functions[i].name.compare(functionName) == 0)
-	{
-	  //Check if source file has been specified for match
-	  if(sourceFile == 0)
-	    {
-	      //Don't care of source name remove this function
-	      for(int j = i; j < nFunctions-1; j++)
-		{
-		  functions[j] = functions[j+1];
-		}
-	      nFunctions--;
-	      i--;
-	      found = true;
-	      continue;
-	    }
+      tree[i].name.assign(g.names[i]);
+      tree[i].overload = g.overloads[i];
 
-	  //Check source filename
-	  if(functions[i].sourceFile.compare(sourceFile) == 0)
+      int nlinks = g.getNumLinks(i);
+      if(nlinks > 0)
+	{
+	  tree[i].links = new leaf*[nlinks];
+	  tree[i].maxLinks = nlinks;
+	  tree[i].nLinks = nlinks;
+	  for(int j = 0; j < nlinks; j++)
 	    {
-	      //Check if overload has been specified for match
-	      if(overload <= 0)
-		{
-		  //Don't care of overload number,
-		  //remove this function
-		  for(int j = i; j < nFunctions-1; j++)
-		    {
-		      functions[j] = functions[j+1];
-		    }
-		  nFunctions--;
-		  i--;
-		  found = true;
-		  continue;
-		}
-
-	      //Check overload number
-	      if(functions[i].nOverload == overload)
-		{
-		  for(int j = i; j < nFunctions-1; j++)
-		    {
-		      functions[j] = functions[j+1];
-		    }
-		  nFunctions--;
-		  i--;
-		  found = true;
-		}
+	      tree[i].links[j] = &tree[g.getLink(i,j)];
 	    }
 	}
     }
 
-  //Check if the specified function has
-  //been found.
-  if(found)
-    {
-      //Update function and namespaces names
-      update();
-      return 0;
-    }
-  else
-    {
-      return -1;
-    }
+  return nleafs;
+  
 }
 
-int source_map::removeF(int i)
+int source_map::graph(dep_graph& g) const
 {
-  //This function removes a function stored
-  //in the source map. The removed function
-  //is which has been stored in position 'i'.
+  //This function create the dependence graph in
+  //compressed sparse row format
   //
-  //return 0 on succes
-  //return -1 if 'i' is out of range
+  //return number of nodes on succes
+  //return -1 if map has not any defined function
+  //
+
+  g.clear();
+  
+  //Check if there are some functions in the map
+  int nnodes = numF();
+  if(nnodes <= 0)
+    return -1;
 
-  if(i >= 0 && i < nFunctions)
+  //Nodes are the functions not marked as removed, in map order
+  const function_map** nodes = new const function_map*[nnodes];
+  for(int i = 0, n = 0; i < nFunctions; i++)
     {
-      for(int j = i; j < nFunctions-1; j++)
-	{
-	  functions[j] = functions[j+1];
-	}
-      
-      //Update defined function names and
-      //used namespaces
-      update();
-      return 0;
+      if(!removedF.contains(i)){nodes[n++] = &functions[i];}
     }
-  return -1;
-}
-
-//Update function
 
-void source_map::update()
-{
-  //This function updates used namespaces
-  //and defined function names
-
-  //Clear namespace maps
-  for(int i = 0; i < nNamespaceMaps; i++)
+  //Group the functions by name. The functions of each group are
+  //stored, in map order, from 'groupStart[k]' to 'groupStart[k+1]'
+  id_index groupIndex;
+  groupIndex.reserve(nnodes);
+  int* group = new int[nnodes];
+  int ngroups = 0;
+  for(int i = 0; i < nnodes; i++)
     {
-      namespaceMaps[i].clear();
+      int k = groupIndex.insert(nodes[i]->name.id(), ngroups);
+      if(k < 0){k = ngroups++;}
+      group[i] = k;
     }
-  nNamespaceMaps = 0;
   
-  nNamespaces = 0;
-  nFnames = 0;
-
-  for(int i = 0; i < nFunctions; i++)
+  int* groupStart = new int[ngroups+1];
+  memset(groupStart, 0, (ngroups+1)*sizeof(int));
+  for(int i = 0; i < nnodes; i++)
     {
-      //Check namespaces
-      for(int j = 0; j < functions[i].nNamespaces; j++)
-	{
-	  if(nameMatch(namespaces, nNamespaces, functions[i].namespaces[j].c_str()) < 0)
-	    {
-	      //This namespace is not in the array
-	      //Check array sizes 
-	      if(nNamespaces >= maxNamespaces)
-		{
-		  //Resize namespaces array
-		  resizeNSN(5+maxNamespaces*2);
-		}
-	      if(nNamespaceMaps >= maxNamespaceMaps)
-		{
-		  resizeNS(10+maxNamespaceMaps*2);
-		}
-	      
-	      
-	      //Add this namespace
-	      namespaces[nNamespaces].assign(functions[i].namespaces[j]);
-	      nNamespaces++;
-
-	      namespaceMaps[nNamespaceMaps].name.assign(functions[i].namespaces[j]);
-	      namespaceMaps[nNamespaceMaps].appendF(functions[i].name.c_str());
-	      nNamespaceMaps++;
-	    }
-	  else
-	    {
-	      //This namespace already exists, find it
-	      for(int k = 0; k < nNamespaceMaps; k++)
-		{
-		  if(namespaceMaps[k].name.compare(functions[i].namespaces[j]) == 0)
-		    {
-		      //Check if this namespace contains already this function
-		      bool found = false;
-		      for(int l = 0; l < namespaceMaps[k].nfnames; l++)
-			{
-			  if(namespaceMaps[k].functionsNames[l].compare(functions[i].name) == 0)
-			    {
-			      found = true;
-			      break;
-			    }
-			}
-		      //If not found, append function name
-		      if(!found)
-			{
-			  namespaceMaps[k].appendF(functions[i].name.c_str());
-			}
-		      break;
-		    }
-		}
-	    }
-	}
+      groupStart[group[i]+1]++;
+    }
+  for(int k = 0; k < ngroups; k++)
+    {
+      groupStart[k+1] += groupStart[k];
+    }
+  int* members = new int[nnodes];
+  int* fill = new int[ngroups];
+  memcpy(fill, groupStart, ngroups*sizeof(int));
+  for(int i = 0; i < nnodes; i++)
+    {
+      members[fill[group[i]]++] = i;
+    }
+  delete [] fill;
 
-      //Check existence of function name
-      if(nameMatch(defFuncNames, nFnames, functions[i].name.c_str()) < 0)
+  //Count the links of each function. Self links are skipped.
+  g.nNodes = nnodes;
+  g.offsets = new int[nnodes+1];
+  g.offsets[0] = 0;
+  for(int i = 0; i < nnodes; i++)
+    {
+      int nlinks = 0;
+      for(int j = 0; j < nodes[i]->nCalledF; j++)
 	{
-	  //Check array size
-	  if(nFnames <= maxFnames)
+	  int k = groupIndex.find(nodes[i]->fcalls[j].name.id());
+	  if(k < 0){continue;} //Not defined function
+	  nlinks += groupStart[k+1]-groupStart[k];
+	  if(k == group[i]){nlinks--;}
+	}
+      g.offsets[i+1] = g.offsets[i]+nlinks;
+    }
+  g.nEdges = g.offsets[nnodes];
+
+  //Store the links
+  g.targets = new int[g.nEdges > 0 ? g.nEdges : 1];
+  g.weights = new int[g.nEdges > 0 ? g.nEdges : 1];
+  g.names = new symbol[nnodes];
+  g.overloads = new int[nnodes];
+  for(int i = 0; i < nnodes; i++)
+    {
+      g.names[i] = nodes[i]->name;
+      g.overloads[i] = nodes[i]->nOverload;
+      
+      int pos = g.offsets[i];
+      for(int j = 0; j < nodes[i]->nCalledF; j++)
+	{
+	  const fcall& call = nodes[i]->fcalls[j];
+	  int k = groupIndex.find(call.name.id());
+	  if(k < 0){continue;}
+	  for(int m = groupStart[k]; m < groupStart[k+1]; m++)
 	    {
-	      resizeFN(5+maxFnames*2);
+	      if(members[m] == i){continue;}
+	      g.targets[pos] = members[m];
+	      g.weights[pos] = call.calls;
+	      pos++;
 	    }
-
-	  //Add this function name
-	  defFuncNames[nFnames].assign(functions[i].name);
-	  nFnames++;
 	}
     }
+
+  delete [] nodes;
+  delete [] group;
+  delete [] groupStart;
+  delete [] members;
+  
+  return g.nNodes;
 }
 
-//Clear function
+//Destructor
 
-void source_map::clear()
+source_map::~source_map()
 {
-  if(maxNamespaces > 0)
-    {
-      delete [] namespaces;
-    }
-  if(maxFnames > 0)
-    {
-      delete [] defFuncNames;
-    }
-  if(maxFunctions > 0)
-    {
-      delete [] functions;
-    }
+  clear();
+  liveMaps--;
+}
 
-  nNamespaces = 0;
-  nFunctions = 0;
-  nFnames = 0;
+//**************************//
+//  source watch functions  //
+//**************************//
 
-  maxFunctions = 0;
-  maxFnames = 0;
-  maxNamespaces = 0;
-  
+/// Events that can change the mapped files of a watched directory
+static const uint32_t watchMask = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+/// Join a directory path and an entry name
+static std::string joinPath(const std::string& dir, const char* name)
+{
+  if(dir.empty()){return std::string(name);}
+  if(dir[dir.length()-1] == '/'){return dir + name;}
+  return dir + "/" + name;
 }
 
-//Sort function
+watch_update::watch_update()
+{
+  clear();
+}
 
-void source_map::sort()
+void watch_update::clear()
 {
-  //This function sort function and namespace names in function_map
-  
-  //Namespaces names
-  std::sort(namespaces, namespaces+nNamespaces, stringOrder);
-  
-  //Function names
-  std::sort(defFuncNames, defFuncNames+nFnames, stringOrder);
+  events = 0;
+  files = 0;
+  changed = 0;
+  wait = 0.0;
+  updateTime = 0.0;
+  latency = 0.0;
+}
 
-  //Function array
-  std::sort(functions,functions+nFunctions);
+source_watch::source_watch() : map(0), fd(-1), nevents(0), firstEvent(0.0), overflow(false), quiet(0.05), maxDelay(1.0), updates(0), totalLatency(0.0), maxLatency(0.0), threads(0)
+{}
 
-  //Namespaces array
-  std::sort(namespaceMaps,namespaceMaps+nNamespaceMaps);
-  
-  //Finally, sort each function and namespace
-  for(int i = 0; i < nFunctions; i++)
+int source_watch::start(source_map& inMap, double inQuiet, double inMaxDelay)
+{
+  // This function starts to watch the directories
+  // of all files mapped in 'inMap'.
+  //
+  // return the number of watched directories
+  // return -1 if inotify can't be initialized
+  //
+
+  stop();
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(fd < 0)
     {
-      functions[i].sort();
+      return -1;
     }
-  for(int i = 0; i < nNamespaceMaps; i++)
+
+  map = &inMap;
+  quiet = inQuiet > 0.0 ? inQuiet : 0.0;
+  maxDelay = inMaxDelay > quiet ? inMaxDelay : quiet;
+  updates = 0;
+  totalLatency = 0.0;
+  maxLatency = 0.0;
+
+  //Watch the directory of each mapped file
+  std::set<std::string> watched;
+  for(int i = 0; i < map->numFiles(); i++)
     {
-      namespaceMaps[i].sort();
+      const std::string& path = map->getFile(i)->path;
+      std::size_t pos = path.rfind('/');
+      std::string dir;
+      if(pos == 0){dir.assign("/");}
+      else if(pos != std::string::npos){dir.assign(path, 0, pos);}
+      if(watched.insert(dir).second)
+	{
+	  watchDir(dir, std::string(), -1);
+	}
     }
+  
+  return (int) dirs.size();
 }
 
-//Filter functions
-
-int source_map::filterFunctions(const char** namesNS, const int nNS, std::string* outF, int& nF) const
+int source_watch::addDirectory(const char* root, const crawl_options& options)
 {
-  //This function return function names that uses all
-  //specified namespace names.
+  // This function watches all not excluded
+  // directories of the tree 'root'.
+  //
+  // return the number of watched directories
+  // return -1 if the watch is not started
+  // return -2 if 'root' can't be watched
+  //
 
-  // namesNS -> array with the names of namespaces to filter
-  //     nNS -> number of namespaces to filter
-  //    outF -> array of strings containing filtered function names
-  //      nF -> in: Maximum number of matches, out: Number of matches
+  if(fd < 0){return -1;}
 
-  //
-  // return  0 on succes
-  // return -1 if there are more possible matches than specified nF value.
-  // return -2 if some namespace doesn't exists
-  
+  //Remove final '/' of root path, as appendDirectory does
+  std::string rootPath(root);
+  while(rootPath.length() > 1 && rootPath[rootPath.length()-1] == '/')
+    {
+      rootPath.erase(rootPath.length()-1);
+    }
 
-  for(int i = 0; i < nNS; i++) //Iterate all specified namespaces
+  roots.push_back(std::make_pair(rootPath, options));
+  int nwatched = watchTree(rootPath, std::string(), (int) roots.size()-1, false);
+  if(nwatched <= 0)
     {
-      //Find specified namespace
-      int posNS = -1;
-      for(int k = 0; k < nNamespaceMaps; k++)
-	{
-	  if(namespaceMaps[k].name.compare(namesNS[i]) == 0)
-	    {
-	      posNS = k;
-	      break;
-	    }
-	}
+      roots.pop_back();
+      return -2;
+    }
+  return nwatched;
+}
+
+int source_watch::watchDir(const std::string& path, const std::string& rel, int root)
+{
+  // This function adds a watch to the directory 'path'.
+  //
+  // return the watch descriptor
+  // return -1 on error
+  //
 
-      if(posNS < 0){return -2;}  //Check if namespace name has been found
+  int wd = inotify_add_watch(fd, path.empty() ? "." : path.c_str(), watchMask);
+  if(wd < 0)
+    {
+      return -1;
+    }
 
-      if(i == 0) //Is the first namespace, append all his functions
-	{
-	  //Check output array size
-	  if(nF < namespaceMaps[posNS].nfnames){return -1;}
-	  
-	  //Store actual number of filtered functions
-	  nF = namespaceMaps[posNS].nfnames;
+  //The same directory can be watched as root member
+  //and as directory of mapped files. Keep root info.
+  std::unordered_map<int,watch_dir>::iterator it = dirs.find(wd);
+  if(it != dirs.end() && root < 0)
+    {
+      return wd;
+    }
+  watch_dir& dir = dirs[wd];
+  dir.path = path;
+  dir.rel = rel;
+  dir.root = root;
+  if(it == dirs.end())
+    {
+      dir.moved = false;
+    }
+  return wd;
+}
 
-	  if(nF == 0){return 0;}
+int source_watch::watchTree(const std::string& path, const std::string& rel, int root, bool addFiles)
+{
+  // This function watches the directory tree 'path'
+  // skipping excluded directories. If 'addFiles' is
+  // true, accepted files are set as pending.
+  //
+  // return the number of watched directories
+  //
 
-	  //Store function names
-	  for(int j = 0; j < nF; j++)
+  const crawl_options& options = roots[root].second;
+  std::set<int> visited;
+  std::vector< std::pair<std::string,std::string> > walk(1, std::make_pair(path, rel));
+  int nwatched = 0;
+  while(!walk.empty())
+    {
+      std::string dirPath, dirRel;
+      dirPath.swap(walk.back().first);
+      dirRel.swap(walk.back().second);
+      walk.pop_back();
+
+      //Avoid loops through linked directories
+      int wd = watchDir(dirPath, dirRel, root);
+      if(wd < 0 || !visited.insert(wd).second){continue;}
+      nwatched++;
+      
+      DIR* pdir = opendir(dirPath.c_str());
+      if(pdir == 0){continue;}
+      struct dirent* entry;
+      while((entry = readdir(pdir)) != 0)
+	{
+	  const char* name = entry->d_name;
+	  if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0){continue;}
+	  std::string entryPath = joinPath(dirPath, name);
+	  std::string entryRel = joinPath(dirRel, name);
+
+	  //Resolve entry type, only links and unknown types need a stat
+	  unsigned char type = entry->d_type;
+	  if(type == DT_UNKNOWN || (type == DT_LNK && options.followLinks))
 	    {
-	      outF[j].assign(namespaceMaps[posNS].functionsNames[j]);
+	      struct stat st;
+	      int err = options.followLinks ? stat(entryPath.c_str(), &st) : lstat(entryPath.c_str(), &st);
+	      if(err != 0){continue;}
+	      if(S_ISDIR(st.st_mode)){type = DT_DIR;}
+	      else if(S_ISREG(st.st_mode)){type = DT_REG;}
+	      else{continue;}
 	    }
-	}
-      else
-	{
-	  //Is not the first namespace, all function names in outF 
-	  //that are not in he current namespace's function list must be removed.
-
-	  //Store number of functions that uses this namespace
-	  int NSnfunc = namespaceMaps[posNS].nfnames;
 
-	  //Check all possible filtered functions in outF
-	  for(int j = nF-1; j >= 0; j--) 
+	  if(type == DT_DIR)
 	    {
-	      //Search outF functions in this namespace
-	      int pos = nameMatch(namespaceMaps[posNS].functionsNames, NSnfunc, outF[j].c_str());
-
-	      if(pos < 0)
+	      if(!options.excluded(entryRel.c_str(), name, true))
 		{
-		  //This function don't uses current namespace,
-		  //remove it.
-		  for(int k = j; k < nF-1; k++)
-		    {
-		      outF[k].assign(outF[k+1]);
-		    }
-		  nF--; //Reduce the number of possible matches
-		}	     
+		  walk.push_back(std::make_pair(entryPath, entryRel));
+		}
 	    }
-	  //Check for remaining possible function matches
-	  if(nF == 0)
+	  else if(type == DT_REG && addFiles)
 	    {
-	      return 0;
+	      if(options.accepted(name) && !options.excluded(entryRel.c_str(), name, false))
+		{
+		  pending.insert(entryPath);
+		}
 	    }
 	}
+      closedir(pdir);
     }
-  
-  return 0;
+  return nwatched;
 }
-//Resize functions
 
-void source_map::resizeFN(int dim)
+int source_watch::pendingDir(const std::string& path)
 {
-  //Resize array defFuncNames to size 'dim'
+  // This function sets as pending all
+  // mapped files inside directory 'path'.
+  //
+  // return the number of pending files added
+  //
 
-  if(nFnames > 0)
+  std::string prefix = joinPath(path, "");
+  int added = 0;
+  for(int i = 0; i < map->numFiles(); i++)
     {
-      std::string* paux = defFuncNames;
-      defFuncNames = 0;
-      defFuncNames = new std::string[dim];
-      
-      int limit =  nFnames < dim ? nFnames : dim;
-      
-      for(int i = 0; i < limit; i++)
+      const std::string& file = map->getFile(i)->path;
+      if(file.compare(0, prefix.length(), prefix) == 0 && pending.insert(file).second)
 	{
-	  defFuncNames[i].assign(paux[i]);
+	  added++;
 	}
-      
-      nFnames = limit;
-      
-      // delete old array
-      delete [] paux;
-    }
-  else if(defFuncNames != 0)
-    {
-      delete [] defFuncNames;
-      defFuncNames = new std::string[dim];      
-      nFnames = 0;
-    }
-  else
-    {
-      defFuncNames = new std::string[dim];            
-      nFnames = 0;
     }
-  maxFnames = dim;
+  return added;
 }
 
-void source_map::resizeF(int dim)
+int source_watch::renameDir(const std::string& from, const std::string& to, const std::string& rel)
 {
-  //Resize array 'functions' to size 'dim'
-
-  if(nFunctions > 0)
-    {  
-      function_map* paux = functions;
-      functions = 0;
-      functions = new function_map[dim];
-
-      int limit =  nFunctions < dim ? nFunctions : dim;
+  // This function rewrites the paths of the watched
+  // directory 'from' and its subdirectories after
+  // renaming it to 'to'.
+  //
+  // return the watch descriptor of 'from'
+  // return -1 if 'from' is not watched
+  //
 
-      for(int i = 0; i < limit; i++)
+  std::string prefix = joinPath(from, "");
+  int renamed = -1;
+  for(std::unordered_map<int,watch_dir>::iterator it = dirs.begin(); it != dirs.end(); ++it)
+    {
+      watch_dir& dir = it->second;
+      if(dir.path == from)
 	{
-	  functions[i] = paux[i];
+	  dir.path = to;
+	  dir.rel = rel;
+	  renamed = it->first;
+	}
+      else if(dir.path.compare(0, prefix.length(), prefix) == 0)
+	{
+	  std::string suffix = dir.path.substr(prefix.length());
+	  dir.path = joinPath(to, suffix.c_str());
+	  dir.rel = joinPath(rel, suffix.c_str());
 	}
-
-      nFunctions = limit;
-  
-      // delete old array
-      delete [] paux;
-    }
-  else if(functions != 0)
-    {
-      delete [] functions;
-      functions = new function_map[dim];      
-      nFunctions = 0;
-    }
-  else
-    {
-      functions = new function_map[dim];      
-      nFunctions = 0;
     }
-  maxFunctions = dim;  
+  return renamed;
 }
 
-void source_map::resizeNS(int dim)
+void source_watch::unwatchDir(const std::string& path)
 {
-  //Resize array 'functions' to size 'dim'
+  // This function removes the watches of 'path'
+  // and its subdirectories. Entries are erased
+  // when the IN_IGNORED events arrive.
 
-  if(nNamespaceMaps > 0)
-    {  
-      namespace_map* paux = namespaceMaps;
-      namespaceMaps = 0;
-      namespaceMaps = new namespace_map[dim];
+  std::string prefix = joinPath(path, "");
+  for(std::unordered_map<int,watch_dir>::const_iterator it = dirs.begin(); it != dirs.end(); ++it)
+    {
+      if(it->second.path == path || (!path.empty() && it->second.path.compare(0, prefix.length(), prefix) == 0))
+	{
+	  inotify_rm_watch(fd, it->first);
+	}
+    }
+}
 
-      int limit =  nNamespaceMaps < dim ? nNamespaceMaps : dim;
+int source_watch::readEvents()
+{
+  // This function reads all available events and
+  // stores the affected files as pending.
+  //
+  // return the number of relevant events
+  // return -1 on read error
+  //
 
-      for(int i = 0; i < limit; i++)
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  int relevant = 0;
+  for(;;)
+    {
+      ssize_t length = read(fd, buffer, sizeof(buffer));
+      if(length < 0)
 	{
-	  namespaceMaps[i] = paux[i];
+	  if(errno == EINTR){continue;}
+	  if(errno == EAGAIN || errno == EWOULDBLOCK){break;}
+	  return -1;
 	}
+      if(length == 0){break;}
 
-      nNamespaceMaps = limit;
-  
-      // delete old array
-      delete [] paux;
-    }
-  else if(namespaceMaps != 0)
-    {
-      delete [] namespaceMaps;
-      namespaceMaps = new namespace_map[dim];      
-      nNamespaceMaps = 0;
+      for(char* p = buffer; p < buffer + length; )
+	{
+	  const struct inotify_event* event = (const struct inotify_event*) p;
+	  p += sizeof(struct inotify_event) + event->len;
+	  
+	  if(event->mask & IN_Q_OVERFLOW)
+	    {
+	      //Some events have been lost
+	      overflow = true;
+	      relevant++;
+	      continue;
+	    }
+	  
+	  std::unordered_map<int,watch_dir>::iterator it = dirs.find(event->wd);
+	  if(it == dirs.end()){continue;}
+	  if(event->mask & IN_IGNORED)
+	    {
+	      //Watch removed
+	      dirs.erase(it);
+	      continue;
+	    }
+	  //Copy directory info, the table can be modified
+	  watch_dir dir = it->second;
+
+	  if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+	    {
+	      if((event->mask & IN_MOVE_SELF) && dir.moved)
+		{
+		  //Renamed inside a watched tree, the watch
+		  //has been registered with the new path
+		  it->second.moved = false;
+		  continue;
+		}
+	      //Watched directory removed or moved out
+	      if(event->mask & IN_MOVE_SELF){unwatchDir(dir.path);}
+	      relevant += pendingDir(dir.path);
+	      continue;
+	    }
+	  if(event->len == 0){continue;}
+
+	  const char* name = event->name;
+	  std::string path = joinPath(dir.path, name);
+	  std::string rel = joinPath(dir.rel, name);
+	  if(event->mask & IN_ISDIR)
+	    {
+	      if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+		{
+		  //Mapped files in this directory have been removed
+		  relevant += pendingDir(path);
+		  if(event->mask & IN_MOVED_FROM){movedDirs[event->cookie] = path;}
+		}
+	      else if(dir.root >= 0 && !roots[dir.root].second.excluded(rel.c_str(), name, true))
+		{
+		  //Renamed watched directory, move the watches
+		  //of its subdirectories to the new path
+		  int renamed = -1;
+		  std::unordered_map<unsigned int,std::string>::iterator from = movedDirs.end();
+		  if(event->mask & IN_MOVED_TO){from = movedDirs.find(event->cookie);}
+		  if(from != movedDirs.end())
+		    {
+		      renamed = renameDir(from->second, path, rel);
+		      movedDirs.erase(from);
+		    }
+
+		  //New directory inside a watched tree
+		  std::size_t before = pending.size();
+		  watchTree(path, rel, dir.root, true);
+		  relevant += (int) (pending.size() - before);
+
+		  //Keep the watch when IN_MOVE_SELF arrives
+		  std::unordered_map<int,watch_dir>::iterator moved = dirs.find(renamed);
+		  if(moved != dirs.end() && moved->second.path == path)
+		    {
+		      moved->second.moved = true;
+		    }
+		}
+	      continue;
+	    }
+
+	  //Regular file: only mapped and accepted files are relevant
+	  if(map->hasFile(path) ||
+	     (dir.root >= 0 && roots[dir.root].second.accepted(name) &&
+	      !roots[dir.root].second.excluded(rel.c_str(), name, false)))
+	    {
+	      pending.insert(path);
+	      relevant++;
+	    }
+	}
     }
-  else
+
+  if(relevant > 0 && nevents == 0)
     {
-      namespaceMaps = new namespace_map[dim];      
-      nNamespaceMaps = 0;
+      firstEvent = wallTime();
     }
-  maxNamespaceMaps = dim;  
+  nevents += relevant;
+  return relevant;
 }
 
-void source_map::resizeNSN(int dim)
+void source_watch::apply(watch_update* info)
 {
-  //Resize array namespaces to size 'dim'
+  // This function maps again the pending files.
 
-  if(nNamespaces > 0)
+  double tstart = wallTime();
+  int changed = 0;
+  if(overflow)
     {
-      std::string* paux = namespaces;
-      namespaces = 0;
-      namespaces = new std::string[dim];
-
-      int limit =  nNamespaces < dim ? nNamespaces : dim;
-
-      for(int i = 0; i < limit; i++)
+      //Lost events: look for new files in watched
+      //trees and check all mapped files
+      for(std::size_t i = 0; i < roots.size(); i++)
 	{
-	  namespaces[i].assign(paux[i]);
+	  watchTree(roots[i].first, std::string(), (int) i, true);
 	}
-
-      nNamespaces = limit;
-  
-      // delete old array
-      delete [] paux;
+      changed += map->rescan(threads);
     }
-  else if(namespaces != 0)
+
+  std::vector<const char*> paths;
+  paths.reserve(pending.size());
+  for(std::set<std::string>::const_iterator it = pending.begin(); it != pending.end(); it++)
     {
-      delete [] namespaces;
-      namespaces = new std::string[dim];      
-      nNamespaces = 0;
+      paths.push_back(it->c_str());
     }
-  else
+  changed += map->refresh(paths.data(), (int) paths.size(), threads);
+  double tend = wallTime();
+
+  //Update latency counters
+  double latency = tend - firstEvent;
+  updates++;
+  totalLatency += latency;
+  if(latency > maxLatency){maxLatency = latency;}
+  
+  if(info != 0)
     {
-      namespaces = new std::string[dim];            
-      nNamespaces = 0;
+      info->events = nevents;
+      info->files = (int) paths.size();
+      info->changed = changed;
+      info->wait = tstart - firstEvent;
+      info->updateTime = tend - tstart;
+      info->latency = latency;
     }
-  maxNamespaces = dim;
-}
 
+  pending.clear();
+  movedDirs.clear();
+  nevents = 0;
+  overflow = false;
+}
 
-int source_map::tree(int& nleafs, leaf*& tree) const
+int source_watch::poll(int timeout, watch_update* info)
 {
-  //This function create a dependence function tree
-  //
-  //return number of leafs on succes
-  //return -1 if map has not any defined function
+  // This function waits for relevant events, coalesces
+  // them and applies a single update.
   //
+  // return 1 if an update has been applied
+  // return 0 on timeout
+  // return -1 if the watch is not started
+  // return -2 on read error
   //
-  
-  //Check if there are some functions in the map
-  if(nFunctions <= 0)
-    return -1;
-  
-  //Allocate memory for one leaf for each function
-  tree = new leaf[nFunctions+1];
-  nleafs = nFunctions;
 
-  //Initialize all leafs names and overloads
-  for(int i = 0; i < nFunctions; i++)
+  if(fd < 0){return -1;}
+
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+
+  //Wait for the first relevant event
+  double deadline = wallTime() + timeout/1000.0;
+  while(nevents == 0)
     {
-      tree[i].name.assign(functions[i].name);
-      tree[i].overload = functions[i].nOverload;
+      int wait = -1;
+      if(timeout >= 0)
+	{
+	  double remaining = deadline - wallTime();
+	  wait = remaining > 0.0 ? (int) ceil(remaining*1000.0) : 0;
+	}
+      pfd.revents = 0;
+      int err = ::poll(&pfd, 1, wait);
+      if(err < 0)
+	{
+	  if(errno == EINTR){continue;}
+	  return -2;
+	}
+      if(err == 0){return 0;}
+      if(readEvents() < 0){return -2;}
     }
-  
-  //Connect each defined function with all his dependences
-  for(int i = 0; i < nFunctions; i++)
+
+  //Coalesce events until a quiet period or the maximum delay
+  for(;;)
     {
-      //Iterate for all dependencies
-      for(int j = 0; j < functions[i].nCalledF; j++)
+      double remaining = maxDelay - (wallTime() - firstEvent);
+      if(remaining <= 0.0){break;}
+      double wait = remaining < quiet ? remaining : quiet;
+      pfd.revents = 0;
+      int err = ::poll(&pfd, 1, (int) ceil(wait*1000.0));
+      if(err < 0)
 	{
-	  //Extract dependence name
-	  std::string dName(functions[i].fcalls[j].name);
-
-	  //Check the name of all leafs
-	  for(int k = 0; k < nFunctions; k++)
-	    {
-	      if(dName.compare(tree[k].name) == 0)
-		{
-		  //Connect to this leaf
-		  tree[i].connect(&tree[k]);
-		}
-	    }
+	  if(errno == EINTR){continue;}
+	  return -2;
 	}
+      if(err == 0){break;}
+      if(readEvents() < 0){return -2;}
     }
 
-  return nleafs;
-  
+  apply(info);
+  return 1;
 }
 
-//Destructor
+void source_watch::stop()
+{
+  if(fd >= 0)
+    {
+      close(fd);
+    }
+  fd = -1;
+  map = 0;
+  dirs.clear();
+  roots.clear();
+  pending.clear();
+  movedDirs.clear();
+  nevents = 0;
+  overflow = false;
+}
 
-source_map::~source_map()
+source_watch::~source_watch()
 {
-  clear();
+  stop();
 }
 
 //**********************//
@@ -1839,7 +7350,7 @@ bool blankString(const char* string)
   int length = strlen(string);
   for(int i = 0; i < length; i++)
     {
-      if(!isblank(string[i]))
+      if(!(charClass(string[i]) & CHAR_BLANK))
 	{
 	  return false;
 	}
@@ -1847,6 +7358,85 @@ bool blankString(const char* string)
   return true;
 }
 
+double wallTime()
+{
+  // Return a monotonic clock time in seconds
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1.0e-9*(double) ts.tv_nsec;
+}
+
+static const unsigned long long hashPrime1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long hashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+/// Initialize the four hash lanes of #contentHash
+static void hashInit(unsigned long long lanes[4])
+{
+  lanes[0] = hashPrime1;
+  lanes[1] = hashPrime2;
+  lanes[2] = ~hashPrime1;
+  lanes[3] = ~hashPrime2;
+}
+
+/// Mix the 32 bytes blocks of 'data' in 'lanes'. Return the number of processed bytes.
+static std::size_t hashBlocks(unsigned long long lanes[4], const char* data, std::size_t length)
+{
+  std::size_t i = 0;
+  for(; i + 32 <= length; i += 32)
+    {
+      for(int j = 0; j < 4; j++)
+	{
+	  unsigned long long word;
+	  memcpy(&word, data+i+8*j, 8);
+	  lanes[j] += word*hashPrime2;
+	  lanes[j] = (lanes[j] << 31) | (lanes[j] >> 33);
+	  lanes[j] *= hashPrime1;
+	}
+    }
+  return i;
+}
+
+/// Combine 'lanes', total 'length' and the last 'ntail' (< 32) bytes
+static unsigned long long hashFinish(const unsigned long long lanes[4], unsigned long long length, const char* tail, std::size_t ntail)
+{
+  //Combine lanes and length
+  unsigned long long h = length*hashPrime1;
+  for(int j = 0; j < 4; j++)
+    {
+      h ^= lanes[j];
+      h = ((h << 27) | (h >> 37))*hashPrime1 + hashPrime2;
+    }
+
+  //Remaining bytes
+  for(std::size_t i = 0; i < ntail; i++)
+    {
+      h ^= (unsigned char) tail[i];
+      h *= hashPrime1;
+      h ^= h >> 29;
+    }
+
+  //Final avalanche
+  h ^= h >> 33;
+  h *= hashPrime2;
+  h ^= h >> 29;
+  h *= hashPrime1;
+  h ^= h >> 32;
+  return h;
+}
+
+unsigned long long contentHash(const char* data, std::size_t length)
+{
+  // This function hashes 'data' processing 32 bytes
+  // per iteration in four independent lanes. Each
+  // lane mixes 8 bytes words with a multiply-rotate
+  // step. Lanes and tail are combined at the end.
+
+  unsigned long long lanes[4];
+  hashInit(lanes);
+  std::size_t i = hashBlocks(lanes, data, length);
+  return hashFinish(lanes, length, data+i, length-i);
+}
+
 int readFile(const char* filename, std::string& store)
 {
   // This function reads the entire file with path "filename"
@@ -1854,26 +7444,20 @@ int readFile(const char* filename, std::string& store)
   //
   // return 0 on succes or -1 if can't open file
   //
-  
-  FILE* fin = 0;
-  fin = fopen(filename,"r");
-  if(fin == 0)
-    {
-      return -1;
-    }
-
-  char line[10000];
 
   //Clear output string
   store.clear();
   
-  while(fgets(line,10000,fin) != NULL)
+  //The contents are copied anyway, read them instead
+  //of mapping them, so a truncated file doesn't fault
+  mapped_file file;
+  if(file.open(filename, true) != 0)
     {
-      store.append(line);
+      return -1;
     }
 
-  //Close file
-  fclose(fin);
+  //Copy the whole file at once
+  store.assign(file.data(), file.size());
   
   return 0;
 }
@@ -1955,129 +7539,434 @@ int clearCode(std::string& inS)
   // return -4 if some comment delimited by /* */ are not closed
   // return -5 on error in 'removeText' function
 
-  const char* opening1 = "\"";
-  const char* opening2 = "'";
-  const char* opening3 = "//";
-  const char* opening4 = "/*";
-  
-  const char* limit1 = "\"";
-  const char* limit2 = "'";
-  const char* limit3 = "\n";
-  const char* limit4 = "*/";
+  std::string out;
+  int nremoved = clearCode(inS.c_str(), inS.length(), out);
+  inS.swap(out);
+  return nremoved;
+}
+
+//**********************//
+//     Scan kernels     //
+//**********************//
+
+// Kernels to find the first character of 'p' that can open
+// a string, a char or a comment ('"', '\'' or '/'). All of them
+// return 'n' if there is no such character.
+
+static std::size_t scanCodeScalar(const char* p, std::size_t n)
+{
+  for(std::size_t i = 0; i < n; i++)
+    {
+      if(charClass(p[i]) & (CHAR_QUOTE | CHAR_SLASH))
+	{
+	  return i;
+	}
+    }
+  return n;
+}
+
+#ifdef __CODE_MAP_X86__
+
+__attribute__((target("sse2")))
+static std::size_t scanCodeSSE2(const char* p, std::size_t n)
+{
+  const __m128i dquote = _mm_set1_epi8('"');
+  const __m128i squote = _mm_set1_epi8('\'');
+  const __m128i slash  = _mm_set1_epi8('/');
+
+  std::size_t i = 0;
+  for(; i+16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*) (p+i));
+      __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v,dquote),
+					    _mm_cmpeq_epi8(v,squote)),
+			       _mm_cmpeq_epi8(v,slash));
+      unsigned int mask = (unsigned int) _mm_movemask_epi8(m);
+      if(mask != 0)
+	{
+	  return i + __builtin_ctz(mask);
+	}
+    }
+  return i + scanCodeScalar(p+i, n-i);
+}
+
+__attribute__((target("avx2")))
+static std::size_t scanCodeAVX2(const char* p, std::size_t n)
+{
+  const __m256i dquote = _mm256_set1_epi8('"');
+  const __m256i squote = _mm256_set1_epi8('\'');
+  const __m256i slash  = _mm256_set1_epi8('/');
+
+  std::size_t i = 0;
+  for(; i+32 <= n; i += 32)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*) (p+i));
+      __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v,dquote),
+						  _mm256_cmpeq_epi8(v,squote)),
+				  _mm256_cmpeq_epi8(v,slash));
+      unsigned int mask = (unsigned int) _mm256_movemask_epi8(m);
+      if(mask != 0)
+	{
+	  return i + __builtin_ctz(mask);
+	}
+    }
+  return i + scanCodeSSE2(p+i, n-i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static std::size_t scanCodeAVX512(const char* p, std::size_t n)
+{
+  const __m512i dquote = _mm512_set1_epi8('"');
+  const __m512i squote = _mm512_set1_epi8('\'');
+  const __m512i slash  = _mm512_set1_epi8('/');
+
+  std::size_t i = 0;
+  for(; i+64 <= n; i += 64)
+    {
+      __m512i v = _mm512_loadu_si512((const void*) (p+i));
+      __mmask64 mask = _mm512_cmpeq_epi8_mask(v,dquote) |
+	_mm512_cmpeq_epi8_mask(v,squote) |
+	_mm512_cmpeq_epi8_mask(v,slash);
+      if(mask != 0)
+	{
+	  return i + __builtin_ctzll(mask);
+	}
+    }
+  return i + scanCodeAVX2(p+i, n-i);
+}
+
+#endif
+
+/// Return the best kernel supported by the running cpu
+static int bestScanKernel()
+{
+#ifdef __CODE_MAP_X86__
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f"))
+    {
+      return SCAN_AVX512;
+    }
+  if(__builtin_cpu_supports("avx2"))
+    {
+      return SCAN_AVX2;
+    }
+  return SCAN_SSE2;
+#else
+  return SCAN_SCALAR;
+#endif
+}
+
+typedef std::size_t (*scanKernelPtr)(const char*, std::size_t);
+
+//Selected kernel, initialized with the best one
+//before any thread can use it
+static scanKernelPtr scanKernel = 0;
+static int scanKernelLevel = setScanKernel(-1);
+
+int setScanKernel(int level)
+{
+  // This function selects the kernel used by 'scanCode'.
+  // If 'level' is negative or is not supported by the cpu,
+  // the best supported kernel will be used.
+  //
+  // return the selected kernel
+
+  int best = bestScanKernel();
+  if(level < 0 || level > best)
+    {
+      level = best;
+    }
   
-  int nremoved = 0;
-  std::size_t pos = 0;
-  while(pos != std::string::npos)
+  switch(level)
+    {
+#ifdef __CODE_MAP_X86__
+    case SCAN_AVX512: scanKernel = scanCodeAVX512; break;
+    case SCAN_AVX2:   scanKernel = scanCodeAVX2;   break;
+    case SCAN_SSE2:   scanKernel = scanCodeSSE2;   break;
+#endif
+    default:
+      level = SCAN_SCALAR;
+      scanKernel = scanCodeScalar;
+    }
+  scanKernelLevel = level;
+  return level;
+}
+
+int getScanKernel()
+{
+  return scanKernelLevel;
+}
+
+const char* scanKernelName(int level)
+{
+  switch(level)
+    {
+    case SCAN_SCALAR: return "scalar";
+    case SCAN_SSE2:   return "sse2";
+    case SCAN_AVX2:   return "avx2";
+    case SCAN_AVX512: return "avx512";
+    }
+  return "unknown";
+}
+
+std::size_t scanCode(const char* p, std::size_t n)
+{
+  if(scanKernel == 0)
     {
-      std::size_t found1 = inS.find(opening1,pos);
-      std::size_t found2 = inS.find(opening2,pos);
-      std::size_t found3 = inS.find(opening3,pos);
-      std::size_t found4 = inS.find(opening4,pos);
+      setScanKernel(scanKernelLevel);
+    }
+  return scanKernel(p, n);
+}
+
+//**********************//
+//   Character classes  //
+//**********************//
 
-      if(found1 == std::string::npos && found2 == std::string::npos && found3 == std::string::npos && found4 == std::string::npos)
+/// Compute the classes of character 'c' (see charClasses)
+static constexpr unsigned short charClassOf(int c)
+{
+  return (unsigned short)
+    ((c >= '0' && c <= '9' ? 1 | CHAR_ID : 0) |
+     (c >= 'A' && c <= 'Z' ? 2 | CHAR_ID | CHAR_ID_START : 0) |
+     (c >= 'a' && c <= 'z' ? 3 | CHAR_ID | CHAR_ID_START : 0) |
+     (c == '_' ? 4 | CHAR_ID | CHAR_ID_START : 0) |
+     (c == ' ' || c == '\t' ? CHAR_BLANK : 0) |
+     (c == '\n' ? CHAR_NEWLINE : 0) |
+     (c == ' ' || (c >= '\t' && c <= '\r') ? CHAR_SPACE : 0) |
+     (c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' ? CHAR_BRACKET : 0) |
+     (c == '"' || c == '\'' ? CHAR_QUOTE : 0) |
+     (c == '/' ? CHAR_SLASH : 0));
+}
+
+#define CHAR_CLASS4(c)  charClassOf(c), charClassOf(c+1), charClassOf(c+2), charClassOf(c+3)
+#define CHAR_CLASS16(c) CHAR_CLASS4(c), CHAR_CLASS4(c+4), CHAR_CLASS4(c+8), CHAR_CLASS4(c+12)
+#define CHAR_CLASS64(c) CHAR_CLASS16(c), CHAR_CLASS16(c+16), CHAR_CLASS16(c+32), CHAR_CLASS16(c+48)
+
+constexpr unsigned short charClassTable[256] = {
+  CHAR_CLASS64(0), CHAR_CLASS64(64), CHAR_CLASS64(128), CHAR_CLASS64(192)
+};
+
+#undef CHAR_CLASS64
+#undef CHAR_CLASS16
+#undef CHAR_CLASS4
+
+static_assert((charClassTable[(unsigned char) '7'] & CHAR_RANGE) == 1 &&
+	      (charClassTable[(unsigned char) 'Q'] & CHAR_RANGE) == 2 &&
+	      (charClassTable[(unsigned char) 'q'] & CHAR_RANGE) == 3 &&
+	      (charClassTable[(unsigned char) '_'] & CHAR_RANGE) == 4 &&
+	      charClassTable[0xE1] == 0,
+	      "Wrong character class table");
+
+static std::size_t identifierRunScalar(const char* p, std::size_t pos)
+{
+  std::size_t count = 0;
+  while(count < pos && (charClass(p[pos-1-count]) & CHAR_ID)){count++;}
+  return count;
+}
+
+#ifdef __CODE_MAP_X86__
+
+__attribute__((target("sse2")))
+static std::size_t identifierRunSSE2(const char* p, std::size_t pos)
+{
+  // Classify 16 characters at once. Ranges are checked with
+  // unsigned comparisons: 'c' is in [lo,hi] if 'c-lo' <= 'hi-lo'.
+  const __m128i zero   = _mm_set1_epi8('0');
+  const __m128i nine   = _mm_set1_epi8(9);
+  const __m128i lowerA = _mm_set1_epi8('a');
+  const __m128i nAlpha = _mm_set1_epi8(25);
+  const __m128i upCase = _mm_set1_epi8(0x20);
+  const __m128i under  = _mm_set1_epi8('_');
+
+  std::size_t count = 0;
+  while(pos >= 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*) (p+pos-16));
+      __m128i d = _mm_sub_epi8(v, zero);
+      __m128i l = _mm_sub_epi8(_mm_or_si128(v, upCase), lowerA);
+      __m128i id = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(d, nine), d),
+					     _mm_cmpeq_epi8(_mm_min_epu8(l, nAlpha), l)),
+				_mm_cmpeq_epi8(v, under));
+      unsigned int other = ~((unsigned int) _mm_movemask_epi8(id)) & 0xFFFF;
+      if(other != 0)
 	{
-	  pos = std::string::npos;
+	  //Count the characters after the last non identifier one
+	  return count + ((unsigned int) __builtin_clz(other) - 16);
 	}
-      else if(found1 < found2 && found1 < found3 && found1 < found4)
+      count += 16;
+      pos -= 16;
+    }
+  return count + identifierRunScalar(p, pos);
+}
+
+#endif
+
+std::size_t identifierRun(const char* p, std::size_t pos)
+{
+#ifdef __CODE_MAP_X86__
+  if(scanKernelLevel >= SCAN_SSE2)
+    {
+      return identifierRunSSE2(p, pos);
+    }
+#endif
+  return identifierRunScalar(p, pos);
+}
+
+int clearCode(const char* inS, std::size_t length, std::string& out)
+{
+  // This function copies the 'length' characters of 'inS'
+  // to 'out' removing all hard code strings (text between
+  // "" or '') and comments (// and /* */) in a single
+  // forward pass.
+  //
+  // The removed segments are the same that would be
+  // erased from the text by successive calls to 'removeText'.
+  // Because of that, the last character copied to 'out'
+  // is which precedes the current one once previous segments
+  // have been removed.
+  //
+  // return the number of removed text segments
+  // return -1 if some string delimited by "" are not closed
+  // return -2 if some string delimited by '' are not closed
+  // return -3 if some comment delimited by // are not closed
+  // return -4 if some comment delimited by /* */ are not closed
+
+  out.clear();
+  out.reserve(length);
+  
+  int nremoved = 0;
+  std::size_t i = 0;
+  while(i < length)
+    {
+      const char c = inS[i];
+      
+      //Check if previous character is a slash
+      bool scapped = !out.empty() && out[out.size()-1] == '\\';
+      
+      if(c == '"' || c == '\'')
 	{
-	  if( found1 == 0 || inS[found1-1] != '\\' )
+	  if(scapped)
+	    {
+	      //Scapped quote, copy it
+	      out.push_back(c);
+	      i++;
+	      continue;
+	    }
+	  
+	  // Find next non slashed quote
+	  std::size_t found = i;
+	  while(1)
 	    {
-	      // Remove until next non slashed "
-	      int err = removeText(inS, found1, limit1, true, false);
-	      if(err < 0)
+	      const char* pfound = (const char*) memchr(inS+found+1, c, length-found-1);
+	      if(pfound == 0)
 		{
-		  printf("removeText:Error: Invalid limit array\n");
-		  return -5;
+		  found = std::string::npos;
+		  break;
 		}
-	      else if(err == 1)
+	      found = pfound-inS;
+	      if(inS[found-1] != '\\')
 		{
-		  printf("clearCode:warning: Non limited string (\"__\")\n");
-		  nremoved++;
-		  return -1;
+		  break;
 		}
-	      nremoved++;	    
-	      pos = found1 == 0 ? 0 : found1-1;	  
 	    }
-	  else
+
+	  nremoved++;
+	  if(found == std::string::npos)
 	    {
-	      //Find on next position
-	      pos = found1+1;
+	      //Remove until end of text
+	      if(c == '"')
+		{
+		  printf("clearCode:warning: Non limited string (\"__\")\n");
+		  return -1;
+		}
+	      printf("clearCode:warning: Non limited char ('__')\n");
+	      return -2;
 	    }
+	  i = found+1;
+	  continue;
+	}
+
+      // Comments. The opening '/' can be the last copied character
+      // if it was followed by a removed string.
+      std::size_t second = std::string::npos; //Position of second comment opening character
+      if((c == '/' || c == '*') && !out.empty() && out[out.size()-1] == '/' &&
+	 (out.size() < 2 || out[out.size()-2] != '\\'))
+	{
+	  //Remove opening '/' from output
+	  out.erase(out.size()-1);
+	  second = i;
+	}
+      else if(c == '/' && i+1 < length && (inS[i+1] == '/' || inS[i+1] == '*') && !scapped)
+	{
+	  second = i+1;
+	}
+      
+      if(second == std::string::npos)
+	{
+	  //Code character. Copy the following run of characters
+	  //that can't open a string nor a comment.
+	  out.push_back(c);
+	  i++;
+	  std::size_t run = scanCode(inS+i, length-i);
+	  out.append(inS+i, run);
+	  i += run;
+	  continue;
 	}
-      else if(found2 < found3 && found2 < found4)
+
+      nremoved++;
+      if(inS[second] == '/')
 	{
-	  if( found2 == 0 || inS[found2-1] != '\\' )
+	  // Remove until next non slashed \n
+	  std::size_t found = second;
+	  while(1)
 	    {
-	      // Remove until next non slashed '
-	      int err = removeText(inS, found2, limit2, true, false);
-	      if(err < 0)
+	      const char* pfound = (const char*) memchr(inS+found+1, '\n', length-found-1);
+	      if(pfound == 0)
 		{
-		  printf("removeText:Error: Invalid limit array\n");
-		  return -5;
+		  found = std::string::npos;
+		  break;
 		}
-	      else if(err == 1)
+	      found = pfound-inS;
+	      if(inS[found-1] != '\\')
 		{
-		  printf("clearCode:warning: Non limited char ('__')\n");
-		  nremoved++;
-		  return -2;
+		  break;
 		}
-	      nremoved++;
-	      pos = found2 == 0 ? 0 : found2-1;	  
 	    }
-	  else
+	  
+	  if(found == std::string::npos)
 	    {
-	      //Find on next position
-	      pos = found2+1;
+	      printf("clearCode:warning: Non limited comment (//__\\n)\n");
+	      return -3;
 	    }
+	  //Keep the new line character
+	  i = found;
 	}
-      else if(found3 < found4)
+      else
 	{
-	  if( found3 == 0 || inS[found3-1] != '\\' )
+	  // Remove until next */ with or without slash
+	  std::size_t found = second;
+	  while(1)
 	    {
-	      // Remove until next non slashed \n
-	      int err = removeText(inS, found3, limit3, false, false);
-	      if(err < 0)
+	      const char* pfound = (const char*) memchr(inS+found, '*', length-found);
+	      if(pfound == 0 || pfound+1 >= inS+length)
 		{
-		  printf("removeText:Error: Invalid limit array\n");
-		  return -5;
+		  found = std::string::npos;
+		  break;
 		}
-	      else if(err == 1)
+	      found = pfound-inS;
+	      if(inS[found+1] == '/')
 		{
-		  printf("clearCode:warning: Non limited comment (//__\\n)\n");
-		  nremoved++;
-		  return -3;
+		  break;
 		}
-	      nremoved++;
-	      pos = found3 == 0 ? 0 : found3-1;	  
-	    }
-	  else
-	    {
-	      //Find on next position
-	      pos = found3+1;
-	    }
-	}
-      else if( found4 == 0 || inS[found4-1] != '\\' )
-	{	  
-	  // Remove until next */ with or without slash
-	  int err = removeText(inS, found4, limit4, true, true);
-	  if(err < 0)
-	    {
-	      printf("removeText:Error: Invalid limit array\n");	      
-	      return -5;
+	      found++;
 	    }
-	  else if(err == 1)
+	  
+	  if(found == std::string::npos)
 	    {
 	      printf("clearCode:warning: Non limited comment (/*__*/n)\n");
-	      nremoved++;
 	      return -4;
 	    }
-	  nremoved++;
-	  pos = found4 == 0 ? 0 : found4-1;	  
-	}
-      else
-	{
-	  //Find on next position
-	  pos = found4+1;	  
+	  i = found+2;
 	}
     }
   return nremoved;
@@ -2099,10 +7988,68 @@ int definedFunc(std::string& inS, std::string*& pnames)
   //
 
   const char* mark = "%00%";
+
+  //Build matching keys table
+  key_map keys;
+  keys.build(inS);
+
+  //Extract function spans
+  function_span* spans = 0;
+  int nspans = 0;
+  int nfunctions = definedFunc(inS, keys, pnames, spans, nspans);
+
+  //Insert all marks at once, at the beginning of each identifier
+  if(nspans > 0)
+    {
+      const std::size_t markLength = strlen(mark);
+      std::string marked;
+      marked.reserve(inS.length() + nspans*markLength);
+      std::size_t prev = 0;
+      for(int i = 0; i < nspans; i++)
+	{
+	  marked.append(inS, prev, spans[i].begin-prev);
+	  marked.append(mark, markLength);
+	  prev = spans[i].begin;
+	}
+      marked.append(inS, prev, std::string::npos);
+      inS.swap(marked);
+    }
+  delete [] spans;
+
+  return nfunctions;
+}
+
+int definedFunc(const std::string& inS, const key_map& keys, std::string*& pnames, function_span*& spans, int& nspans, int* ending)
+{
+  // This function extract all defined function names in
+  // input string in C/C++ format and the span of each
+  // definition.
+  //
+  // The input string must has not any comment or strings
+  // using "" and ''. Use function clearCode to ensure
+  // that. 'keys' must be the key map of 'inS'.
+  //
+  // 'ending', if specified, is set to 1 when the scan
+  // stops because a body is preceded by a '(' without
+  // identifier, to 2 when the last ')' is not followed
+  // by any '{' nor ';', and to 0 otherwise.
+  //
+  // return number of extracted function names
+  //
+
   int maxDim = 30;
-  pnames = new std::string[30];
+  pnames = new std::string[maxDim];
+  //Number of definitions of each name
+  int* nOverloads = new int[maxDim];
+  //Position of each name in 'pnames'
+  std::unordered_map<std::string,int> nameIndex;
+
+  int maxSpans = 30;
+  spans = new function_span[maxSpans];
+  nspans = 0;
   
   int nfunctions = 0;
+  if(ending != 0){*ending = 0;}
   std::size_t pos = 0;
   while(pos != std::string::npos)
     {
@@ -2115,7 +8062,7 @@ int definedFunc(std::string& inS, std::string*& pnames)
 	}
       
       //Find position where '(' closes
-      std::size_t posParClose = closeKey(inS,posPar);
+      std::size_t posParClose = keys.close(posPar);
       if(posParClose == std::string::npos)
 	{
 	  // Previous '(' is not closed
@@ -2124,13 +8071,21 @@ int definedFunc(std::string& inS, std::string*& pnames)
       
       //Find next '{' position
       std::size_t posCor = inS.find('{',posParClose);
+      std::size_t posSColon = inS.find(';',posParClose);
       if(posCor == std::string::npos)
 	{
-	  break;
+	  //There are not more bodies in 'inS'. Without a
+	  //';', a body could follow in the code after 'inS'
+	  if(posSColon == std::string::npos)
+	    {
+	      if(ending != 0){*ending = 2;}
+	      break;
+	    }
+	  pos = posSColon;
+	  continue;
 	}
       
       //Check if there are some ';' between ')' and '{'
-      std::size_t posSColon = inS.find(';',posParClose);
       
       if(posSColon < posCor)
 	{
@@ -2142,51 +8097,96 @@ int definedFunc(std::string& inS, std::string*& pnames)
 	  // Is a function implementation
 	  // Extract function identifier
 	  std::size_t begin;
-	  pos = extractFunction(inS,posPar,pnames[nfunctions],begin);
+	  pos = extractFunction(inS,posPar,pnames[nfunctions],begin,&keys);
+	  if(pos == std::string::npos && ending != 0)
+	    {
+	      //The rest of the code is not scanned
+	      *ending = 1;
+	    }
 	  
 	  if(pos != std::string::npos)
 	    {
-	      std::size_t shift = 0; //Stores the shift produced by marks insertion
 	      //Check if is a statement: 'if', 'while', 'do', 'for', 'else'...
-	      if(!checkStatment(pnames[nfunctions]))
+	      //The identifier must precede the definition body.
+	      if(begin < posCor && !checkStatment(pnames[nfunctions]))
 		{
-		  //Insert marks at the beginning.
-		  inS.insert(begin,mark);
-		  shift = strlen(mark);
-		  
 		  // Add this function name if has not already been added.
-		  if(nameMatch(pnames, nfunctions, pnames[nfunctions].c_str()) < 0)
+		  int iname = -1;
+		  std::unordered_map<std::string,int>::iterator it = nameIndex.find(pnames[nfunctions]);
+		  if(it != nameIndex.end())
 		    {
+		      iname = it->second;
+		    }
+		  else
+		    {
+		      nameIndex[pnames[nfunctions]] = nfunctions;
 		      //Is not in array 
+		      iname = nfunctions;
+		      nOverloads[iname] = 0;
 		      nfunctions++;
 		      
 		      //Check array size
 		      if(nfunctions >= maxDim)
 			{
-			  //Resize array
+			  //Resize arrays
 			  std::string* auxp = pnames;
+			  int* auxpInt = nOverloads;
 			  pnames = 0;
 			  pnames = new std::string[2*maxDim];
+			  nOverloads = new int[2*maxDim];
 			  
 			  for(int i = 0; i < maxDim; i++)
 			    {
 			      pnames[i] = auxp[i];
+			      nOverloads[i] = auxpInt[i];
 			    }
 			  delete [] auxp;
+			  delete [] auxpInt;
 			  maxDim = 2*maxDim;
 			}
 		    }
+
+		  //Store function span
+		  if(nspans >= maxSpans)
+		    {
+		      function_span* auxp = spans;
+		      spans = new function_span[2*maxSpans];
+		      for(int i = 0; i < nspans; i++)
+			{
+			  spans[i] = auxp[i];
+			}
+		      delete [] auxp;
+		      maxSpans = 2*maxSpans;
+		    }
+		  nOverloads[iname]++;
+		  spans[nspans].name = iname;
+		  spans[nspans].overload = nOverloads[iname];
+		  spans[nspans].begin = begin;
+		  spans[nspans].open = posCor;
+		  spans[nspans].close = keys.close(posCor);
+		  nspans++;
 		}
 	      //Find corresponding close key '}' position
-	      pos = closeKey(inS, posCor + shift);
+	      pos = keys.close(posCor);
 	    }
 	}
     }
 
+  delete [] nOverloads;
   return nfunctions;
 }
 
-int usedNamespaces(std::string& inS, std::string*& pnames, const char* fname, int overload)
+/// Find corresponding key using the table \a keys, if specified, or #closeKey otherwise.
+static inline std::size_t findCloseKey(const std::string& inS, std::size_t pos, const key_map* keys)
+{
+  if(keys != 0)
+    {
+      return keys->close(pos);
+    }
+  return closeKey(inS, pos);
+}
+
+int usedNamespaces(const std::string& inS, std::string*& pnames, const char* fname, int overload, const key_map* keys)
 {
   // This function extract names of all namespaces used by
   // function 'fname' in input string in C/C++ format.
@@ -2207,78 +8207,80 @@ int usedNamespaces(std::string& inS, std::string*& pnames, const char* fname, in
 
   if(inS.find(defineMark,0) == std::string::npos){return -2;}
   
-  int maxDim = 30;
-  pnames = new std::string[30];
-
   // Search the specified function overload
   // Extract position of first '{' (beginning of function definition)
-  std::size_t pos = posDefinedFunc(inS, fname, overload);
-  std::size_t endf;
-  if(pos != std::string::npos)
+  std::size_t pos = posDefinedFunc(inS, fname, overload, keys);
+  if(pos == std::string::npos)
     {
-      //Extract end of function (position of close '}')
-      endf = closeKey(inS, pos);
+      // This function/overload doesn't exists
+      return -1;
     }
-  else
+
+  //Extract end of function (position of close '}')
+  std::size_t endf = findCloseKey(inS, pos, keys);
+
+  return bodyNamespaces(inS, pnames, pos, endf);
+}
+
+int usedNamespaces(const parsed_source& src, std::string*& pnames, const char* fname, int overload)
+{
+  // This function extract all namespaces used by
+  // the function 'fname' of parsed source 'src'.
+  //
+  // return -1 if function not found
+  // return number of extracted namespaces on succes
+
+  pnames = 0;
+  int i = src.find(fname, overload);
+  if(i < 0)
     {
-      // This function/overload doesn't exists
-      delete [] pnames;
       return -1;
     }
 
+  return bodyNamespaces(src.text(), pnames, src.span(i).open, src.span(i).close);
+}
+
+int bodyNamespaces(const std::string& inS, std::string*& pnames, std::size_t open, std::size_t close)
+{
+  // This function extract names of all namespaces used
+  // in the function body between 'open' and 'close' positions.
+  //
+  // The input string must has not any comment or strings
+  // using "" and ''. Use function clearCode to ensure
+  // that.
+  //
+  // return number of extracted namespaces
+
+  fcall* fcalls = 0;
+  symbol* pnamespaces = 0;
   int nNamespaces = 0;
-  while(pos < endf)
+  int nCalls = 0;
+  scanBody(inS, open, close, pnamespaces, nNamespaces, fcalls, nCalls);
+  delete [] fcalls;
+
+  //Resolve namespace names
+  pnames = 0;
+  if(nNamespaces > 0)
     {
-      //Find next namespace
-      std::size_t posBegin;
-      pos = extractNamespace(inS,pos,pnames[nNamespaces],posBegin);
-      
-      if(posBegin < endf)
-	{
-	  // This namespace is in actual function definition
-	  // Add this namespace name if has not already been added.
-	  int arrayPos = nameMatch(pnames, nNamespaces, pnames[nNamespaces].c_str());
-	  if(arrayPos < 0)
-	    {
-	      //Is not in the array 
-	      nNamespaces++;
-		  
-	      //Check array size
-	      if(nNamespaces >= maxDim)
-		{
-		  //Resize array
-		  std::string* auxp = pnames;
-		  pnames = 0;
-		  pnames = new std::string[2*maxDim];
-			
-		  for(int i = 0; i < maxDim; i++)
-		    {
-		      pnames[i] = auxp[i];
-		    }
-		  delete [] auxp;
-		  maxDim = 2*maxDim;
-		}
-	    }
-	  pos += 2;  // Skip found namespace possible ::
-	}
-      else
+      pnames = new std::string[nNamespaces];
+      for(int i = 0; i < nNamespaces; i++)
 	{
-	  pos = endf;
+	  pnames[i].assign(pnamespaces[i].str());
 	}
     }
-
-  return nNamespaces;  
+  delete [] pnamespaces;
   
+  return nNamespaces;  
 }
 
-int calledFunc(std::string& inS, fcall*& fcalls, const char* fname, int overload)
+int calledFunc(const std::string& inS, fcall*& fcalls, const char* fname, int overload, const key_map* keys)
 {
   //Wrapper to allow the use of 'calls' struct with
   //'calledFunc' function
 
   std::string* pnames = 0;
   int* counts = 0;
-  int value = calledFunc(inS, pnames, counts, fname, overload);
+  int value = calledFunc(inS, pnames, counts, fname, overload, keys);
 
   //Store values in struct array
   if(value > 0)
@@ -2299,7 +8301,7 @@ int calledFunc(std::string& inS, fcall*& fcalls, const char* fname, int overload
   return value;
 }
 
-int calledFunc(std::string& inS, std::string*& pnames, int*& counts, const char* fname, int overload)
+int calledFunc(const std::string& inS, std::string*& pnames, int*& counts, const char* fname, int overload, const key_map* keys)
 {
   // This function extract names of all functions called by
   // function 'fname' in input string in C/C++ format.
@@ -2319,83 +8321,352 @@ int calledFunc(std::string& inS, std::string*& pnames, int*& counts, const char*
 
   if(inS.find(defineMark,0) == std::string::npos){return -2;}
   
-  int maxDim = 30;
-  pnames = new std::string[maxDim];
-  counts = (int*) malloc(sizeof(int)*maxDim);
-
   // Search the specified function overload
   // Extract position of first '{' (beginning of function definition)
-  std::size_t pos = posDefinedFunc(inS, fname, overload);
-  std::size_t endf;
-  if(pos != std::string::npos)
+  std::size_t pos = posDefinedFunc(inS, fname, overload, keys);
+  if(pos == std::string::npos)
     {
-      //Extract end of function (position of close '}')
-      endf = closeKey(inS, pos);
+      // This function/overload doesn't exists
+      return -1;
     }
-  else
+
+  //Extract end of function (position of close '}')
+  std::size_t endf = findCloseKey(inS, pos, keys);
+
+  return bodyCalls(inS, pnames, counts, pos, endf, keys);
+}
+
+int calledFunc(const parsed_source& src, fcall*& fcalls, const char* fname, int overload)
+{
+  // This function extract names of all functions called by
+  // function 'fname' of parsed source 'src'.
+  //
+  // return -1 if function not found
+  // return number of extracted functions on succes
+
+  fcalls = 0;
+  int i = src.find(fname, overload);
+  if(i < 0)
     {
-      // This function/overload doesn't exists
-      delete [] pnames;
-      free(counts);
       return -1;
     }
-    
+
+  return bodyCalls(src.text(), fcalls, src.span(i).open, src.span(i).close, &src.keyMap());
+}
+
+int bodyCalls(const std::string& inS, fcall*& fcalls, std::size_t open, std::size_t close, const key_map*)
+{
+  // This function extract all functions called
+  // in the function body between 'open' and 'close' positions.
+  //
+  // return number of extracted functions
+
+  symbol* pnamespaces = 0;
+  int nNamespaces = 0;
+  int nCalls = 0;
+  scanBody(inS, open, close, pnamespaces, nNamespaces, fcalls, nCalls);
+  delete [] pnamespaces;
   
-  int nfunctions = 0;
-  while(pos < endf)
+  return nCalls;
+}
+
+int bodyCalls(const std::string& inS, std::string*& pnames, int*& counts, std::size_t open, std::size_t close, const key_map* keys)
+{
+  //Wrapper to allow the use of separated name and
+  //count arrays with 'bodyCalls' function
+  
+  fcall* fcalls = 0;
+  int value = bodyCalls(inS, fcalls, open, close, keys);
+
+  //Store values in separated arrays
+  int dim = value > 0 ? value : 1;
+  pnames = new std::string[dim];
+  counts = (int*) malloc(sizeof(int)*dim);
+  for(int i = 0; i < value; i++)
     {
-      //Find next function
-      std::size_t posBegin;
-      extractFunction(inS,pos,pnames[nfunctions],posBegin);
-      
-      if(posBegin < endf)
+      pnames[i].assign(fcalls[i].name);
+      counts[i] = fcalls[i].calls;
+    }
+  
+  delete [] fcalls;
+  return value;
+}
+
+/// Growing arrays of the names found by scanBody in each thread
+struct body_scratch
+{
+  fcall* calls;
+  symbol* namespaces;
+  int maxCalls;
+  int maxNamespaces;
+
+  body_scratch() : calls(0), namespaces(0), maxCalls(0), maxNamespaces(0) {}
+  ~body_scratch()
+  {
+    delete [] calls;
+    delete [] namespaces;
+  }
+};
+
+//Names found in a body are indexed only if there are more than this
+static const int scanLinearLimit = 16;
+
+int scanBody(const std::string& inS, std::size_t open, std::size_t close, symbol*& pnamespaces, int& nNamespaces, fcall*& fcalls, int& nCalls, arena* pool)
+{
+  // This function extract, in a single traversal, the used
+  // namespaces and the called functions of the function
+  // body between 'open' and 'close' positions. Only the
+  // body is scanned.
+  //
+  // Namespace uses are "identifier::" and "using namespace identifier"
+  // statments. Calls are identifiers followed by '('. Both are
+  // extracted as do 'extractNamespace' and 'extractFunction'.
+  //
+  // return 0 on succes
+
+  //Names are collected in the arrays of this thread, which are
+  //kept between calls, and copied at the end to arrays of the
+  //exact size. Few names are deduplicated with a linear search.
+  static thread_local body_scratch scratch;
+  fcall*& calls = scratch.calls;
+  symbol*& names = scratch.namespaces;
+  int& maxCalls = scratch.maxCalls;
+  int& maxNamespaces = scratch.maxNamespaces;
+  
+  pnamespaces = 0;
+  fcalls = 0;
+  nNamespaces = 0;
+  nCalls = 0;
+
+  const char* nsKey = " namespace ";
+  const std::size_t nsKeyLength = 11;
+  
+  std::size_t length = inS.length();
+  std::size_t end = close < length ? close : length;
+  std::size_t nsNext = open; //First position where a namespace use can be found
+  std::string name;
+  id_index callIndex; //Position in 'calls' of each called name, when there are many
+  id_index nsIndex;   //Position in 'names' of each namespace, when there are many
+  for(std::size_t pos = open; pos < end; pos++)
+    {
+      const char c = inS[pos];
+      bool isNamespace = false;
+      if(c == '(')
 	{
-	  // This function is in actual function definition
-	  // Check if is a statment: if, else if, switch...
-	  if(!checkStatment(pnames[nfunctions]))
+	  //Possible function call, extract identifier before '('
+	  std::size_t idBegin;
+	  std::size_t idLength = identifierBefore(inS, pos, idBegin);
+	  if(idLength == 0)
+	    {
+	      continue;
+	    }
+	  name.assign(inS, idBegin, idLength);
+	  
+	  //Check if is a statment: if, else if, switch...
+	  if(checkStatment(name)){continue;}
+
+	  //Count this call
+	  symbol sname(name);
+	  int i = -1;
+	  if(nCalls <= scanLinearLimit)
 	    {
-	      // Add this function name if has not already been added.
-	      int arrayPos = nameMatch(pnames, nfunctions, pnames[nfunctions].c_str());
-	      if(arrayPos < 0)
+	      for(int j = 0; j < nCalls; j++)
 		{
-		  //Is not in the array 
-		  counts[nfunctions] = 1;
-		  nfunctions++;
-		  
-		  //Check array size
-		  if(nfunctions >= maxDim)
+		  if(calls[j].name == sname){i = j; break;}
+		}
+	      if(i < 0 && nCalls == scanLinearLimit)
+		{
+		  //Too many calls, index them
+		  for(int j = 0; j < nCalls; j++)
 		    {
-		      //Resize array
-		      std::string* auxp = pnames;
-		      int* auxpInt = counts;
-		      pnames = 0;
-		      counts = 0;
-		      pnames = new std::string[2*maxDim];
-		      counts = (int*) malloc(sizeof(int)*2*maxDim);
-			
-		      for(int i = 0; i < maxDim; i++)
-			{
-			  pnames[i] = auxp[i];
-			  counts[i] = auxpInt[i];
-			}
-		      delete [] auxp;
-		      maxDim = 2*maxDim;
+		      callIndex.insert(calls[j].name.id(), j);
 		    }
+		  callIndex.insert(sname.id(), nCalls);
+		}
+	    }
+	  else
+	    {
+	      i = callIndex.insert(sname.id(), nCalls);
+	    }
+	  if(i >= 0)
+	    {
+	      calls[i].calls++;
+	      continue;
+	    }
+
+	  //New called function, check array size
+	  if(nCalls >= maxCalls)
+	    {
+	      maxCalls = maxCalls == 0 ? 10 : 2*maxCalls;
+	      fcall* auxp = calls;
+	      calls = new fcall[maxCalls];
+	      for(int j = 0; j < nCalls; j++)
+		{
+		  calls[j] = auxp[j];
 		}
-	      else
+	      delete [] auxp;
+	    }
+	  calls[nCalls].name = sname;
+	  calls[nCalls].calls = 1;
+	  nCalls++;
+	}
+      else if(pos < nsNext)
+	{
+	  //Inside of the last extracted namespace use
+	  continue;
+	}
+      else if(c == ':' && pos+1 < length && inS[pos+1] == ':')
+	{
+	  //Found a "::", extract previous identifier
+	  std::size_t cont = identifierRun(inS.data(), pos);
+
+	  if(cont == 0)
+	    {
+	      //Global scope, search from next ':'
+	      nsNext = pos+1;
+	      continue;
+	    }
+	  name.assign(inS, pos-cont, cont);
+	  nsNext = pos+2; //Skip "::"
+	  isNamespace = true;
+	}
+      else if(c == ' ' && inS.compare(pos, nsKeyLength, nsKey) == 0)
+	{
+	  //Found a "using namespace", extract the next word
+	  std::size_t first = pos+nsKeyLength-1;
+	  while(first < length && (charClass(inS[first]) & CHAR_SPACE)){first++;}
+	  std::size_t last = first;
+	  while(last < length && !(charClass(inS[last]) & CHAR_SPACE)){last++;}
+	  if(first == last)
+	    {
+	      //No namespace name
+	      nsNext = length;
+	      continue;
+	    }
+	  name.assign(inS, first, last-first);
+
+	  //Remove end ';'
+	  std::size_t posSC = name.find(';');
+	  if(posSC != std::string::npos)
+	    {
+	      name.erase(posSC,1);
+	    }
+	  nsNext = last+2;
+	  isNamespace = true;
+	}
+
+      if(!isNamespace){continue;}
+
+      symbol sname(name);
+      bool found = false;
+      if(nNamespaces <= scanLinearLimit)
+	{
+	  for(int j = 0; j < nNamespaces && !found; j++)
+	    {
+	      found = names[j] == sname;
+	    }
+	  if(!found && nNamespaces == scanLinearLimit)
+	    {
+	      //Too many namespaces, index them
+	      for(int j = 0; j < nNamespaces; j++)
 		{
-		  counts[arrayPos]++;
+		  nsIndex.insert(names[j].id(), j);
 		}
+	      nsIndex.insert(sname.id(), nNamespaces);
 	    }
-	  pos = inS.find('(',posBegin)+1;  // Skip found function open parenthesis '('
 	}
       else
 	{
-	  pos = endf;
+	  found = nsIndex.insert(sname.id(), nNamespaces) >= 0;
+	}
+      if(!found)
+	{
+	  //New namespace, check array size
+	  if(nNamespaces >= maxNamespaces)
+	    {
+	      maxNamespaces = maxNamespaces == 0 ? 10 : 2*maxNamespaces;
+	      symbol* auxp = names;
+	      names = new symbol[maxNamespaces];
+	      for(int j = 0; j < nNamespaces; j++)
+		{
+		  names[j] = auxp[j];
+		}
+	      delete [] auxp;
+	    }
+	  names[nNamespaces] = sname;
+	  nNamespaces++;
+	}
+    }
+
+  //Copy the results
+  if(nCalls > 0)
+    {
+      fcalls = pool != 0 ? pool->allocArray<fcall>(nCalls) : new fcall[nCalls];
+      for(int j = 0; j < nCalls; j++)
+	{
+	  fcalls[j] = calls[j];
+	}
+    }
+  if(nNamespaces > 0)
+    {
+      pnamespaces = pool != 0 ? pool->allocArray<symbol>(nNamespaces) : new symbol[nNamespaces];
+      for(int j = 0; j < nNamespaces; j++)
+	{
+	  pnamespaces[j] = names[j];
 	}
     }
+  
+  return 0;
+}
 
-  return nfunctions;
+std::size_t identifierBefore(const std::string& inS, std::size_t posPar, std::size_t& begin)
+{
+  // This function search the identifier that precedes
+  // the '(' in position 'posPar'. Blanks between the
+  // identifier and '(' are skiped and one "::" is
+  // allowed in the identifier.
+  //
+  // return the number of identifier characters
+  // variable 'begin' will store first position of identifier
+  
+  const char* p = inS.data();
+  std::size_t idEnd = posPar; //Position after the last identifier character
+
+  //Skip blanks between the identifier and '('
+  while(idEnd > 0 && (charClass(p[idEnd-1]) & (CHAR_BLANK | CHAR_NEWLINE))){idEnd--;}
+
+  std::size_t cont = identifierRun(p, idEnd);
+  if(cont > 0)
+    {
+      //Check for a namespace specification
+      std::size_t first = idEnd-cont;
+      if(first >= 2 && p[first-1] == ':' && p[first-2] == ':')
+	{
+	  cont += 2 + identifierRun(p, first-2);
+	}
+    }
+
+  begin = idEnd - cont;
+  return cont;
+}
+
+int nameMatch(const symbol* sarray, int dim, const symbol& name)
+{
+  // This function check if 'name' exists in the symbol array
+  // 'sarray' of dimension 'dim' and return its position.
+  //
+  // if the name is not found, the return value will be -1.
+  //
+
+  const unsigned int id = name.id();
+  for(int i = 0; i < dim; i++)
+    {
+      if(sarray[i].id() == id)
+	{
+	  return i;
+	}
+    }
+  return -1;
 }
 
 int nameMatch(std::string* sarray, int dim, const char* name)
@@ -2416,7 +8687,7 @@ int nameMatch(std::string* sarray, int dim, const char* name)
   return -1;
 }
 
-std::size_t extractNamespace(std::string& inS, std::size_t init, std::string& name, std::size_t& begin)
+std::size_t extractNamespace(const std::string& inS, std::size_t init, std::string& name, std::size_t& begin)
 {
   // This function return the name of next used namespace in 'inS' string.
   // 'init' mark the first position to search.
@@ -2456,20 +8727,8 @@ std::size_t extractNamespace(std::string& inS, std::size_t init, std::string& na
     {
       //Found first a "::"
       // Search identifier init
-      int cont = 0;  // Count number of positions between identificator init and '('
+      std::size_t cont = identifierRun(inS.data(), pos2D);
       std::size_t idEnd = pos2D-1; //Store end position of namespace identifier
-      while(1)
-	{
-	  if(inRange(inS[idEnd-cont]) > 0)
-	    {
-	      cont++;
-	    }
-	  else
-	    {
-	      //End of namespace identifier
-	      break;
-	    }
-	}
 
       if(cont > 0)
 	{
@@ -2488,11 +8747,11 @@ std::size_t extractNamespace(std::string& inS, std::size_t init, std::string& na
     }
 }
 
-std::size_t extractFunction(std::string& inS, std::size_t init, std::string& name, std::size_t& begin)
+std::size_t extractFunction(const std::string& inS, std::size_t init, std::string& name, std::size_t& begin, const key_map* keys, std::size_t end)
 {
   // This function return the name of next function in 'inS' string.
   // 'init' mark the first position to search. The function will extract
-  // function name corresponding to next '(' found.
+  // function name corresponding to next '(' found before 'end'.
   //
   // returns the end function position (position of ')').
   // variable 'begin' will be filled by the first position of identifier name
@@ -2503,66 +8762,38 @@ std::size_t extractFunction(std::string& inS, std::size_t init, std::string& nam
 
   std::size_t posPar = inS.find('(',pos);
 
-  if(posPar == std::string::npos) //No function found
+  if(posPar == std::string::npos || posPar >= end) //No function found
     {
       begin = std::string::npos;
-      return posPar;
+      return std::string::npos;
     }
   
-  std::size_t closePos = closeKey(inS,pos);
-
-  // Search identifier init
-  int cont = 0;  // Count number of positions between identificator init and '('
-  bool namespaceFound = false; //Control if namespace has been specified
-  bool blankSkiped = false; //Control if whitespaces has been skiped
-  std::size_t idEnd = posPar-1; //Store end position of function identifier
-  while(1)
+  std::size_t closePos = findCloseKey(inS,pos,keys);
+  if(closePos >= end)
     {
-      if(inRange(inS[idEnd-cont]) > 0)
-	{
-	  blankSkiped = true;
-	  cont++;
-	}
-      else if(!blankSkiped && (isblank(inS[idEnd-cont]) || inS[idEnd-cont] == '\n'))
-	{
-	  idEnd--; //Skip blank character
-	}
-      else if(blankSkiped && !namespaceFound && (int)idEnd-cont-1 >= 0)
-	{
-	  if(inS[idEnd-cont] == ':' && inS[idEnd-cont-1] == ':')
-	    {
-	      namespaceFound = true;
-	      cont += 2;
-	    }
-	  else
-	    {
-	      //End of function identifier
-	      break;
-	    }
-	}
-      else
-	{
-	  //End of function identifier
-	  break;
-	}
+      //Closed after the end of the text
+      closePos = std::string::npos;
     }
 
+  // Search identifier init
+  std::size_t idBegin;
+  std::size_t cont = identifierBefore(inS,posPar,idBegin);
+
   if(cont > 0)
     {
-      std::size_t idBegin = idEnd - (cont-1);
       begin = idBegin;
-      name.assign(inS,idBegin,idEnd-idBegin+1);
+      name.assign(inS,idBegin,cont);
   
       return closePos;
     }
   else
     {
       // Call function itself to find next possible function
-      return extractFunction(inS,posPar+1,name,begin);
+      return extractFunction(inS,posPar+1,name,begin,keys,end);
     }  
 }
 
-std::size_t posDefinedFunc(std::string& inS, const char* name, int overload)
+std::size_t posDefinedFunc(const std::string& inS, const char* name, int overload, const key_map* keys)
 {
   // Return the position of the begining of function definition (on character '{')
   // The function name must be marked by 'definedFunc'.
@@ -2605,14 +8836,14 @@ std::size_t posDefinedFunc(std::string& inS, const char* name, int overload)
 		      return posCor;
 		    }
 		}
-	      pos = closeKey(inS, posCor);
+	      pos = findCloseKey(inS, posCor, keys);
 	    }
 	}
     }
   return std::string::npos;
 }
 
-bool checkStatment(std::string& string)
+bool checkStatment(const std::string& string)
 {
   // This function check if input string is
   // an statment or not
@@ -2643,7 +8874,7 @@ bool checkStatment(std::string& string)
   return false;
 }
 
-std::size_t closeKey(std::string& inS, std::size_t init)
+std::size_t closeKey(const std::string& inS, std::size_t init)
 {
   // This function returns the position where the key in
   // position 'init' closes with the corresponding close key.
@@ -2662,81 +8893,51 @@ std::size_t closeKey(std::string& inS, std::size_t init)
   const char openKeys[] = {'(','[','{'};
   const char closeKeys[] = {')',']','}'};
 
-  bool isOpenKey;
-  int id = -1;
-
+  if(init >= inS.length()){return std::string::npos;}
+  
   for(int i = 0; i < nKeys; i++)
     {
       if(inS[init] == openKeys[i])
 	{
-	  id = i;
-	  isOpenKey = true;
-	  break;
-	}
-      if(inS[init] == closeKeys[i])
-	{
-	  id = i;
-	  isOpenKey = false;
-	  break;
-	}      
-    }
-
-  if(id < 0){return std::string::npos;}
-
-  if(isOpenKey)
-    {
-      //Is a open key, find the corresponding close key
-      std::size_t nextClose = 1;
-      std::size_t nextOpen = 0;
-
-      std::size_t pos = init;
-      
-      while(nextClose > nextOpen)
-	{
-	  nextClose = inS.find(closeKeys[id],pos+1);
-	  nextOpen  = inS.find(openKeys[id],pos+1);
-
-	  if(nextClose == std::string::npos)
+	  //Is a open key, find the corresponding close key.
+	  //Count nested enclosures of the same key type.
+	  std::size_t depth = 0;
+	  for(std::size_t pos = init+1; pos < inS.length(); pos++)
 	    {
-	      return std::string::npos; //Corresponding close key not found
-	    }
-	  
-	  if(nextOpen < nextClose)
-	    {
-	      // Another open key found before close key. Skyp this enclosure
-	      pos = closeKey(inS, nextOpen);
-	      if(pos == std::string::npos){ return std::string::npos;} //Corresponding close key not found
+	      if(inS[pos] == openKeys[i])
+		{
+		  depth++;
+		}
+	      else if(inS[pos] == closeKeys[i])
+		{
+		  if(depth == 0){return pos;}
+		  depth--;
+		}
 	    }
+	  return std::string::npos; //Corresponding close key not found
 	}
-      return nextClose;
-    }
-  else
-    {
-      //Is a close key, find the corresponding open key
-      std::size_t prevClose = 1;
-      std::size_t prevOpen = 0;
-
-      std::size_t pos = init;
-      
-      while(prevClose > prevOpen)
+      if(inS[init] == closeKeys[i])
 	{
-	  prevClose = inS.rfind(closeKeys[id],pos-1);
-	  prevOpen  = inS.rfind(openKeys[id],pos-1);
-
-	  if(prevOpen == std::string::npos)
-	    {
-	      return std::string::npos; //Corresponding open key not found
-	    }
-	  
-	  if(prevOpen < prevClose)
+	  //Is a close key, find the corresponding open key
+	  std::size_t depth = 0;
+	  for(std::size_t pos = init; pos > 0; pos--)
 	    {
-	      // Another close key found before open key. Skyp this enclosure
-	      pos = closeKey(inS, prevClose);
-	      if(pos == std::string::npos){ return std::string::npos;} //Corresponding open key not found
+	      if(inS[pos-1] == closeKeys[i])
+		{
+		  depth++;
+		}
+	      else if(inS[pos-1] == openKeys[i])
+		{
+		  if(depth == 0){return pos-1;}
+		  depth--;
+		}
 	    }
+	  return std::string::npos; //Corresponding open key not found
 	}
-      return prevOpen;
     }
+
+  //Is not a key
+  return std::string::npos;
 }
 
 int inRange(char c)
@@ -2750,22 +8951,7 @@ int inRange(char c)
   // return 4 if is '_'
   // return 0 if is out of all ranges
   
-  const int nIntervals = 4;
-  const int charLimits[] = {
-    48,57,   //Numbers
-    65,90,   //Upcase
-    97,122,  //Downcase
-    95,95    // '_'
-  };
-
-  for(int i = 0; i < nIntervals; i++)
-    {
-      if(c >= charLimits[2*i] && c <= charLimits[2*i+1])
-	{
-	  return i+1;
-	}
-    }
-  return 0;
+  return charClassTable[(unsigned char) c] & CHAR_RANGE;
 }
 
 bool stringOrder(const std::string& a, const std::string& b)
@@ -2831,3 +9017,41 @@ int tree2dot(leaf* tree, int nleafs, const char* filename, unsigned int nprop, c
 
   return 0;
 }
+
+int graph2dot(const dep_graph& g, const char* filename, unsigned int nprop, const char** prop)
+{
+  
+  FILE* fgraph = 0;
+  
+  fgraph = fopen(filename,"w");
+  if(fgraph == 0)
+    return -1;
+  
+  fprintf(fgraph, "digraph G {\n");
+
+  if(nprop > 0 && prop != 0)
+    {
+      for(unsigned int i = 0; i < nprop; i++)
+	{
+	  fprintf(fgraph, "%s;\n",prop[i]);	  
+	}
+    }
+  
+  for(int i = 0; i < g.numNodes(); i++)
+    {
+      int nlinks = g.getNumLinks(i);
+      for(int j = 0; j < nlinks; j++)
+	{
+	  fprintf(fgraph,"     %s -> %s;\n",g.getName(i).c_str(),g.getName(g.getLink(i,j)).c_str());
+	}
+      if(nlinks == 0)
+	{
+	  fprintf(fgraph,"     %s;\n",g.getName(i).c_str());
+	}
+    }      
+  
+  fprintf(fgraph, "}\n");
+  fclose(fgraph);
+
+  return 0;
+}
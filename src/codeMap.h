@@ -27,8 +27,420 @@
 #include <cmath>
 #include <algorithm>
 #include <new>
+#include <cstddef>
+#include <type_traits>
 #include <stdlib.h>
 #include <cstdlib>
+#include <cstdio>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <functional>
+
+/**
+ * \class symbol
+ * \ingroup code-parser
+ *
+ * Interned name. Each different text is stored once in a
+ * global symbol table and identified by a 32 bit id, so
+ * names are copied and compared for equality as integers.
+ * The text is only resolved to print or sort names. Symbols
+ * can be created concurrently by many threads. The id 0 is
+ * the empty name.
+ *
+ * The table only grows: texts are not released when the maps
+ * that use them are cleared or destroyed, so a process that
+ * maps many different trees keeps all their names. Once all
+ * maps are destroyed, #reset releases the table.
+ */
+
+class symbol
+{
+ protected:
+  /// Position of the text in the symbol table.
+  unsigned int sid;
+
+  /** \brief Intern a text
+   *  \param text -> Text to intern.
+   *  \param length -> Number of characters in \a text.
+   *  \param create -> If is false, not interned texts are not added.
+   *
+   *  \return Return the id of \a text.
+   *  \return Return UINT_MAX if \a text is not interned and \a create is false.
+   */
+  static unsigned int intern(const char* text, std::size_t length, bool create = true);
+  
+ public:
+  /// Create an empty symbol.
+  inline symbol() : sid(0) {}
+  /// Create the symbol of \a text.
+  inline symbol(const char* text) : sid(intern(text, strlen(text))) {}
+  /// Create the symbol of \a text.
+  inline symbol(const std::string& text) : sid(intern(text.c_str(), text.length())) {}
+  /// Create the symbol of the first \a length characters of \a text.
+  inline symbol(const char* text, std::size_t length) : sid(intern(text, length)) {}
+
+  /// Assign the symbol of \a text.
+  inline symbol& assign(const char* text){sid = intern(text, strlen(text)); return *this;}
+  /// Assign the symbol of \a text.
+  inline symbol& assign(const std::string& text){sid = intern(text.c_str(), text.length()); return *this;}
+  /// Assign the symbol of \a n characters of \a text starting at \a pos.
+  inline symbol& assign(const std::string& text, std::size_t pos, std::size_t n){
+    if(pos > text.length()){pos = text.length();}
+    if(n > text.length()-pos){n = text.length()-pos;}
+    sid = intern(text.c_str()+pos, n);
+    return *this;
+  }
+  /// Assign the symbol \a c.
+  inline symbol& assign(const symbol& c){sid = c.sid; return *this;}
+  
+  /** \brief Find the symbol of a text without interning it.
+   *  \param text -> Text to find.
+   *  \param out -> Symbol of \a text if it exists.
+   *  \return Return true if \a text has been interned.
+   *
+   *  Used by queries, which should not grow the table.
+   */
+  static bool find(const char* text, symbol& out);
+
+  /** \brief Release the symbol table
+   *  \return Return 0 on success.
+   *  \return Return -1 if some #source_map is alive. The table is not modified.
+   *
+   *  Release all interned texts and start an empty table. Ids
+   *  obtained before are not valid after the reset, so any other
+   *  object that stores symbols (caches, graphs, function and
+   *  namespace maps) must be destroyed before. No other thread
+   *  can use symbols during the call.
+   */
+  static int reset();
+
+  /// Return the number of interned symbols
+  static unsigned int count();
+  /// Return the memory used by the symbol table in bytes
+  static std::size_t bytes();
+  
+  /// Return the text of the symbol
+  const std::string& str() const;
+  /// Return the text of the symbol as C string
+  inline const char* c_str() const {return str().c_str();}
+  /// Return the text length
+  inline std::size_t length() const {return str().length();}
+  /// Return true if the symbol is the empty name
+  inline bool empty() const {return sid == 0;}
+  /// Return the symbol id
+  inline unsigned int id() const {return sid;}
+  /// Return the symbol of the id \a id, obtained with #id.
+  static inline symbol fromId(unsigned int id){symbol s; s.sid = id; return s;}
+  /// Set the empty name
+  inline void clear(){sid = 0;}
+  /// Exchange the symbols of this object and \a c
+  inline void swap(symbol& c) noexcept {unsigned int aux = sid; sid = c.sid; c.sid = aux;}
+
+  /// Compare alphabetically with \a c. Same symbols are detected by id.
+  inline int compare(const symbol& c) const {return sid == c.sid ? 0 : str().compare(c.str());}
+  /// Compare alphabetically with \a text.
+  inline int compare(const char* text) const {return str().compare(text);}
+  /// Compare alphabetically with \a text.
+  inline int compare(const std::string& text) const {return str().compare(text);}
+
+  /// Convert to the text of the symbol
+  inline operator const std::string&() const {return str();}
+
+  /// Overload of comparision operator == (same id)
+  inline bool operator==(const symbol& c) const {return sid == c.sid;}
+  /// Overload of comparision operator != (different id)
+  inline bool operator!=(const symbol& c) const {return sid != c.sid;}
+  /// Overload of comparision operator < (alphabetical order)
+  inline bool operator<(const symbol& c) const {return compare(c) < 0;}
+  /// Overload of comparision operator > (alphabetical order)
+  inline bool operator>(const symbol& c) const {return compare(c) > 0;}
+};
+
+/**
+ * \class id_index
+ * \ingroup code-parser
+ *
+ * Hash table from #symbol ids to array positions. Used to
+ * find names in symbol arrays without scanning them. Keys
+ * are stored with open addressing and linear probing.
+ *
+ */
+
+class id_index
+{
+ protected:
+  /// Stored ids plus one (0 marks an empty slot).
+  unsigned int* keys;
+  /// Value of each slot.
+  int* values;
+  /// Number of slots minus one (0 if there are not slots).
+  unsigned int mask;
+  /// Number of stored keys.
+  unsigned int used;
+
+  /// Resize the table to \a nslots slots, a power of two.
+  void rehash(unsigned int nslots);
+  
+ public:
+  /// Constructor
+  id_index();
+  /// Constructor that copy argument #id_index
+  id_index(const id_index&);
+
+  /** \brief Find an id
+   *  \param id -> Symbol id to find.
+   *  \return Return the value stored with \a id or -1 if is not stored.
+   */
+  inline int find(unsigned int id) const {
+    if(used == 0){return -1;}
+    unsigned int slot = (id * 0x9E3779B1u) & mask;
+    while(keys[slot] != 0)
+      {
+	if(keys[slot] == id+1){return values[slot];}
+	slot = (slot+1) & mask;
+      }
+    return -1;
+  }
+
+  /** \brief Insert an id
+   *  \param id -> Symbol id to insert.
+   *  \param value -> Value to store with \a id.
+   *  \return Return -1 if \a id has been inserted.
+   *  \return Return the stored value if \a id already exists. The value is not modified.
+   */
+  int insert(unsigned int id, int value);
+
+  /** \brief Erase an id
+   *  \param id -> Symbol id to erase.
+   *  \return Return the value stored with \a id or -1 if is not stored.
+   *
+   *  The following keys of the same cluster are moved back, so
+   *  no deleted marks are left in the table.
+   */
+  int erase(unsigned int id);
+
+  /// Reserve space for \a n keys
+  void reserve(unsigned int n);
+  /// Return the number of stored keys
+  inline unsigned int size() const {return used;}
+  /// Remove all keys, keeping the allocated slots
+  void clear();
+
+  /// Overload of assign operator (=)
+  id_index& operator=(const id_index&);
+  
+  /// Destructor
+  ~id_index();
+};
+
+/**
+ * \struct id_container
+ * \ingroup code-parser
+ *
+ * Ids of an #id_bitmap that share the 16 high bits. The
+ * low bits are stored as a sorted array while there are
+ * few of them and as a 65536 bit set otherwise.
+ *
+ */
+
+struct id_container
+{
+public:
+  /// High 16 bits of the stored ids
+  unsigned short key;
+  /// Number of stored ids
+  unsigned int card;
+  /// Allocated elements in #values
+  unsigned int maxValues;
+  /// Sorted low bits of the ids, or null pointer if #bits is used
+  unsigned short* values;
+  /// Bit set of the low bits (1024 words), or null pointer if #values is used
+  unsigned long long* bits;
+};
+
+/**
+ * \class id_bitmap
+ * \ingroup code-parser
+ *
+ * Compressed set of #symbol ids (roaring bitmap). Ids are
+ * split in #id_container elements by its 16 high bits, so
+ * sets are intersected, joined and subtracted container by
+ * container with the cost of the smallest representation.
+ *
+ */
+
+class id_bitmap
+{
+ protected:
+  /// Containers sorted by key.
+  id_container* containers;
+  /// Current number of elements in #containers.
+  int nContainers;
+  /// Maximum number of elements in #containers.
+  int maxContainers;
+  /// Number of stored ids.
+  unsigned int total;
+
+  /** \brief Find a container
+   *  \param key -> High 16 bits of the ids.
+   *  \return Return the position of the container with key \a key.
+   *  \return Return -(p+1) if it doesn't exist, where p is the position where it should be inserted.
+   */
+  int findContainer(unsigned short key) const;
+  /// Insert an empty container with key \a key at position \a pos.
+  void insertContainer(int pos, unsigned short key);
+  /// Remove the empty containers and update #total.
+  void compact();
+  
+ public:
+  /// Constructor
+  id_bitmap();
+  /// Constructor that copy argument #id_bitmap
+  id_bitmap(const id_bitmap&);
+
+  /** \brief Add an id
+   *  \param id -> Id to add.
+   *  \return Return 0 if \a id has been added.
+   *  \return Return 1 if \a id already exists.
+   */
+  int add(unsigned int id);
+
+  /** \brief Remove an id
+   *  \param id -> Id to remove.
+   *  \return Return 0 if \a id has been removed.
+   *  \return Return 1 if \a id doesn't exist.
+   */
+  int remove(unsigned int id);
+
+  /// Return true if \a id is stored
+  bool contains(unsigned int id) const;
+
+  /// Keep only the ids stored also in \a c (AND)
+  void andWith(const id_bitmap& c);
+  /// Add the ids stored in \a c (OR)
+  void orWith(const id_bitmap& c);
+  /// Remove the ids stored in \a c (AND-NOT)
+  void andNotWith(const id_bitmap& c);
+
+  /** \brief Extract the stored ids
+   *  \param out -> Array where ids will be stored in ascending order. Must fit #size elements.
+   *  \return Return the number of stored ids.
+   */
+  unsigned int toArray(unsigned int* out) const;
+
+  /** \brief Find an id that is not stored
+   *  \param n -> Number of not stored ids before the one to find.
+   *  \return Return the \a n th smallest id, starting at 0, that is not stored.
+   *
+   *  Containers are skipped by their cardinality, so the cost only
+   *  depends on the number of containers and the size of one of them.
+   */
+  unsigned int nthMissing(unsigned int n) const;
+
+  /// Return the number of stored ids
+  inline unsigned int size() const {return total;}
+  /// Return true if there are not ids
+  inline bool empty() const {return total == 0;}
+  /// Return the allocated memory in bytes
+  std::size_t bytes() const;
+  /// Remove all ids
+  void clear();
+  /// Exchange the ids of this set and \a c
+  void swap(id_bitmap& c) noexcept;
+
+  /// Overload of assign operator (=)
+  id_bitmap& operator=(const id_bitmap&);
+
+  /// Destructor
+  ~id_bitmap();
+};
+
+/// Header of each memory block of an #arena
+struct arena_chunk;
+
+/**
+ * \class arena
+ * \ingroup code-parser
+ *
+ * Monotonic memory pool. Memory is taken from large chunks
+ * and is not released until the arena is released, so each
+ * allocation is a pointer increment. Used to store the arrays
+ * of the functions and namespaces of a map, which are freed
+ * together when the map is cleared, or copied to a new arena
+ * when most of the memory is not used. Arenas are not thread
+ * safe, each thread must use its own arena.
+ *
+ */
+
+class arena
+{
+ protected:
+  /// Last allocated chunk, linked to the previous ones.
+  arena_chunk* last;
+  /// First free byte of #last.
+  char* next;
+  /// End of #last.
+  char* end;
+  /// Total size of the chunks in bytes.
+  std::size_t reserved;
+  /// Number of chunks.
+  unsigned int nChunks;
+
+  /// Copy is not allowed
+  arena(const arena&);
+  /// Assign is not allowed
+  arena& operator=(const arena&);
+
+ public:
+  /// Constructor
+  arena();
+
+  /** \brief Allocate memory
+   *  \param bytes -> Number of bytes.
+   *  \return Return a pointer to \a bytes bytes aligned for any type.
+   */
+  void* allocate(std::size_t bytes);
+
+  /** \brief Allocate an array
+   *  \param n -> Number of elements.
+   *  \return Return a pointer to \a n default constructed elements.
+   *
+   *  Elements are never destroyed, so only types with trivial
+   *  destructor can be allocated.
+   */
+  template<class T> T* allocArray(std::size_t n){
+    static_assert(std::is_trivially_destructible<T>::value, "arena elements are not destroyed");
+    T* p = static_cast<T*>(allocate(n*sizeof(T)));
+    for(std::size_t i = 0; i < n; i++){new(p+i) T();}
+    return p;
+  }
+
+  /** \brief Take the memory of other arena
+   *  \param c -> Arena whose chunks will be owned by this arena.
+   *
+   *  Memory allocated from \a c remains valid until this arena is
+   *  released. \a c is left empty.
+   */
+  void adopt(arena& c);
+
+  /// Free all chunks
+  void release();
+  /// Return the total size of the chunks in bytes
+  inline std::size_t bytes() const {return reserved;}
+  /// Return the number of chunks
+  inline unsigned int numChunks() const {return nChunks;}
+
+  /// Destructor
+  ~arena();
+};
 
 /**
  * \class leaf
@@ -64,6 +476,8 @@ public:
 
   /// Create a leaf.
   leaf();             
+  /// Move constructor, takes the links of \a c and leaves it empty
+  leaf(leaf&&) noexcept;
 
   /** \brief Connect function
    *  \param pleaf -> Pointer to leaf that will be connected.
@@ -81,6 +495,11 @@ public:
   /// Remove all connections and set default values to overload an name
   void clear();
 
+  /// Exchange the contents of this leaf and \a c
+  void swap(leaf& c) noexcept;
+  /// Move assign operator, \a c is left empty
+  leaf& operator=(leaf&&) noexcept;
+
   /// Return the number of links for current leaf
   inline int getNumLinks() const{return nLinks;}  
 
@@ -120,6 +539,88 @@ public:
   ~leaf();
 };
 
+/**
+ * \class dep_graph
+ * \ingroup code-parser
+ *
+ * Dependence graph of the functions of a #source_map stored
+ * in compressed sparse row format. Node \e i is the function
+ * \e i of the map and its links, the called functions, are
+ * stored in #targets from #offsets [i] to #offsets [i+1].
+ * Unlike #leaf trees, all links are stored in one array.
+ *
+ */
+
+class dep_graph
+{
+  friend class source_map;
+protected:
+  /// Number of nodes.
+  int nNodes;
+  /// Number of links.
+  int nEdges;
+  /// Position in #targets of the first link of each node (#nNodes + 1 elements).
+  int* offsets;
+  /// Linked node of each link.
+  int* targets;
+  /// Number of calls of each link.
+  int* weights;
+  /// Function name of each node.
+  symbol* names;
+  /// Function overload of each node.
+  int* overloads;
+
+public:
+  /// Constructor
+  dep_graph();
+  /// Constructor that copy argument #dep_graph
+  dep_graph(const dep_graph&);
+
+  /// Return the number of nodes
+  inline int numNodes() const {return nNodes;}
+  /// Return the number of links
+  inline int numEdges() const {return nEdges;}
+  /// Return the number of links of node \a node
+  inline int getNumLinks(int node) const {return offsets[node+1]-offsets[node];}
+
+  /** \brief Get specified link
+   *  \param node -> Node of the link.
+   *  \param i -> Position of the link in the links of \a node.
+   *  \return Return the linked node.
+   *  \return Return -1 if \a i is out of range.
+   */
+  inline int getLink(int node, int i) const {
+    if(i < 0 || i >= getNumLinks(node))
+      return -1;
+    return targets[offsets[node]+i];
+  }
+
+  /// Return the number of calls of link \a i of node \a node (see #getLink)
+  inline int getWeight(int node, int i) const {return weights[offsets[node]+i];}
+  /// Return the function name of node \a node
+  inline const symbol& getName(int node) const {return names[node];}
+  /// Return the function overload of node \a node
+  inline int getOverload(int node) const {return overloads[node];}
+
+  /** \brief Check link existence
+   *  \param node -> Node of the link.
+   *  \param target -> Linked node to check.
+   *  \return Return true if \a node is linked to \a target.
+   */
+  bool checkLink(int node, int target) const;
+
+  /// Return the allocated memory in bytes
+  std::size_t bytes() const;
+  /// Remove all nodes and links
+  void clear();
+  
+  /// Overload of assign operator (=)
+  dep_graph& operator=(const dep_graph&);
+  
+  /// Destructor
+  ~dep_graph();
+};
+
 /**
  * \struct fcall
  * \ingroup code-parser
@@ -134,7 +635,7 @@ struct fcall
 {
 public:
   /// Function name
-  std::string name;
+  symbol name;
   /// Calls to function specified by #name.
   int calls;        
 
@@ -142,14 +643,44 @@ public:
   fcall();
   /// Constructor that copy argument #fcall
   fcall(const fcall&);
+  /// Move constructor
+  fcall(fcall&&) noexcept;
   /// Overload of assign operator (=)
   fcall& operator=(const fcall&);
+  /// Move assign operator
+  fcall& operator=(fcall&&) noexcept;
+  /// Exchange the contents of this call and \a c
+  void swap(fcall& c) noexcept;
   /// Overload of operator < (used for sorting)
   bool operator<(const fcall&) const;
   /// Overload of operator > (used for sorting)
   bool operator>(const fcall&) const;  
 };
 
+/**
+ * \struct function_span
+ * \ingroup code-parser
+ *
+ * Simple struct that stores where a defined function
+ * is located in a cleared source code string.
+ *
+ */
+
+struct function_span
+{
+public:
+  /// Position of function name in names array returned by #definedFunc
+  int name;
+  /// Overload of this function name (starting at 1)
+  int overload;
+  /// Position of the first character of function identifier
+  std::size_t begin;
+  /// Position of the open key '{' of function body
+  std::size_t open;
+  /// Position of the close key '}' of function body
+  std::size_t close;
+};
+
 /**
  * \class namespace_map
  * \ingroup code-parser
@@ -170,7 +701,15 @@ protected:
   /**  Resizable array of strings that stores the function
    *   names that uses namespace specified by #name.
    */
-  std::string* functionsNames;  
+  symbol* functionsNames;  
+  /// Ids of the names in #functionsNames.
+  id_bitmap fnameSet;
+  /// Additional references of the names appended more than once.
+  std::unordered_map<unsigned int,int> fnameRefs;
+  /// Ids of the removed names that are still in #functionsNames.
+  id_bitmap staleNames;
+  /// Arena of #functionsNames, or null pointer if it is allocated with new.
+  arena* pool;
 
   /** \brief Resize array #functionsNames
    *  \param dim -> new dimension.
@@ -180,26 +719,72 @@ protected:
    *  first \a dim elements will be saved.
    */  
   void resizeFNames(int);
+
+  /// Remove from #functionsNames the names in #staleNames, keeping the order of the others.
+  void dropRemoved();
   
 public:
   /// Store namespace name
-  std::string name;
+  symbol name;
 
   /// Constructor
   namespace_map();
   /// Constructor that copy argument #namespace_map
   namespace_map(const namespace_map&);
+  /// Move constructor, takes the arrays of \a c and leaves it empty
+  namespace_map(namespace_map&&) noexcept;
   
   /** \brief Append a function name to #functionsNames array.
    *  \param fname -> Name to append.
    *  \return Return 0 on success.
    *  \return Return 1 if \a fname already exists in #functionsNames.
    *
+   *  Existing names are not appended again, but one more
+   *  reference to them is counted.
    */
 
   int appendF(const char*);
+
+  /** \brief Append a function name to #functionsNames array.
+   *  \param fname -> Symbol of the name to append.
+   *  \return Return 0 on success.
+   *  \return Return 1 if \a fname already exists in #functionsNames.
+   *
+   */
+  int appendF(const symbol&);
+
+  /** \brief Remove a reference to a function name.
+   *  \param fname -> Name to remove.
+   *  \return Return 0 if \a fname has been removed.
+   *  \return Return 1 if \a fname has other references.
+   *  \return Return -1 if \a fname doesn't exist in #functionsNames.
+   *
+   *  The name is removed with its last reference, counted by
+   *  #appendF. Removed names are left in #functionsNames until
+   *  they are half of the array.
+   */
+  int removeF(const char*);
+
+  /** \brief Remove a reference to a function name.
+   *  \param fname -> Symbol of the name to remove.
+   *  \return Return 0 if \a fname has been removed.
+   *  \return Return 1 if \a fname has other references.
+   *  \return Return -1 if \a fname doesn't exist in #functionsNames.
+   */
+  int removeF(const symbol&);
+
+  /// Return the number of references to \a fname, 0 if it doesn't exist
+  int references(const symbol& fname) const;
   /// Sort #functionsNames elements alphabetically
   void sort();
+  /// Sort #functionsNames elements by the rank of each symbol id in \a ranks (see #source_map::nameRanks)
+  void sort(const unsigned int* ranks);
+  /// Exchange the contents of this namespace and \a c
+  void swap(namespace_map& c) noexcept;
+  /// Return the ids of the names in #functionsNames
+  inline const id_bitmap& functionSet() const {return fnameSet;}
+  /// Return the number of function names
+  inline int numFN() const {return (int) fnameSet.size();}
 
   /** \brief Convert stored information to string format.
    *  \param tabs -> Number of initial tabulations.
@@ -216,6 +801,8 @@ public:
 
   /// Overload of assign operator
   namespace_map& operator=(const namespace_map&);
+  /// Move assign operator, \a c is left empty
+  namespace_map& operator=(namespace_map&&) noexcept;
   /// Overload of comparision operator < (for sorting)
   bool operator<(const namespace_map&) const;
   /// Overload of comparision operator > (for sorting)
@@ -226,6 +813,182 @@ public:
   
 };
 
+/**
+ * \class key_map
+ * \ingroup code-parser
+ *
+ * Precomputed table of matching keys ('()', '[]' and '{}')
+ * of a text. The table is built in a single pass and allows
+ * to obtain the corresponding close (open) key of any open
+ * (close) key in constant time. Only keys of the same type
+ * are matched, as does #closeKey.
+ *
+ * Key positions are stored in a bit array with a rank
+ * directory, so the table uses about 0.2 bytes per text
+ * character plus 12 bytes per key.
+ */
+
+class key_map
+{
+ protected:
+  /// Number of characters of mapped text.
+  std::size_t length;
+  /// Number of elements in #bits and #ranks.
+  std::size_t nwords;
+  /// Bit array with one bit set at each key position.
+  unsigned long long* bits;
+  /// Number of keys before each #bits word.
+  unsigned int* ranks;
+  /// Text position of each key.
+  std::size_t* positions;
+  /// Index in #positions of the corresponding key. -1 if the key is not matched.
+  int* partners;
+  /// Number of keys in the text.
+  int nkeys;
+  /// Number of not matched keys.
+  int nunmatched;
+
+  /// Copy is not allowed
+  key_map(const key_map&);
+  /// Assign is not allowed
+  key_map& operator=(const key_map&);
+  
+ public:
+  /// Constructor
+  key_map();
+
+  /** \brief Build the table for specified text
+   *  \param text -> Input text.
+   *  \param length -> Number of characters in \a text.
+   *
+   *  \return Return the number of not matched keys (0 if the text is balanced).
+   */
+  int build(const char*, std::size_t);
+  /// Build the table for specified string. See #build(const char*, std::size_t).
+  int build(const std::string&);
+
+  /** \brief Obtain position of corresponding key.
+   *  \param pos -> Key position.
+   *
+   *  \return Return the position of corresponding open/close key on success
+   *  \return Return std::string::npos if \a pos is not a open/close key
+   *  \return Return std::string::npos if the key at \a pos is not matched
+   */
+  inline std::size_t close(std::size_t pos) const{
+    if(pos >= length)
+      return std::string::npos;
+    const unsigned long long word = bits[pos >> 6];
+    const unsigned long long bit = 1ULL << (pos & 63);
+    if((word & bit) == 0)
+      return std::string::npos;
+    int partner = partners[ranks[pos >> 6] + __builtin_popcountll(word & (bit-1))];
+    if(partner < 0)
+      return std::string::npos;
+    return positions[partner];
+  }
+
+  /// Return true if all keys are matched
+  inline bool balanced() const {return nunmatched == 0;}
+  /// Return the number of not matched keys
+  inline int unmatched() const {return nunmatched;}
+  /// Return the number of keys
+  inline int numKeys() const {return nkeys;}
+
+  /// Free allocated memory
+  void clear();
+
+  /// Destructor
+  ~key_map();
+};
+
+/**
+ * \class parsed_source
+ * \ingroup code-parser
+ *
+ * Handle of one parsed source file. Stores the
+ * cleared code, his #key_map and the location of
+ * each defined function. Functions are extracted
+ * from this handle by reference, so the source text
+ * is stored only once regardless of the number of
+ * defined functions.
+ */
+
+class parsed_source
+{
+ protected:
+  /// Cleared code (without strings nor comments).
+  std::string code;
+  /// Matching keys table of #code.
+  key_map keys;
+  /// Defined function names.
+  std::string* names;
+  /// Number of elements in #names.
+  int nnames;
+  /// Location of each defined function, sorted by name and overload.
+  function_span* spans;
+  /// Number of elements in #spans.
+  int nspans;
+
+  /// Copy is not allowed
+  parsed_source(const parsed_source&);
+  /// Assign is not allowed
+  parsed_source& operator=(const parsed_source&);
+  
+ public:
+  /// Constructor
+  parsed_source();
+
+  /** \brief Parse specified source code
+   *  \param text -> Input source code plain text.
+   *  \param length -> Number of characters in \a text.
+   *
+   *  \return Return the number of defined functions found.
+   *
+   *  Clear the code, build his #key_map and locate all
+   *  defined functions. Previous contents are released.
+   */
+  int parse(const char* text, std::size_t length);
+
+  /** \brief Read and parse specified file
+   *  \param filename -> Source file path.
+   *
+   *  \return Return the number of defined functions found on success.
+   *  \return Return -1 if the file can't be opened.
+   *  \return Return -2 if an error occurs reading the file.
+   */
+  int load(const char* filename);
+  
+  /// Return the cleared code
+  inline const std::string& text() const {return code;}
+  /// Return the #key_map of cleared code
+  inline const key_map& keyMap() const {return keys;}
+  /// Return the number of defined function names
+  inline int numNames() const {return nnames;}
+  /// Return the name in position \a i. \a i must be in range.
+  inline const std::string& name(int i) const {return names[i];}
+  /// Return the number of defined functions (including overloads)
+  inline int numSpans() const {return nspans;}
+  /// Return the location of function \a i. \a i must be in range.
+  inline const function_span& span(int i) const {return spans[i];}
+  /// Return the name of function \a i. \a i must be in range.
+  inline const std::string& spanName(int i) const {return names[spans[i].name];}
+
+  /** \brief Find a defined function
+   *  \param fname -> Function name.
+   *  \param overload -> Overload of the function.
+   *
+   *  \return Return the position in #spans of the specified function.
+   *  \return Return -1 if the function has not been found.
+   */
+  int find(const char* fname, int overload = 1) const;
+  
+  /// Free allocated memory
+  void clear();
+
+  /// Destructor
+  ~parsed_source();
+};
+
 /**
  * \class function_map
  * \ingroup code-parser
@@ -238,6 +1001,9 @@ public:
 class function_map
 {
   friend class source_map;
+  friend class parse_cache;
+  friend class file_map;
+  friend class source_stream;
  protected:
   /// Number of namespaces used in this function.
   int nNamespaces;
@@ -250,9 +1016,11 @@ class function_map
   int maxCalledF;
 
   /// Array with namespace names used in this function.
-  std::string* namespaces;
+  symbol* namespaces;
   /// Array with pairs name/number of calls for each called function.
   fcall* fcalls;
+  /// Arena of #namespaces and #fcalls, or null pointer if they are allocated with new.
+  arena* pool;
 
   /** \brief Resize array #fcalls
    *  \param dim -> new dimension.
@@ -265,9 +1033,9 @@ class function_map
   
  public:
   /// Function name.
-  std::string name;
+  symbol name;
   /// Function source filename.
-  std::string sourceFile;
+  symbol sourceFile;
   /// Overload ID. This parameter allow to diferenciate between functions with same name (overloaded).
   int nOverload;
 
@@ -275,6 +1043,8 @@ class function_map
   function_map();
   /// Constructor that copy argument #function_map
   function_map(const function_map&);
+  /// Move constructor, takes the arrays of \a c and leaves it empty
+  function_map(function_map&&) noexcept;
 
   /** \brief Load function information
    *  \param inS -> input string.
@@ -290,10 +1060,39 @@ class function_map
    *  used namespaces and called functions (pairs name/ncalls).
    *
    *  Notice that source string \a inS must have been marked previously
-   *  by function #definedFunc .
+   *  by function #definedFunc . If \a keys is specified, it must be
+   *  the #key_map of \a inS and is used to find matching keys.
+   */
+  
+  int loadFunction(const std::string&, const char*, int = 1, const key_map* = 0);
+
+  /** \brief Load information of a function from his span
+   *  \param inS -> cleared input string.
+   *  \param span -> Function location returned by #definedFunc .
+   *  \param fname -> Function name.
+   *  \param keys -> #key_map of \a inS.
+   *
+   *  \return Return 0 on success.
+   *
+   *  Same as previous function, but the body is taken directly from
+   *  \a span, so \a inS has not to be marked and is not scanned
+   *  out of function body.
    */
   
-  int loadFunction(std::string, const char*, int = 1);
+  int loadFunction(const std::string& inS, const function_span& span, const char* fname, const key_map& keys);
+
+  /** \brief Load information of a parsed function
+   *  \param src -> Parsed source.
+   *  \param i -> Function position in \a src spans.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -1 if \a i is out of range.
+   */
+  
+  int loadFunction(const parsed_source& src, int i);
+
+  /// Exchange the contents of this function and \a c
+  void swap(function_map& c) noexcept;
 
   /** \brief Extract namespace name
    *  \param i -> Array #namespaces position.
@@ -380,9 +1179,13 @@ class function_map
 
   /// Sort #namespaces and #fcalls elements alphabetically
   void sort();
+  /// Sort #namespaces and #fcalls elements by the rank of each symbol id in \a ranks (see #source_map::nameRanks)
+  void sort(const unsigned int* ranks);
 
   /// Overload for assign operator (=)
   function_map& operator=(const function_map&);
+  /// Move assign operator, \a c is left empty
+  function_map& operator=(function_map&&) noexcept;
   /// Overload for comparision operator < (for sorting)
   bool operator<(const function_map&) const;
   /// Overload for comparision operator > (for sorting)
@@ -403,6 +1206,649 @@ class function_map
   ~function_map();
 };
 
+/**
+ * \class mapped_file
+ * \ingroup code-parser
+ *
+ * Read only view of a source file contents.
+ * Regular files of #mapMinBytes or more are mapped in
+ * memory (mmap) and the text is read directly from the
+ * mapped pages. Smaller files are read to an internal
+ * buffer, like pipes and special files, which can't be
+ * mapped.
+ *
+ * Reading mapped pages past the end of a file that has been
+ * truncated raises SIGBUS, so files that can be rewritten
+ * while they are read (editors, version control, builds)
+ * must be opened with the copy option, or read from the
+ * mapped pages with #readMapped .
+ */
+
+class mapped_file
+{
+ protected:
+  /// Pointer to the first character of file contents.
+  const char* pdata;
+  /// Number of characters pointed by #pdata.
+  std::size_t length;
+  /// True if #pdata points to mapped pages.
+  bool mapped;
+  /// Storage used when the file can't be mapped.
+  std::string buffer;
+  /// Last modification time in nanoseconds (0 if unknown).
+  long long modTime;
+
+  /// Copy is not allowed
+  mapped_file(const mapped_file&);
+  /// Assign is not allowed
+  mapped_file& operator=(const mapped_file&);
+  
+ public:
+  /** Smaller regular files are read instead of mapped. Reading
+   *  them costs about the same, and a truncation while they are
+   *  read only gives shorter contents.
+   */
+  static const std::size_t mapMinBytes = 1 << 20;
+
+  /// Constructor
+  mapped_file();
+
+  /** \brief Open and map specified file
+   *  \param filename -> File to open.
+   *  \param copy -> Read the contents to the internal buffer
+   *          even if the file can be mapped.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -1 if the file can't be opened.
+   *  \return Return -2 if an error occurs reading the file.
+   *
+   *  Regular files of #mapMinBytes or more are mapped in memory
+   *  unless \a copy is set. Other files (small files, pipes,
+   *  character devices...) are read to an internal buffer.
+   *  Previous contents are released.
+   */
+  int open(const char*, bool copy = false);
+
+  /** \brief Read the contents guarded against truncation
+   *  \param reader -> Function that reads #data .
+   *  \return Return true if \a reader has finished.
+   *  \return Return false if the mapped file has been truncated
+   *          while \a reader was running.
+   *
+   *  If the contents are mapped, the SIGBUS raised by reading
+   *  pages past the end of a truncated file returns from this
+   *  function instead of killing the process. The caller should
+   *  open the file again with the copy option. The interrupted
+   *  \a reader is not unwound, so it must not hold locks nor
+   *  leave objects in an invalid state while it reads the mapped
+   *  pages. If the contents are not mapped, \a reader is called
+   *  without guard.
+   *
+   *  A SIGBUS handler is installed by the first guarded read. Faults
+   *  out of guarded reads are passed to the previous handler.
+   */
+  bool readMapped(const std::function<void()>& reader) const;
+
+  /// Return a pointer to the file contents.
+  inline const char* data() const {return pdata;}
+  /// Return the number of characters in the file.
+  inline std::size_t size() const {return length;}
+  /// Return true if contents are read from mapped pages.
+  inline bool isMapped() const {return mapped;}
+  /// Return the last modification time of the file in nanoseconds since epoch (0 if unknown).
+  inline long long mtime() const {return modTime;}
+
+  /// Unmap or free file contents.
+  void close();
+
+  /// Destructor
+  ~mapped_file();
+};
+
+/**
+ * \struct ingest_stats
+ * \ingroup code-parser
+ *
+ * Throughput counters of source file ingestion.
+ *
+ */
+
+struct ingest_stats
+{
+  /// Number of read files.
+  unsigned long files;
+  /// Number of files read from mapped pages.
+  unsigned long mappedFiles;
+  /// Number of files taken from a #parse_cache .
+  unsigned long cachedFiles;
+  /// Number of files with not matched keys.
+  unsigned long unbalancedFiles;
+  /// Number of read bytes.
+  unsigned long long bytes;
+  /// Time spent opening and reading files (seconds).
+  double readTime;
+  /// Time spent clearing and extracting the code (seconds).
+  double parseTime;
+
+  /// Constructor
+  ingest_stats();
+  /// Set all counters to zero.
+  void clear();
+  /// Return read throughput in MB/s.
+  double readMBps() const;
+  /// Return overall (read and parse) throughput in MB/s.
+  double totalMBps() const;
+
+  /** \brief Convert counters to string format.
+   *  \param tabs -> Number of initial tabulations.
+   *  \return Return a string containing formated counters.
+   */
+  std::string to_string(int = 0) const;
+};
+
+/**
+ * \struct file_record
+ * \ingroup code-parser
+ *
+ * Fingerprint of a mapped source file. Used
+ * to detect which files must be mapped again.
+ */
+
+struct file_record
+{
+public:
+  /// Source filename.
+  std::string path;
+  /// File size in bytes.
+  unsigned long long size;
+  /// Last modification time in nanoseconds.
+  long long mtime;
+  /// Content hash (see #contentHash).
+  unsigned long long hash;
+
+  /// Constructor
+  file_record() : size(0), mtime(0), hash(0) {}
+};
+
+class parse_cache;
+
+/**
+ * \class file_map
+ * \ingroup code-parser
+ *
+ * Map of a single source file. Stores the functions
+ * extracted from one file before they are merged in a
+ * #source_map . Loading a #file_map doesn't modify any
+ * shared state, so many files can be loaded concurrently.
+ */
+
+class file_map
+{
+  friend class source_map;
+  friend class parse_cache;
+  friend class source_stream;
+ protected:
+  /// Source filename.
+  std::string filename;
+  /// Load result (see #load).
+  int status;
+  /// Array with extracted functions.
+  function_map* functions;
+  /// Number of elements in #functions.
+  int nFunctions;
+  /// Arena of the arrays of #functions. Is taken by the #source_map where they are appended.
+  arena pool;
+  /// Array with defined function names.
+  std::string* names;
+  /// Number of elements in #names.
+  int nNames;
+  /// Number of not matched keys.
+  int unmatched;
+  /// True if the file has been mapped in memory.
+  bool mapped;
+  /// File size in bytes.
+  unsigned long long bytes;
+  /// Time spent reading the file (s).
+  double readTime;
+  /// Time spent parsing the file (s).
+  double parseTime;
+  /// Last modification time in nanoseconds.
+  long long mtime;
+  /// Content hash.
+  unsigned long long hash;
+  /// True if the functions have been taken from a #parse_cache .
+  bool cached;
+
+  /// Copy is not allowed
+  file_map(const file_map&);
+  /// Assign is not allowed
+  file_map& operator=(const file_map&);
+  
+ public:
+  /// Constructor
+  file_map();
+
+  /** \brief Map specified source file.
+   *  \param filename -> Source filename.
+   *  \param known -> Optional fingerprint of a previous map of this file.
+   *  \param cache -> Optional cache of parsed files.
+   *  \param copy -> Read the file instead of mapping it. Used
+   *          for files that can be rewritten while they are read.
+   *  \return Return 0 on success.
+   *  \return Return 1 if the content is the same than \a known.
+   *  \return Return -1 if file can't be opened.
+   *  \return Return -3 if there are not any function definition
+   *          in specified source file.
+   *
+   *  Read, clear and extract all defined functions of
+   *  \a filename. Previous contents are released. If \a known
+   *  is specified and the content hash is the same, the file
+   *  is not parsed. If \a cache is specified, the functions are
+   *  taken from it when the content has been parsed before, and
+   *  stored on it otherwise. If the size or the modification time
+   *  of the file change while it is read, the stored modification
+   *  time is 0, so the next #source_map::rescan maps it again. A
+   *  mapped file truncated while it is read is loaded again with
+   *  \a copy (see #mapped_file::readMapped).
+   */
+  int load(const char*, const file_record* known = 0, parse_cache* cache = 0, bool copy = false);
+
+  /// Return the load result
+  inline int getStatus() const {return status;}
+  /// Return the number of extracted functions
+  inline int numF() const {return nFunctions;}
+  /// Return the extracted function \a i or a null pointer if \a i is out of range
+  inline const function_map* getFunction(int i) const {return i >= 0 && i < nFunctions ? &functions[i] : 0;}
+  
+  /// Free allocated memory
+  void clear();
+
+  /// Destructor
+  ~file_map();
+};
+
+/**
+ * \class parse_cache
+ * \ingroup code-parser
+ *
+ * Directory of parsed files shared between processes.
+ * Each entry stores the functions extracted from one
+ * file content and is named by the content hash and
+ * size, so files with the same content are parsed only
+ * once regardless of their path or the process that
+ * mapped them first.
+ *
+ * Entries are written to a temporary file and renamed,
+ * so concurrent processes never read partial entries.
+ * Entries of other format versions, or corrupted ones,
+ * are ignored and overwritten. When the directory grows
+ * over the size limit, the least recently used entries
+ * are removed.
+ */
+
+class parse_cache
+{
+ protected:
+  /// Cache directory path.
+  std::string dir;
+  /// Maximum size of the cache directory in bytes.
+  unsigned long long maxBytes;
+  /// Estimated size of the cache directory in bytes.
+  std::atomic<unsigned long long> totalBytes;
+  /// Counter used to name temporary files.
+  std::atomic<unsigned long> nextTmp;
+  /// Number of found entries.
+  std::atomic<unsigned long> hits;
+  /// Number of not found entries.
+  std::atomic<unsigned long> misses;
+  /// Number of stored entries.
+  std::atomic<unsigned long> stores;
+  /// Serializes #trim calls.
+  std::mutex trimMutex;
+
+  /// Return the entry path of a content with hash \a hash and size \a size
+  std::string entryPath(unsigned long long hash, unsigned long long size) const;
+
+  /// Copy is not allowed
+  parse_cache(const parse_cache&);
+  /// Assign is not allowed
+  parse_cache& operator=(const parse_cache&);
+  
+ public:
+  /// Format version of cache entries.
+  static const unsigned int version = 1;
+  
+  /// Constructor
+  parse_cache();
+
+  /** \brief Open a cache directory
+   *  \param path -> Cache directory. It is created if doesn't exist.
+   *  \param maxBytes -> Maximum size of the cache in bytes.
+   *  \return Return 0 on success.
+   *  \return Return -1 if the directory can't be created.
+   *
+   *  The directory is trimmed to \a maxBytes (see #trim).
+   */
+  int open(const char* path, unsigned long long maxBytes = 256ULL << 20);
+
+  /// Return true if a cache directory has been opened
+  inline bool isOpen() const {return !dir.empty();}
+
+  /** \brief Take the parsed functions of a file from the cache
+   *  \param file -> Loaded file whose hash and size have been computed.
+   *  \return Return 0 if the entry has been found.
+   *  \return Return -1 if there is no valid entry.
+   *
+   *  On success, \a file gets the functions, names, not matched
+   *  keys and status stored in the entry, and the entry is marked
+   *  as recently used.
+   */
+  int fetch(file_map& file);
+
+  /** \brief Store the parsed functions of a file
+   *  \param file -> Parsed file.
+   *  \return Return 0 on success.
+   *  \return Return -1 if the entry can't be written.
+   */
+  int store(const file_map& file);
+
+  /** \brief Remove least recently used entries
+   *  \return Return the number of removed entries.
+   *
+   *  If the cache directory is bigger than the size limit, the
+   *  least recently used entries are removed until the size is
+   *  under 3/4 of the limit. Old temporary files of interrupted
+   *  processes are removed too.
+   */
+  int trim();
+
+  /// Return the number of found entries
+  inline unsigned long numHits() const {return hits;}
+  /// Return the number of not found entries
+  inline unsigned long numMisses() const {return misses;}
+  /// Return the number of stored entries
+  inline unsigned long numStores() const {return stores;}
+};
+
+/**
+ * \class source_stream
+ * \ingroup code-parser
+ *
+ * Parser of a source file received in consecutive
+ * chunks. The code is cleared as #clearCode does, but
+ * the lexer state is carried between chunks, so strings
+ * and comments can be split anywhere. The cleared code
+ * is cut after each '}' or ';' outside any block, and the
+ * complete part is parsed as soon as a chunk closes it.
+ * Then, only the unfinished declaration or block is kept,
+ * so memory is bounded by the largest top level block
+ * (usually a function) plus the chunk size.
+ *
+ * Units are scanned like #definedFunc scans a whole text:
+ * a unit whose last ')' waits for a body is joined to the
+ * next one, and the extraction stops at a body preceded by
+ * a '(' without identifier. Hence, for code without unmatched
+ * keys, the extracted functions are the same than parsing the
+ * whole text, but they are found in text order instead of
+ * sorted by name.
+ */
+
+class source_stream
+{
+ protected:
+  /// Minimum length of a unit ended by ';'. Shorter units are joined to the next one.
+  static const std::size_t minUnit = 1 << 16;
+  /// Lexer state (code, string, char, line or block comment).
+  int state;
+  /// Previous input character inside strings and comments.
+  char prev;
+  /// True if the previous block comment character is a '*'.
+  bool star;
+  /// Cleared code pending to be parsed, preceded by a few parsed characters.
+  std::string code;
+  /// Position in #code of the first not parsed character.
+  std::size_t start;
+  /// Number of characters of #code checked looking for cut points.
+  std::size_t scanned;
+  /// Position after the last cut point.
+  std::size_t cut;
+  /// Cut points not parsed yet.
+  std::vector<std::size_t> cuts;
+  /// Number of open '{' at #scanned.
+  int braces;
+  /// Number of open '(' outside any block at #scanned.
+  int parens;
+  /// Number of definitions found of each function name.
+  std::unordered_map<std::string,int> overloads;
+  /// Number of removed strings and comments.
+  int nremoved;
+  /// Number of not matched keys in parsed code.
+  int nunmatched;
+  /// True if #definedFunc has stopped in a parsed unit. The following units are not scanned.
+  bool stopped;
+  /// Maximum number of characters stored in #code.
+  std::size_t peak;
+  /// Number of streamed bytes.
+  unsigned long long length;
+  /// Hash lanes of streamed bytes (see #contentHash).
+  unsigned long long lanes[4];
+  /// Streamed bytes not hashed yet.
+  std::string hashTail;
+  /// Content hash, computed by #finish.
+  unsigned long long fullHash;
+
+  /// Clear \a n characters of \a text appending the code to #code
+  void clearText(const char* text, std::size_t n);
+  /// Scan new cleared code and store the found cut points
+  void findCuts();
+  /** \brief Parse one unit of code
+   *  \param end -> End position of the unit in #code .
+   *  \param last -> True if no code follows the unit.
+   *  \param out -> Output #file_map where functions are appended.
+   *  \param maxF -> Size of \a out functions array.
+   *  \param maxN -> Size of \a out names array.
+   *
+   *  If the last ')' of the unit is not followed by any '{' nor ';'
+   *  (see #definedFunc), the unit is not parsed unless it is the
+   *  \a last one. Then, it is parsed with the following unit, as the
+   *  scan of the whole code would look for the body there.
+   */
+  void parseUnit(std::size_t end, bool last, file_map& out, int& maxF, int& maxN);
+  /** \brief Parse the code until a position
+   *  \param end -> End position in #code .
+   *  \param last -> True if no code follows \a end .
+   *  \param out -> Output #file_map . Previous functions are released.
+   *  \return Return the number of extracted functions.
+   *
+   *  Each unit between cut points is parsed independently.
+   */
+  int parseCode(std::size_t end, bool last, file_map& out);
+
+  /// Copy is not allowed
+  source_stream(const source_stream&);
+  /// Assign is not allowed
+  source_stream& operator=(const source_stream&);
+  
+ public:
+  /// Constructor
+  source_stream();
+
+  /// Prepare the stream to receive a new source
+  void reset();
+
+  /** \brief Receive the next chunk of the source
+   *  \param text -> Chunk characters.
+   *  \param n -> Number of characters in \a text.
+   *  \param out -> Output #file_map .
+   *  \return Return the number of functions completed by this chunk.
+   *
+   *  The functions completed by \a text, and the names defined for
+   *  the first time, are stored in \a out releasing previous ones.
+   *  Function source file is not set.
+   */
+  int feed(const char* text, std::size_t n, file_map& out);
+
+  /** \brief Finish the source
+   *  \param out -> Output #file_map .
+   *  \return Return the number of functions of the remaining code.
+   *
+   *  Parse the remaining code as #feed does. Non limited strings
+   *  and comments are reported like #clearCode does.
+   */
+  int finish(file_map& out);
+
+  /// Return the number of received bytes
+  inline unsigned long long bytes() const {return length;}
+  /// Return the hash of the received bytes (see #contentHash). Valid after #finish.
+  inline unsigned long long hash() const {return fullHash;}
+  /// Return the number of not matched keys in parsed code
+  inline int unmatched() const {return nunmatched;}
+  /// Return the number of different function names found
+  inline int numNames() const {return (int) overloads.size();}
+  /// Return the maximum number of cleared characters stored at once
+  inline std::size_t peakSize() const {return peak;}
+};
+
+/**
+ * \class crawl_options
+ * \ingroup code-parser
+ *
+ * Options used by #source_map::appendDirectory to
+ * select the files to map. By default, symbolic links
+ * are not followed and only C/C++ source and header
+ * extensions are accepted.
+ */
+
+class crawl_options
+{
+ protected:
+  /// Accepted file extensions (with the '.').
+  std::string* extensions;
+  /// Number of elements in #extensions.
+  int nExtensions;
+  /// Maximum elements than fit in #extensions.
+  int maxExtensions;
+  /// Glob patterns of excluded paths.
+  std::string* excludes;
+  /// Number of elements in #excludes.
+  int nExcludes;
+  /// Maximum elements than fit in #excludes.
+  int maxExcludes;
+
+  /// Append \a value to array \a array resizing it if is necessary
+  static void append(std::string*& array, int& n, int& max, const char* value);
+  
+ public:
+  /** Follow symbolic links to files and directories. Each file or
+   *  directory is visited once, even if it is reached by many paths.
+   */
+  bool followLinks;
+  /// Number of mapping threads. If is 0 or negative, one thread per cpu will be used.
+  int threads;
+  
+  /// Constructor
+  crawl_options();
+  /// Constructor that copy argument #crawl_options
+  crawl_options(const crawl_options&);
+  /// Overload of assign operator (=)
+  crawl_options& operator=(const crawl_options&);
+
+  /// Append an accepted extension (for example ".cpp")
+  void addExtension(const char*);
+  /// Remove all accepted extensions. Then, all files will be accepted.
+  void clearExtensions();
+
+  /** \brief Append an exclude pattern
+   *  \param pattern -> Glob pattern (see fnmatch).
+   *
+   *  A pattern ending with '/' only matches directories. A pattern
+   *  with any other '/' is matched against the path relative to
+   *  the crawled root, otherwise is matched against the entry name.
+   *  For example, "build/" excludes all directories named build,
+   *  and "src/third_party" only the one inside root's "src" directory.
+   */
+  void addExclude(const char*);
+  /// Remove all exclude patterns
+  void clearExcludes();
+
+  /// Return true if the file name \a name has an accepted extension
+  bool accepted(const char* name) const;
+  /** \brief Check if an entry must be excluded
+   *  \param relPath -> Path relative to the crawled root.
+   *  \param name -> Entry name.
+   *  \param isDir -> True if the entry is a directory.
+   *
+   *  \return Return true if some exclude pattern matches the entry.
+   */
+  bool excluded(const char* relPath, const char* name, bool isDir) const;
+
+  /// Destructor
+  ~crawl_options();
+};
+
+/// Function used to send found paths to the mapping threads. The sent paths are moved.
+typedef std::function<void(std::vector<std::string>&)> path_sink;
+/// Function that finds paths to map and sends them using the received #path_sink .
+typedef std::function<void(const path_sink&)> path_producer;
+
+/**
+ * \struct function_key
+ * \ingroup code-parser
+ *
+ * Key of the #source_map function index: ids of the
+ * function name and source file, and overload. An
+ * overload 0 matches any overload.
+ *
+ */
+
+struct function_key
+{
+  /// Id of the function name symbol.
+  unsigned int name;
+  /// Id of the source file symbol.
+  unsigned int source;
+  /// Overload number or 0 for any overload.
+  int overload;
+
+  /// Constructor
+  function_key(unsigned int inName, unsigned int inSource, int inOverload) : name(inName), source(inSource), overload(inOverload) {}
+  /// Overload of comparision operator ==
+  inline bool operator==(const function_key& c) const {return name == c.name && source == c.source && overload == c.overload;}
+};
+
+/// Hash functor of #function_key
+struct function_key_hash
+{
+  inline std::size_t operator()(const function_key& k) const {
+    unsigned long long h = ((unsigned long long) k.name << 32) | k.source;
+    h ^= (unsigned long long) (unsigned int) k.overload * 0x9E3779B97F4A7C15ULL;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return (std::size_t) (h ^ (h >> 31));
+  }
+};
+
+/**
+ * \struct function_range
+ * \ingroup code-parser
+ *
+ * Positions [#first, #end) of a run of consecutive #source_map
+ * functions extracted from the same source file. Positions are
+ * stored like the ones of the function indexes, so they are not
+ * modified when functions are removed.
+ *
+ */
+
+struct function_range
+{
+  /// Position of the first function of the file.
+  int first;
+  /// Position following the last function of the file.
+  int end;
+
+  /// Constructor
+  function_range() : first(0), end(0) {}
+};
+
 /**
  * \class source_map
  * \ingroup code-parser
@@ -435,13 +1881,260 @@ class source_map
   int maxNamespaceMaps;
   
   /// Array with used namespace names.
-  std::string* namespaces;  
+  symbol* namespaces;  
   /// Array with defined functions names.
-  std::string* defFuncNames;
+  symbol* defFuncNames;
   /// Array with mapped functions.
   function_map* functions;
   /// Array with mapped namespaces.
   namespace_map* namespaceMaps;  
+  /** Arena of #namespaces, #defFuncNames and the arrays of
+   *  #functions and #namespaceMaps. Released by #clear .
+   */
+  arena pool;
+  /// Size of #pool that triggers the next check of #reclaimPool .
+  std::size_t poolCheck;
+
+  /// Ingestion throughput counters.
+  ingest_stats stats;
+  /// Optional cache of parsed files (not owned).
+  parse_cache* cache;
+
+  /// Number of #file_record stored in #files array.
+  int nFiles;
+  /// Current maximum number of elements that fit in #files .
+  int maxFiles;
+  /// Array with the fingerprint of each mapped file.
+  file_record* files;
+  /// Position in #files of each mapped path.
+  std::unordered_map<std::string,int> fileIndex;
+  /** Runs of positions in #functions, stored like in #functionIndex,
+   *  of the functions of each source file id. Files are appended in
+   *  a single block, so there is usually one run per file. After
+   *  #sort there can be one run per function, but the runs never
+   *  contain functions of other files.
+   */
+  std::unordered_map<unsigned int,std::vector<function_range> > sourceRanges;
+
+  /** Position in #functions of the first function with each
+   *  name, source and overload, and with each name and source
+   *  (overload 0).
+   */
+  std::unordered_map<function_key,int,function_key_hash> functionIndex;
+  /// Position in #functions of the first function with each name id.
+  std::unordered_map<unsigned int,int> nameIndex;
+  /// Number of functions in #functions with each name id.
+  std::unordered_map<unsigned int,int> nameCount;
+  /** Sorted positions, stored like in #nameIndex, of the functions
+   *  of each name id defined by more than one function. Removed
+   *  functions are erased when they are marked, so the next function
+   *  with the same name is found without scanning #functions . Names
+   *  with a single function are only stored in #nameIndex .
+   */
+  std::unordered_map<unsigned int,std::vector<int> > namePositions;
+  /** Positions in #functions of the removed functions not compacted
+   *  yet. They are not found by the indexes nor read by position, and
+   *  are compacted when they are more than the other functions, or
+   *  by a function that moves the map (see #compact).
+   */
+  id_bitmap removedF;
+  /// Ids of the names whose functions have been marked as removed, dropped by #dropNames .
+  id_bitmap releasedNames;
+  /// Ids of the namespaces whose functions have been marked as removed, dropped by #dropNames .
+  id_bitmap releasedNS;
+  /** Sorted positions, as stored in #functionIndex and #nameIndex,
+   *  of the functions removed since the indexes were written.
+   *  Stored positions are shifted when they are read, and the
+   *  indexes are rewritten when this array grows too much.
+   */
+  std::vector<int> indexGaps;
+  /// Ids of the names in #defFuncNames.
+  id_bitmap fnameSet;
+  /// Position in #defFuncNames of each name id in #fnameSet .
+  id_index fnamePosition;
+  /** Positions in #defFuncNames of the names dropped by #dropNames
+   *  and not compacted yet. They are skipped when the names are read
+   *  by position, and compacted by #compactNames .
+   */
+  id_bitmap removedNames;
+  /// Position in #namespaces of each namespace id.
+  id_index namespaceIndex;
+  /// Position in #namespaceMaps of each namespace id.
+  id_index namespaceMapIndex;
+
+  /// Build again #namespaceIndex and #namespaceMapIndex .
+  void indexNames();
+
+  /** \brief Rank the names used by the map alphabetically
+   *  \param ranks -> Output rank of each symbol id.
+   *
+   *  Each distinct name is compared by his text only once.
+   *  Then, \a ranks[id] is the alphabetical position of the
+   *  symbol \a id among the names used by the map, so sorting
+   *  by ranks compares integers instead of texts. Ids not used
+   *  by the map are UINT_MAX.
+   */
+  void nameRanks(std::vector<unsigned int>& ranks) const;
+
+  /** \brief Register the namespaces of a function
+   *  \param i -> Position of the function in #functions .
+   *
+   *  Append the namespaces used by the function \a i to
+   *  #namespaces, if they are new, and its name to the
+   *  corresponding #namespaceMaps .
+   */
+  void useNamespaces(int i);
+
+  /** \brief Index functions
+   *  \param first -> First position of #functions to index.
+   *
+   *  Add the functions from \a first to the end of #functions
+   *  to #functionIndex and #nameIndex. Already indexed keys keep
+   *  their position, so the first matching function is found.
+   *  With \a first 0, the indexes are built again.
+   */
+  void indexFunctions(int first);
+
+  /** \brief Index sorted functions
+   *
+   *  Rewrite the positions stored in #functionIndex, #nameIndex
+   *  and #sourceRanges after #functions have been sorted by name,
+   *  source file and overload. The indexed keys don't change, so
+   *  no key is inserted nor erased, and the first function of each
+   *  key is found comparing each function with the previous one.
+   */
+  void indexSorted();
+
+  /** \brief Add a function to #namePositions
+   *  \param name -> Name id of the function.
+   *  \param stored -> Position of the function, stored like in #nameIndex .
+   *
+   *  Must be called before the function is added to #nameIndex, so
+   *  the position of the other function with the same name is known
+   *  when the name gets his second function.
+   */
+  void indexPosition(unsigned int name, int stored);
+
+  /// Return the position in #functions of a position stored in the function indexes.
+  inline int indexedPosition(int stored) const {
+    if(indexGaps.empty()){return stored;}
+    return stored - (int) (std::lower_bound(indexGaps.begin(), indexGaps.end(), stored)-indexGaps.begin());
+  }
+
+  /// Return the position to store in the function indexes for the element \a i of #functions.
+  int storedPosition(int i) const;
+
+  /** \brief Mark a function as removed
+   *  \param i -> Position of the function in #functions .
+   *
+   *  Add \a i to #removedF, release its names (see #releaseNames)
+   *  and move the index keys that point to the function to the
+   *  next matching function, or erase them if there is not any.
+   *  The next function is taken from #namePositions, so the cost
+   *  doesn't depend on the distance between functions with the same
+   *  name. The function is kept in #functions until #compactFunctions
+   *  is called.
+   */
+  void markRemoved(int i);
+
+  /** \brief Mark the functions that match a name
+   *  \param fname -> Function name.
+   *  \param sname -> Source filename or null pointer to match any source.
+   *  \param overload -> Overload to match. If is 0 or negative any overload matches.
+   *  \return Return the number of marked functions.
+   *
+   *  Only the functions with name \a fname are visited, using
+   *  their positions stored in #nameIndex and #namePositions .
+   */
+  int markFunctions(const symbol& fname, const symbol* sname, int overload);
+
+  /** \brief Mark the functions of a source file
+   *  \param source -> Source filename.
+   *  \param marked -> Optional output with the positions of the marked functions, in map order.
+   *  \return Return the number of marked functions.
+   *
+   *  Only the functions in the runs of \a source stored in
+   *  #sourceRanges are visited.
+   */
+  int markSource(const symbol& source, std::vector<int>* marked = 0);
+
+  /** \brief Remove the functions marked in #removedF
+   *
+   *  Move the remaining functions keeping their order. Names and
+   *  namespaces have been released when the functions were marked.
+   *  All marked functions are removed in a single pass.
+   */
+  void compactFunctions();
+
+  /** \brief Compact the marked functions if there are too many
+   *
+   *  Called after each removal. The marked functions are compacted
+   *  when they are more than the other functions, so the linear cost
+   *  of #compactFunctions is shared by as many removals as functions
+   *  are kept, and removals take constant amortized time.
+   */
+  void collectRemoved();
+
+  /** \brief Release the names of a removed function
+   *  \param f -> Removed function, already discounted from #nameCount .
+   *
+   *  Remove the references of \a f from its namespace maps. The
+   *  names and namespaces left without functions are added to
+   *  #releasedNames and #releasedNS .
+   */
+  void releaseNames(const function_map& f);
+
+  /** \brief Remove the released names and namespaces
+   *
+   *  Drop the names and namespaces of #releasedNames and #releasedNS
+   *  that have not got other functions since they were released.
+   *  Called by each removal once its functions are marked, so the
+   *  names read from the map never include names without functions.
+   *  Names are only marked in #removedNames, so dropping a name takes
+   *  constant time. Namespaces are removed from #namespaces and
+   *  #namespaceMaps, which costs linear time in the number of
+   *  namespaces, but only when a namespace is left without functions.
+   */
+  void dropNames();
+
+  /** \brief Remove the names marked in #removedNames
+   *
+   *  Move the remaining names of #defFuncNames keeping their order
+   *  and build #fnamePosition again. Called when the marked names
+   *  are more than the remaining ones, and by #sort and #compact .
+   */
+  void compactNames();
+
+  /** \brief Reclaim the unused memory of #pool
+   *
+   *  Arrays of removed functions and arrays replaced when they
+   *  grow are not released by the arena. When #pool has grown a
+   *  quarter since the last check and less than three quarters of
+   *  it are used, the used arrays are copied to a new arena and the
+   *  old one is released, so the arena stays below twice the used
+   *  memory. The cost of each check is linear in the map size, but
+   *  checks are done only after the arena grows.
+   */
+  void reclaimPool();
+
+  /** \brief Remove a file fingerprint
+   *  \param k -> Position in #files .
+   *
+   *  The following fingerprints are moved one position.
+   */
+  void removeRecord(int k);
+
+  /** \brief Resize array #files
+   *  \param dim -> new dimension.
+   *
+   *  Resize array #files keeping existing
+   *  elements. If \a dim is less than #nFiles, only
+   *  first \a dim elements will be saved.
+   */
+  void resizeFR(int);
+
+  /// Store or update the fingerprint of a loaded #file_map .
+  void recordFile(const file_map&);
 
   /** \brief Resize array #defFuncNames
    *  \param dim -> new dimension.
@@ -479,6 +2172,55 @@ class source_map
    */        
   void resizeNS(int);
 
+  /** \brief Merge a file map
+   *  \param file -> Loaded #file_map .
+   *  \param slots -> Optional positions of marked functions where the functions
+   *          are stored (see #replaceFunctions) instead of appending them.
+   *  \return Return the load result of \a file .
+   *
+   *  Append the functions of \a file, and their names and
+   *  namespaces, to this map. Extracted functions are moved,
+   *  so \a file is left empty.
+   */
+  int merge(file_map&, const std::vector<int>* slots = 0);
+
+  /// Append the names of \a file that are not in #defFuncNames .
+  void appendNames(const file_map& file);
+
+  /** \brief Append the functions of a file map
+   *  \param file -> #file_map with the functions to append.
+   *
+   *  Append the names and functions of \a file and update the
+   *  namespace maps. Unlike #merge, file fingerprint and counters
+   *  are not modified, so a file can be appended in many parts.
+   */
+  void appendFunctions(file_map&);
+
+  /** \brief Replace marked functions by the functions of a file map
+   *  \param file -> #file_map with as many functions as \a slots .
+   *  \param slots -> Positions of functions marked in #removedF .
+   *
+   *  Each function of \a slots is exchanged with the function of
+   *  \a file in the same order and unmarked, so the other functions
+   *  are not moved. The replaced functions are left in \a file and
+   *  their names and namespaces are released after the new ones
+   *  have been added.
+   */
+  void replaceFunctions(file_map& file, const std::vector<int>& slots);
+
+  /** \brief Map the paths found by a producer
+   *  \param producer -> Function that finds the paths to map.
+   *  \param threads -> Number of mapping threads. If is 0 or
+   *          negative, one thread per cpu will be used.
+   *  \param nfound -> Optional output with the number of sent paths.
+   *  \return Return the number of appended files.
+   *
+   *  Run \a producer in its own thread while the sent paths are
+   *  mapped concurrently. The mapped files are merged in the same
+   *  order they were sent.
+   */
+  int appendProduced(const path_producer& producer, int threads, int* nfound);
+  
  public:
 
   /// Constructor.
@@ -512,6 +2254,148 @@ class source_map
    */          
   int appendSource(const char*);
 
+  /** \brief Append specified source filename reading it in chunks.
+   *  \param filename -> Source filename.
+   *  \param window -> Size of read chunks in bytes.
+   *  \return Return 0 on success.
+   *  \return Return -1 if file can't be opened.
+   *  \return Return -2 if an error occurs reading the file.
+   *  \return Return -3 if there are not any function definition
+   *          in specified source file.
+   *
+   *  Like #appendSource, but the file is never stored in memory.
+   *  It is read and parsed by #source_stream, and each function
+   *  is appended to the map once the chunk that completes it is
+   *  processed. Useful for huge generated sources. On a read
+   *  error, the functions already appended are removed.
+   */
+  int appendSourceStream(const char* filename, std::size_t window = 1 << 20);
+
+  /** \brief Append many source files concurrently.
+   *  \param filenames -> Array of source filenames.
+   *  \param nfiles -> Number of elements in \a filenames.
+   *  \param threads -> Number of threads to use. If is 0 or
+   *          negative, one thread per cpu will be used.
+   *  \param errors -> Optional array of \a nfiles elements
+   *          that will store the #appendSource return value of
+   *          each file.
+   *  \return Return the number of appended files.
+   *
+   *  Files are read, cleared and extracted concurrently. Then,
+   *  the results are merged in the same order than \a filenames,
+   *  so the resulting map is the same obtained calling
+   *  #appendSource for each file.
+   */
+  int appendSources(const char** filenames, int nfiles, int threads = 0, int* errors = 0);
+
+  /** \brief Append all source files of a directory tree.
+   *  \param root -> Root directory.
+   *  \param options -> Files selection and threads options.
+   *  \param nfound -> Optional output with the number of accepted files.
+   *  \return Return the number of appended files.
+   *  \return Return -1 if \a root can't be opened.
+   *
+   *  Walk recursively the directory \a root and map all files accepted
+   *  by \a options. Found paths are sent to the mapping threads while the
+   *  tree is being walked, so traversal overlaps with parsing. Entries of
+   *  each directory are visited in alphabetical order and the results are
+   *  merged in that order, so the resulting map doesn't depend on timing.
+   */
+  int appendDirectory(const char* root, const crawl_options& options = crawl_options(), int* nfound = 0);
+
+  /** \brief Append all files of a compilation database.
+   *  \param filename -> Path of a "compile_commands.json" file.
+   *  \param threads -> Number of mapping threads. If is 0 or
+   *          negative, one thread per cpu will be used.
+   *  \param nfound -> Optional output with the number of different files listed.
+   *  \return Return the number of appended files.
+   *  \return Return -1 if \a filename can't be opened.
+   *  \return Return -2 if the database is malformed. Files listed
+   *          before the error are appended anyway.
+   *
+   *  The database is parsed in a single pass while the listed files
+   *  are mapped. Relative "file" entries are resolved from their
+   *  "directory" entry, and files compiled many times (with different
+   *  flags) are mapped only once.
+   */
+  int appendCompileCommands(const char* filename, int threads = 0, int* nfound = 0);
+
+  /** \brief Map again the modified files.
+   *  \param threads -> Number of mapping threads. If is 0 or
+   *          negative, one thread per cpu will be used.
+   *  \return Return the number of changed (modified or removed) files.
+   *
+   *  Check the fingerprint of each mapped file. Files with the same
+   *  size and modification time are skipped. Otherwise, the content
+   *  hash is compared and only files whose content has changed are
+   *  parsed again. The functions of changed files are replaced by the
+   *  new ones, and the functions of removed files are deleted.
+   */
+  int rescan(int threads = 0);
+
+  /** \brief Map again the specified files.
+   *  \param filenames -> Array of source filenames.
+   *  \param nfiles -> Number of elements in \a filenames.
+   *  \param threads -> Number of mapping threads. If is 0 or
+   *          negative, one thread per cpu will be used.
+   *  \return Return the number of changed (modified, removed or new) files.
+   *
+   *  Like #rescan, but only the specified files are checked and
+   *  their content hash is always compared. Not mapped files are
+   *  appended, and mapped files that can't be opened are removed.
+   */
+  int refresh(const char** filenames, int nfiles, int threads = 0);
+
+  /** \brief Remove the functions of a source file.
+   *  \param filename -> Source filename.
+   *  \return Return 0 on success.
+   *  \return Return -1 if the file is not mapped.
+   *
+   *  Remove the functions extracted from \a filename, their
+   *  references to names and namespaces, and the file fingerprint.
+   *  Functions are found with the positions stored for the file,
+   *  so the map is not scanned to find them. Graph links are built
+   *  from the remaining functions, so calls from the file disappear
+   *  too.
+   *
+   *  The functions are marked as removed like in #removeF, so the
+   *  following functions are not moved and the cost only depends
+   *  on the number of functions of the file. They are compacted
+   *  when the removed functions are more than the remaining ones,
+   *  or by #compact .
+   */
+  int removeSource(const char* filename);
+
+  /** \brief Map again a source file replacing its functions.
+   *  \param filename -> Source filename.
+   *  \return Return 0 on success.
+   *  \return Return -1 if file can't be opened. The map is not modified.
+   *  \return Return -3 if there are not any function definition
+   *          in specified source file. Previous functions are removed.
+   *
+   *  Parse \a filename (or take it from the cache) and replace the
+   *  functions extracted before from it. If the number of functions
+   *  doesn't change, the new functions take the positions of the old
+   *  ones and the rest of the map is not moved. Otherwise, the old
+   *  functions are removed and the new ones appended like in
+   *  #refresh. Not mapped files are appended. Unlike #refresh, the
+   *  file is parsed even if its content has not changed.
+   *
+   *  In both cases, the cost of replacing the functions only
+   *  depends on the size of the file: removed functions are
+   *  compacted later, like in #removeSource . When exchanged
+   *  functions leave names or namespaces without functions, removing
+   *  them is linear in the number of names and namespaces.
+   */
+  int replaceSource(const char* filename);
+
+  /// Return the number of mapped files
+  inline int numFiles() const {return nFiles;}
+  /// Return true if the file \a path is mapped
+  inline bool hasFile(const std::string& path) const {return fileIndex.count(path) > 0;}
+  /// Return the fingerprint of mapped file \a i or a null pointer if \a i is out of range.
+  inline const file_record* getFile(int i) const {return (i >= 0 && i < nFiles) ? &files[i] : 0;}
+
   /** \brief Convert stored information to string format.
    *  \param tabs -> Number of initial tabulations.
    *  \return Return a string containing formated information.
@@ -531,7 +2415,7 @@ class source_map
   std::string getNamespaceName(int) const;
   
   /** \brief Extract defined function name.
-   *  \param i -> Array #defFuncNames position.
+   *  \param i -> Position of the name, from 0 to #numFN (names in #removedNames are skipped).
    *
    *  \return Return specified namespace name.
    *          if \a i is out of range return a empty string.
@@ -547,28 +2431,81 @@ class source_map
    *  \return Return 0 on success.
    *  \return Return -1 if specified function doesn't exists
    *
-   *  Remove first #function_map that match with specified input
+   *  Remove all #function_map that match with specified input
    *  parameters from #functions array. If \a sourceFile is set to
    *  null pointer and/or \a overload is set to -1 the function don't
    *  worries about this respectives variables to make the match.
+   *
+   *  Only the functions with the specified name are visited. They
+   *  are marked as removed, their names and namespaces released and
+   *  the index keys that point to them moved, but the other functions
+   *  are not moved until the removed functions are more than the
+   *  remaining ones, or until #compact . Hence, the cost doesn't
+   *  depend on the size of the map, except when a namespace is left
+   *  without functions: removing it is linear in the number of
+   *  namespaces. Positions read by #getFunction and #getFName skip
+   *  the removed functions and names.
    *  
    */        
   int removeF(const char*, const char* = 0, int = -1);
 
+  /** \brief Remove many functions.
+   *  \param functionNames -> Array of function names.
+   *  \param n -> Number of elements in \a functionNames .
+   *  \param sourceFiles -> Optional array with the source filename of each
+   *          name. Null pointer elements match any source.
+   *  \param overloads -> Optional array with the overload of each name.
+   *          Values less than 1 match any overload.
+   *
+   *  \return Return the number of removed functions.
+   *
+   *  Same as calling #removeF for each name.
+   */
+  int removeFunctions(const char** functionNames, int n, const char** sourceFiles = 0, const int* overloads = 0);
+
   /** \brief Remove specified #function_map.
    *  \param i -> Array  position.
    *
    *  \return Return 0 on success.
    *  \return Return -1 if \a i is out of range
    *
-   *  Remove the element \a i of array #functions.
+   *  Remove the function returned by #getFunction with the
+   *  position \a i, like #removeF with a name.
    */          
   int removeF(int);
 
-  /// Updates used namespaces and defined function names.
+  /** \brief Compact the removed functions
+   *
+   *  Functions removed by #removeF, #removeSource and
+   *  #replaceSource are only marked, and compacted when they are
+   *  more than the remaining ones. This function moves the remaining
+   *  functions and names now, so the map doesn't keep the removed
+   *  ones. Pointers returned by #getFunction before are not valid
+   *  after the call. Reads never compact the map.
+   */
+  void compact();
+
+  /** \brief Build again used namespaces and defined function names.
+   *
+   *  Names and namespace maps are updated incrementally when functions
+   *  are appended or removed, so this function is not needed to keep
+   *  the map consistent.
+   */
   void update();
 
-  /// Free allocated memory and set all varaibles to default values
+  /** \brief Check the consistency of names and namespaces.
+   *  \return Return 0 if the map is consistent.
+   *  \return Return the number of differences otherwise.
+   *
+   *  Compare the defined function names and the references of the
+   *  namespace maps with the ones that #update would build, and
+   *  check that each function is in the range of its file. Maps
+   *  compiled with __CODE_MAP_DEBUG__ are checked after each
+   *  append and removal.
+   */
+  int checkMaps() const;
+
+  /// Free allocated memory and set all varaibles to default values. Interned names are kept (see #symbol::reset)
   void clear();
 
   /** \brief Get specified #function_map pointer from #functions array.
@@ -581,7 +2518,8 @@ class source_map
    *
    *  If \a sourceFile is a null pointer and/or \a overload is < 0, the 
    *  respectively variables are ignored to perform the match. The pointer
-   *  to the first matching element will be returned.
+   *  to the first matching element will be returned. The search uses
+   *  the function indexes, so takes constant expected time.
    */         
   const function_map* getFunction(const char*, const char* = 0, int = -1) const;
 
@@ -591,6 +2529,9 @@ class source_map
    *  \return Return null pointer if \a i is out of range.
    *  \return Return constant pointer to specified #function_map in #functions array
    *
+   *  Positions only count the functions that have not been removed,
+   *  so they are the ones of the compacted map (see #compact). The
+   *  map is not modified.
    */           
   const function_map* getFunction(int) const;
 
@@ -625,21 +2566,79 @@ class source_map
    *
    *
    *  Find all functions that uses all specified namespaces and store the corresponding
-   *  function names in string array \a outF.
+   *  function names in string array \a outF, sorted alphabetically.
    *
    */           
   int filterFunctions(const char**, const int, std::string*, int&) const;
 
+  /** \brief Select the functions that uses all specified namespaces (AND).
+   *  \param namesNS -> Array with namespace names.
+   *  \param nNS -> Number of specified namespaces.
+   *  \param selected -> Output: ids of the names of the selected functions.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -2 if some namespace doesn't exists. \a selected will be empty.
+   *
+   *  The selection can be refined with #excludeFunctions and
+   *  converted to names with #selectedNames.
+   */
+  int filterFunctions(const char**, const int, id_bitmap&) const;
+
+  /** \brief Select the functions that uses some specified namespace (OR).
+   *  \param namesNS -> Array with namespace names.
+   *  \param nNS -> Number of specified namespaces.
+   *  \param selected -> Output: ids of the names of the selected functions.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -2 if some namespace doesn't exists. Other namespaces are selected.
+   */
+  int filterAnyFunctions(const char**, const int, id_bitmap&) const;
+
+  /** \brief Remove the functions that uses some specified namespace (AND-NOT).
+   *  \param namesNS -> Array with namespace names.
+   *  \param nNS -> Number of specified namespaces.
+   *  \param selected -> Input/Output: ids of the names of the selected functions.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -2 if some namespace doesn't exists. Other namespaces are removed.
+   */
+  int excludeFunctions(const char**, const int, id_bitmap&) const;
+
+  /** \brief Extract the names of selected functions.
+   *  \param selected -> Ids of the function names, as returned by #filterFunctions.
+   *  \param outF -> String array where names will be stored, sorted alphabetically.
+   *  \param nF -> Input : Maximum number of elements that fit in \a outF
+   *               Output: Number of stored names.
+   *
+   *  \return Return 0 on success.
+   *  \return Return -1 if there are more selected functions than specified \a nF value.
+   */
+  int selectedNames(const id_bitmap&, std::string*, int&) const;
+
   
   /// Sort #namespaces and #fcall elements alphabetically
   void sort();
 
   /// Return number of namespaces (#nNamespaces)
   inline int numNS() const {return nNamespaces;}
-  /// Return number of defined function names (#nFnames)
-  inline int numFN() const {return nFnames;}
-  /// Return number of defined functions (#nFunctions)
-  inline int numF() const {return nFunctions;}
+  /// Return number of defined function names (#nFnames without the ones marked in #removedNames)
+  inline int numFN() const {return nFnames - (int) removedNames.size();}
+  /// Return number of defined functions (#nFunctions without the ones marked in #removedF)
+  inline int numF() const {return nFunctions - (int) removedF.size();}
+  /** \brief Use a cache of parsed files
+   *  \param pcache -> Opened cache or null pointer to disable it.
+   *
+   *  Files loaded after this call take their functions from
+   *  \a pcache when the same content has been parsed before.
+   *  The cache is not owned and must exist while it is used.
+   */
+  inline void setCache(parse_cache* pcache) {cache = pcache;}
+  /// Return the cache of parsed files or a null pointer
+  inline parse_cache* getCache() const {return cache;}
+  /// Return ingestion throughput counters (#stats)
+  inline const ingest_stats& getStats() const {return stats;}
+  /// Return the memory reserved by the arena of the map in bytes
+  inline std::size_t arenaBytes() const {return pool.bytes();}
 
   /** \brief Create a dependence function tree.
    *  \param nleafs -> Number of output #leaf in \a tree.
@@ -650,15 +2649,238 @@ class source_map
    *
    *  Fill \a tree array with connected #leaf according to
    *  called functions in each defined function. Called functions
-   *  that are not defined will be ignored in the tree.
+   *  that are not defined will be ignored in the tree. The links
+   *  are taken from #graph.
    */             
   int tree(int&, leaf*&) const;
 
+  /** \brief Create a dependence function graph.
+   *  \param g -> Output graph.
+   *
+   *  \return Return the number of nodes on succes.
+   *  \return Return -1 if map has not any defined function
+   *
+   *  Same links as #tree, stored in a #dep_graph. Each function
+   *  is linked to all defined functions (all overloads) with the
+   *  name of each called function, except itself. The weight of
+   *  each link is the number of calls. Called functions are found
+   *  by name id, so the graph is built in linear time.
+   */
+  int graph(dep_graph& g) const;
+
   /// Destructor
   ~source_map();
   
 };
 
+/**
+ * \struct watch_update
+ * \ingroup code-parser
+ *
+ * Summary and latency of one batch update
+ * applied by a #source_watch .
+ *
+ */
+
+struct watch_update
+{
+  /// Number of coalesced file system events.
+  int events;
+  /// Number of different files checked.
+  int files;
+  /// Number of changed (modified, removed or new) files.
+  int changed;
+  /// Time from the first event to the start of the update (seconds).
+  double wait;
+  /// Time spent updating the map (seconds).
+  double updateTime;
+  /// Time from the first event to the updated map (seconds).
+  double latency;
+
+  /// Constructor
+  watch_update();
+  /// Set all values to zero.
+  void clear();
+};
+
+/**
+ * \class source_watch
+ * \ingroup code-parser
+ *
+ * Keeps a #source_map updated using inotify. The
+ * directories of the mapped files are watched and,
+ * when a mapped file is modified, created, removed or
+ * renamed, only that file is mapped again. Events are
+ * coalesced until no more events arrive during a quiet
+ * period, so a burst of events (an editor save, a
+ * checkout...) produces a single batch update.
+ */
+
+class source_watch
+{
+ protected:
+  /// Watched directory.
+  struct watch_dir
+  {
+    /// Directory path as it appears in mapped paths ("" for the working directory).
+    std::string path;
+    /// Path relative to the watched root.
+    std::string rel;
+    /// Position in #roots of the watched root. -1 if the directory only contains mapped files.
+    int root;
+    /// True if the directory has been renamed inside a watched tree and its IN_MOVE_SELF event is pending.
+    bool moved;
+  };
+
+  /// Updated map.
+  source_map* map;
+  /// Inotify file descriptor. -1 if the watch is not started.
+  int fd;
+  /// Watched directories by watch descriptor.
+  std::unordered_map<int,watch_dir> dirs;
+  /// Watched roots and their file selection options.
+  std::vector< std::pair<std::string,crawl_options> > roots;
+  /// Files pending to be checked.
+  std::set<std::string> pending;
+  /// Previous path of the renamed directories by event cookie, until the IN_MOVED_TO event arrives.
+  std::unordered_map<unsigned int,std::string> movedDirs;
+  /// Number of coalesced events pending to be applied.
+  int nevents;
+  /// Time of the first pending event.
+  double firstEvent;
+  /// True if the kernel event queue has overflowed.
+  bool overflow;
+  /// Seconds without events required to apply pending changes.
+  double quiet;
+  /// Maximum seconds that pending changes can be delayed.
+  double maxDelay;
+
+  /// Number of applied updates.
+  unsigned long updates;
+  /// Accumulated latency of applied updates (seconds).
+  double totalLatency;
+  /// Maximum latency of applied updates (seconds).
+  double maxLatency;
+
+  /** \brief Watch a directory
+   *  \param path -> Directory path.
+   *  \param rel -> Path relative to watched root.
+   *  \param root -> Position in #roots or -1.
+   *  \return Return the watch descriptor on success.
+   *  \return Return -1 on error.
+   */
+  int watchDir(const std::string& path, const std::string& rel, int root);
+
+  /** \brief Watch a directory tree
+   *  \param path -> Directory path.
+   *  \param rel -> Path relative to watched root.
+   *  \param root -> Position in #roots .
+   *  \param addFiles -> If is true, accepted files are set as pending.
+   *  \return Return the number of watched directories.
+   */
+  int watchTree(const std::string& path, const std::string& rel, int root, bool addFiles);
+
+  /// Set as pending all mapped files inside directory \a path . Return the number of files.
+  int pendingDir(const std::string& path);
+
+  /** \brief Update the watched directories of a renamed directory
+   *  \param from -> Previous directory path.
+   *  \param to -> New directory path.
+   *  \param rel -> New path relative to the watched root.
+   *  \return Return the watch descriptor of the renamed directory or -1 if it is not watched.
+   *
+   *  The paths of the directory and its watched subdirectories
+   *  are rewritten with the new prefix.
+   */
+  int renameDir(const std::string& from, const std::string& to, const std::string& rel);
+
+  /// Remove the watches of directory \a path and its watched subdirectories.
+  void unwatchDir(const std::string& path);
+
+  /** \brief Read and coalesce available events
+   *  \return Return the number of relevant events read.
+   *  \return Return -1 on read error.
+   */
+  int readEvents();
+
+  /** \brief Apply pending changes to the map
+   *  \param info -> Optional output with the update summary.
+   */
+  void apply(watch_update* info);
+
+  /// Copy is not allowed
+  source_watch(const source_watch&);
+  /// Assign is not allowed
+  source_watch& operator=(const source_watch&);
+  
+ public:
+  /// Number of mapping threads. If is 0 or negative, one thread per cpu will be used.
+  int threads;
+
+  /// Constructor
+  source_watch();
+
+  /** \brief Start watching a map
+   *  \param map -> Map to keep updated. Must exist while the watch is started.
+   *  \param quiet -> Seconds without events required to apply pending changes.
+   *  \param maxDelay -> Maximum seconds that pending changes can be
+   *          delayed by a continuous flow of events.
+   *  \return Return the number of watched directories on success.
+   *  \return Return -1 if inotify can't be initialized.
+   *
+   *  Watch the directories of all files mapped in \a map. A previous
+   *  watch is stopped.
+   */
+  int start(source_map& map, double quiet = 0.05, double maxDelay = 1.0);
+
+  /** \brief Watch a directory tree
+   *  \param root -> Root directory.
+   *  \param options -> Files selection options.
+   *  \return Return the number of watched directories.
+   *  \return Return -1 if the watch is not started.
+   *  \return Return -2 if \a root can't be watched.
+   *
+   *  Watch all not excluded directories of \a root, as
+   *  #source_map::appendDirectory walks them. Then, new files
+   *  and directories created in the tree are mapped too.
+   */
+  int addDirectory(const char* root, const crawl_options& options = crawl_options());
+
+  /** \brief Wait for changes and update the map
+   *  \param timeout -> Maximum milliseconds to wait for the first
+   *          event. If is negative, wait indefinitely.
+   *  \param info -> Optional output with the update summary.
+   *  \return Return 1 if an update has been applied.
+   *  \return Return 0 if no relevant event arrived before \a timeout.
+   *  \return Return -1 if the watch is not started.
+   *  \return Return -2 if an error occurs reading the events.
+   *
+   *  When the first relevant event arrives, events are coalesced until
+   *  no event arrives during the quiet period, or the maximum delay is
+   *  reached. Then, the affected files are mapped again (see
+   *  #source_map::refresh). If the kernel event queue overflows, the
+   *  whole map is checked with #source_map::rescan .
+   */
+  int poll(int timeout, watch_update* info = 0);
+
+  /// Stop watching and release the inotify descriptor
+  void stop();
+
+  /// Return true if the watch is started
+  inline bool started() const {return fd >= 0;}
+  /// Return the number of watched directories
+  inline int numDirs() const {return (int) dirs.size();}
+  /// Return the number of applied updates
+  inline unsigned long numUpdates() const {return updates;}
+  /// Return the mean latency of applied updates (seconds)
+  inline double meanLatency() const {return updates > 0 ? totalLatency/updates : 0.0;}
+  /// Return the maximum latency of applied updates (seconds)
+  inline double maxUpdateLatency() const {return maxLatency;}
+
+  /// Destructor
+  ~source_watch();
+};
+
 /// Return true if input string has only blank chars. Return false otherwise.
 bool blankString(const char* string);
 
@@ -677,6 +2899,51 @@ bool blankString(const char* string);
  */             
 int inRange(char c);
 
+/// Character classes stored in #charClassTable
+enum charClasses
+  {
+    CHAR_RANGE    = 0x0007, ///< Mask of the identifier range returned by #inRange
+    CHAR_ID_START = 0x0008, ///< Can start an identifier (letters and '_')
+    CHAR_ID       = 0x0010, ///< Can continue an identifier (letters, numbers and '_')
+    CHAR_BLANK    = 0x0020, ///< ' ' and '\t', as isblank
+    CHAR_NEWLINE  = 0x0040, ///< '\n'
+    CHAR_SPACE    = 0x0080, ///< Any white space, as isspace
+    CHAR_BRACKET  = 0x0100, ///< '(', ')', '[', ']', '{' and '}'
+    CHAR_QUOTE    = 0x0200, ///< '"' and '\''
+    CHAR_SLASH    = 0x0400  ///< '/', can open a comment
+  };
+
+/// Classes (see #charClasses) of each character, indexed by its unsigned value
+extern const unsigned short charClassTable[256];
+
+/// Return the classes (see #charClasses) of character \a c
+inline unsigned short charClass(char c){return charClassTable[(unsigned char) c];}
+
+/** \brief Count the identifier characters before a position
+ *  \param p -> Input text.
+ *  \param pos -> Position after the last character to check.
+ *
+ *  \return Return the number of consecutive identifier characters
+ *          (see #inRange) that precede position \a pos.
+ *
+ *  The backward scan never reads before \a p. Uses 16 bytes per
+ *  iteration when the #scanCode kernel is, at least, #SCAN_SSE2.
+ */
+std::size_t identifierRun(const char* p, std::size_t pos);
+
+/// Return a monotonic clock time in seconds.
+double wallTime();
+
+/** \brief Hash a text
+ *  \param data -> Input text.
+ *  \param length -> Number of characters in \a data.
+ *
+ *  \return Return a 64 bit hash of \a data.
+ *
+ *  Fast non cryptographic hash used to detect content changes.
+ */
+unsigned long long contentHash(const char* data, std::size_t length);
+
 /** \brief Store file plain text
  *  \param filename -> File filename to read.
  *  \param store -> Outpu string.
@@ -685,7 +2952,9 @@ int inRange(char c);
  *  \return Return -1 if can't open file.
  *
  *  Reads the file specified by \a filename and store
- *  the corresponding plain text in \a store.
+ *  the corresponding plain text in \a store. Files are
+ *  read, not mapped, so a file truncated while it is read
+ *  gives shorter contents.
  */
 int readFile(const char* filename, std::string& store);
 
@@ -726,6 +2995,61 @@ int removeText(std::string& inS, std::size_t pos, const char* limit, bool eraseL
  */
 int clearCode(std::string& inS);
 
+/** \brief Copy code without strings nor comments
+ *  \param inS -> Input source code plain text.
+ *  \param length -> Number of characters in \a inS.
+ *  \param out -> Output cleared code.
+ *
+ *  \return Return the number of removed text segments on success.
+ *  \return Return -1 if some string delimited by "" are  not closed.
+ *  \return Return -2 if some string delimited by '' are  not closed.
+ *  \return Return -3 if some string delimited by // are  not closed.
+ *  \return Return -4 if some string delimited by / * * / are  not closed.
+ *
+ *  Single pass version of #clearCode. Copy \a inS to \a out skipping
+ *  hard code strings and comments. The result is the same than
+ *  #clearCode but the input text is not modified and the time is
+ *  linear with \a length. On not closed segments, \a out stores
+ *  the code until the segment opening.
+ */
+int clearCode(const char* inS, std::size_t length, std::string& out);
+
+/// Kernels available to #scanCode
+enum scanKernels
+  {
+    SCAN_SCALAR = 0, ///< Byte per byte scan
+    SCAN_SSE2   = 1, ///< 16 bytes per iteration (x86 baseline)
+    SCAN_AVX2   = 2, ///< 32 bytes per iteration
+    SCAN_AVX512 = 3  ///< 64 bytes per iteration
+  };
+
+/** \brief Find next possible string or comment opening.
+ *  \param p -> Input text.
+ *  \param n -> Number of characters in \a p.
+ *
+ *  \return Return the position of the first '"', '\'' or '/' character in \a p.
+ *  \return Return \a n if there is no such character.
+ *
+ *  Used by #clearCode to copy code runs at once. The scan uses
+ *  the vector kernel selected with #setScanKernel. By default,
+ *  the best kernel supported by the cpu is used.
+ */
+std::size_t scanCode(const char* p, std::size_t n);
+
+/** \brief Select the #scanCode kernel.
+ *  \param level -> Kernel to use (see #scanKernels). Negative values select the best one.
+ *
+ *  \return Return the selected kernel. If \a level is not supported
+ *          by the cpu, the best supported kernel is selected.
+ */
+int setScanKernel(int level);
+
+/// Return the kernel used by #scanCode
+int getScanKernel();
+
+/// Return the name of specified #scanCode kernel
+const char* scanKernelName(int level);
+
 
 /** \brief Extract and mark defined functions
  *  \param inS -> Input string with source code plain text without any hard code string or comment.
@@ -740,11 +3064,33 @@ int clearCode(std::string& inS);
  *
  *  Also, mark defined functions in input string \a inS. Then, this string 
  *  can be used as input for other functions in this library. \a pnames will
- *  be allocated to store data.
+ *  be allocated to store data. All marks are inserted at once when the 
+ *  extraction has finished.
  *
  */
 int definedFunc(std::string& inS, std::string*& pnames);
 
+/** \brief Extract defined functions and their locations
+ *  \param inS -> Input string with source code plain text without any hard code string or comment.
+ *  \param keys -> #key_map of \a inS.
+ *  \param pnames -> Output array of strings with defined functions names.
+ *  \param spans -> Output array of #function_span with the location of each definition.
+ *  \param nspans -> Number of elements stored in \a spans.
+ *  \param ending -> Optional output. Set to 1 if the scan has stopped at a
+ *         body preceded by a '(' without identifier, so the rest of \a inS
+ *         has not been scanned. Set to 2 if the last ')' is not followed by
+ *         any '{' nor ';', so a body could follow \a inS . Set to 0 otherwise.
+ *
+ *  \return Return number of extracted function names.
+ *
+ *  Same as previous function, but \a inS is not modified. Instead, each
+ *  definition is stored in \a spans, in source order, with the position
+ *  of his name in \a pnames, his overload and the positions of his body
+ *  keys. \a pnames and \a spans will be allocated to store data.
+ *
+ */
+int definedFunc(const std::string& inS, const key_map& keys, std::string*& pnames, function_span*& spans, int& nspans, int* ending = 0);
+
 /** \brief Obtain position of corresponding closing key.
  *
  *  \param inS -> Input string.
@@ -756,12 +3102,13 @@ int definedFunc(std::string& inS, std::string*& pnames);
  *  \return Return std::string::npos if no open key has been found for specified close key
  *
  *  Find the corresponding close (open) key for the open (close) key in position \a init.
- *  Return his position or std::string::npos if can't found that key.
+ *  Return his position or std::string::npos if can't found that key. The text is scanned
+ *  on each call, use a #key_map to perform many queries on the same text.
  */
-std::size_t closeKey(std::string& inS, std::size_t init);
+std::size_t closeKey(const std::string& inS, std::size_t init);
 
 /// Return true if input string is an statment (if,else,for...)
-bool checkStatment(std::string& string);
+bool checkStatment(const std::string& string);
 
 /** \brief Find specified name in a strings array.
  *
@@ -774,12 +3121,27 @@ bool checkStatment(std::string& string);
  */
 int nameMatch(std::string* sarray, int dim, const char* name);
 
+/** \brief Find specified symbol in a symbols array.
+ *
+ *  \param sarray -> Array of symbols.
+ *  \param dim -> \a sarray dimension.
+ *  \param name -> Symbol to find.
+ *
+ *  \return Return the position of element in \a sarray that match with \a name.
+ *  \return Return -1 if no element match with \a name. 
+ *
+ *  Symbols are compared by id.
+ */
+int nameMatch(const symbol* sarray, int dim, const symbol& name);
+
 /** \brief Find next called function.
  *
  *  \param inS -> Input code string.
  *  \param init -> Initial position.
  *  \param name -> Found function name.
  *  \param begin -> function beginning.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
+ *  \param end -> Optional end of the searched text.
  *
  *  \return Parameter \a begin will be filled with the position of
  *          the first identifier name character of the extracted function.
@@ -792,9 +3154,11 @@ int nameMatch(std::string* sarray, int dim, const char* name);
  *  Extract the first character position of function identifier and store it
  *  in \a begin and return the corresponding function close key ')'. On no
  *  function found or no close key found, the function return a std::string::npos.
+ *  If \a end is specified, the text from \a end is ignored, as if \a inS
+ *  finished there.
  *
  */
-std::size_t extractFunction(std::string& inS, std::size_t init, std::string& name, std::size_t& begin);
+std::size_t extractFunction(const std::string& inS, std::size_t init, std::string& name, std::size_t& begin, const key_map* keys = 0, std::size_t end = std::string::npos);
 
 /** \brief Extract all called functions in the specified defined function.
  *
@@ -802,6 +3166,7 @@ std::size_t extractFunction(std::string& inS, std::size_t init, std::string& nam
  *  \param fcalls -> Pointer of #fcall elements that will store function calls.
  *  \param fname  -> Defined function name.
  *  \param overload -> Overload value for defined function to extract.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
  *
  *  \return Return -1 if founction not found.
  *  \return Return -2 if no marks exist in \a inS.
@@ -813,7 +3178,7 @@ std::size_t extractFunction(std::string& inS, std::size_t init, std::string& nam
  *  to ensure that. \a fcalls will be allocated to store data.
  *
  */
-int calledFunc(std::string& inS, fcall*& fcalls, const char* fname, int overload = 1);
+int calledFunc(const std::string& inS, fcall*& fcalls, const char* fname, int overload = 1, const key_map* keys = 0);
 
 /** \brief Extract all called functions in the specified defined function.
  *
@@ -822,6 +3187,7 @@ int calledFunc(std::string& inS, fcall*& fcalls, const char* fname, int overload
  *  \param counts -> Pointer that will store the number of times each function has been called.
  *  \param fname  -> Defined function name.
  *  \param overload -> Overload value for defined function to extract.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
  *
  *  \return Return -1 if founction not found.
  *  \return Return -2 if no marks exist in \a inS.
@@ -834,13 +3200,66 @@ int calledFunc(std::string& inS, fcall*& fcalls, const char* fname, int overload
  *  data.
  *
  */
-int calledFunc(std::string& inS, std::string*& pnames, int*& counts, const char* fname, int overload = 1);
+int calledFunc(const std::string& inS, std::string*& pnames, int*& counts, const char* fname, int overload = 1, const key_map* keys = 0);
+
+/** \brief Extract all called functions in the specified parsed function.
+ *
+ *  \param src -> Parsed source.
+ *  \param fcalls -> Pointer of #fcall elements that will store function calls.
+ *  \param fname  -> Defined function name.
+ *  \param overload -> Overload value for defined function to extract.
+ *
+ *  \return Return -1 if founction not found.
+ *  \return Return number of extracted functions on success.
+ *
+ *  Same as previous functions, but the function is located by
+ *  the span index of \a src and the source text is not scanned
+ *  out of function body.
+ *
+ */
+int calledFunc(const parsed_source& src, fcall*& fcalls, const char* fname, int overload = 1);
+
+/** \brief Extract all called functions in a function body.
+ *
+ *  \param inS -> Input code in plain text
+ *  \param fcalls -> Pointer of #fcall elements that will store function calls.
+ *  \param open -> Position of body open key '{'.
+ *  \param close -> Position of body close key '}'.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
+ *
+ *  \return Return number of extracted functions.
+ *
+ *  Same as #calledFunc, but the body is specified by his
+ *  key positions, so \a inS has not to be marked. \a fcalls
+ *  will be allocated only if some function has been found.
+ *
+ */
+int bodyCalls(const std::string& inS, fcall*& fcalls, std::size_t open, std::size_t close, const key_map* keys = 0);
+
+/** \brief Extract all called functions in a function body.
+ *
+ *  \param inS -> Input code in plain text
+ *  \param pnames -> Pointer that will store called function names
+ *  \param counts -> Pointer that will store the number of times each function has been called.
+ *  \param open -> Position of body open key '{'.
+ *  \param close -> Position of body close key '}'.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
+ *
+ *  \return Return number of extracted functions.
+ *
+ *  Same as #calledFunc, but the body is specified by his
+ *  key positions. \a pnames and \a counts will be allocated
+ *  to store data.
+ *
+ */
+int bodyCalls(const std::string& inS, std::string*& pnames, int*& counts, std::size_t open, std::size_t close, const key_map* keys = 0);
 
 /** \brief Find the position of specified defined function.  
  *
  *  \param inS -> Input code in plain text.
  *  \param name -> Defined function name.
  *  \param overload -> Overload value of defined function.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
  *
  *  \return Return position of character '{' that marks the 
  *          beginning of function definition.
@@ -852,7 +3271,7 @@ int calledFunc(std::string& inS, std::string*& pnames, int*& counts, const char*
  *  Use functions #clearCode and #definedFunc to ensure that.
  *
  */
-std::size_t posDefinedFunc(std::string& inS, const char* name, int overload = 1);
+std::size_t posDefinedFunc(const std::string& inS, const char* name, int overload = 1, const key_map* keys = 0);
 
 /** \brief Extract used namespace names in defined function.  
  *
@@ -860,6 +3279,7 @@ std::size_t posDefinedFunc(std::string& inS, const char* name, int overload = 1)
  *  \param pnames -> Pointer that will store used namespace names.
  *  \param fname -> Defined function name.
  *  \param overload -> Overload value of defined function.
+ *  \param keys -> Optional #key_map of \a inS used to find matching keys.
  *
  *  \return Return number of extracted namespaces on success.
  *  \return Return -1 if function not found.
@@ -872,7 +3292,74 @@ std::size_t posDefinedFunc(std::string& inS, const char* name, int overload = 1)
  *  Use functions #clearCode and #definedFunc to ensure that.
  *
  */
-int usedNamespaces(std::string& inS, std::string*& pnames, const char* fname, int overload = 1);
+int usedNamespaces(const std::string& inS, std::string*& pnames, const char* fname, int overload = 1, const key_map* keys = 0);
+
+/** \brief Extract used namespace names in parsed function.  
+ *
+ *  \param src -> Parsed source.
+ *  \param pnames -> Pointer that will store used namespace names.
+ *  \param fname -> Defined function name.
+ *  \param overload -> Overload value of defined function.
+ *
+ *  \return Return number of extracted namespaces on success.
+ *  \return Return -1 if function not found.
+ *
+ *  Same as previous function, but the function is located by
+ *  the span index of \a src.
+ *
+ */
+int usedNamespaces(const parsed_source& src, std::string*& pnames, const char* fname, int overload = 1);
+
+/** \brief Extract used namespace names in a function body.  
+ *
+ *  \param inS -> Input code in plain text.
+ *  \param pnames -> Pointer that will store used namespace names.
+ *  \param open -> Position of body open key '{'.
+ *  \param close -> Position of body close key '}'.
+ *
+ *  \return Return number of extracted namespaces.
+ *
+ *  Same as #usedNamespaces, but the body is specified by his
+ *  key positions, so \a inS has not to be marked. \a pnames
+ *  will be allocated only if some namespace has been found.
+ *
+ */
+int bodyNamespaces(const std::string& inS, std::string*& pnames, std::size_t open, std::size_t close);
+
+/** \brief Extract used namespaces and called functions in a function body.
+ *
+ *  \param inS -> Input code in plain text.
+ *  \param open -> Position of body open key '{'.
+ *  \param close -> Position of body close key '}'.
+ *  \param pnamespaces -> Pointer that will store used namespace names.
+ *  \param nNamespaces -> Number of elements stored in \a pnamespaces.
+ *  \param fcalls -> Pointer of #fcall elements that will store function calls.
+ *  \param nCalls -> Number of elements stored in \a fcalls.
+ *  \param pool -> Arena where \a pnamespaces and \a fcalls will be allocated, or null pointer to use new.
+ *
+ *  \return Return 0 on success.
+ *
+ *  Scan once the body between \a open and \a close and extract the
+ *  same namespaces than #bodyNamespaces and the same calls than #bodyCalls.
+ *  The text out of the body is never scanned, so the cost depends only
+ *  on the body length. \a pnamespaces and \a fcalls will be allocated
+ *  only if some element has been found, with the exact size.
+ *
+ */
+int scanBody(const std::string& inS, std::size_t open, std::size_t close, symbol*& pnamespaces, int& nNamespaces, fcall*& fcalls, int& nCalls, arena* pool = 0);
+
+/** \brief Find the identifier before a '('.
+ *
+ *  \param inS -> Input code in plain text.
+ *  \param posPar -> Position of '('.
+ *  \param begin -> First position of the identifier.
+ *
+ *  \return Return the number of identifier characters (0 if there is no identifier).
+ *
+ *  Blanks between the identifier and '(' are skipped and
+ *  one "::" is allowed inside the identifier.
+ */
+std::size_t identifierBefore(const std::string& inS, std::size_t posPar, std::size_t& begin);
 
 /** \brief Find next used namespace 
  *
@@ -888,7 +3375,7 @@ int usedNamespaces(std::string& inS, std::string*& pnames, const char* fname, in
  *  From position \a init in \a inS string, find the next use of a namespace. This use can
  *  be a "using namespace" statment or a "namespace_identifier::variable" form.
  */
-std::size_t extractNamespace(std::string& inS, std::size_t init, std::string& name, std::size_t& begin);
+std::size_t extractNamespace(const std::string& inS, std::size_t init, std::string& name, std::size_t& begin);
 
 /// Return true if string \a a is alphabetically previous to \a b and false otherwise.
 bool stringOrder(const std::string& a, const std::string& b);
@@ -912,4 +3399,18 @@ bool stringOrderInv(const std::string& a, const std::string& b);
  */
 int tree2dot(leaf* tree, int nleafs, const char* filename, unsigned int nprop = 0, const char** prop = NULL);
 
+/** \brief Extract a "dot" format file from input dependence graph
+ *  
+ *  \param g -> Dependence graph.
+ *  \param filename -> Output file filename.
+ *  \param nprop -> Number of "dot" properties
+ *  \param prop -> Array of strings where each element is a dot property.
+ *
+ *  \return Return 0 on success.
+ *  \return Return -1 if can't open output file.
+ *
+ *  Same as #tree2dot for a #dep_graph.
+ */
+int graph2dot(const dep_graph& g, const char* filename, unsigned int nprop = 0, const char** prop = NULL);
+
 #endif